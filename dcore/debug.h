@@ -1,7 +1,10 @@
 #ifndef DCORE_DEBUG_H
 #define DCORE_DEBUG_H
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h> // size_t, can't include dcore/common.h since it includes this header.
-#include <stdio.h>  // FILE*
+#include <stdint.h>
+#include <stdio.h> // FILE*
 
 void dcdInit();
 void dcdDeInit();
@@ -15,6 +18,30 @@ typedef enum DCdMsgType {
 	DCD_MSG_TYPE_SUCCESS,
 } DCdMsgType;
 
+/** severity of the message types, success messages are as important as info messages. */
+#define DCD_LEVEL_DEBUG 0
+#define DCD_LEVEL_INFO 1
+#define DCD_LEVEL_SUCCESS 1
+#define DCD_LEVEL_WARNING 2
+#define DCD_LEVEL_ERROR 3
+#define DCD_LEVEL_FATAL 4
+
+/** messages below this level are compiled out, fatal messages never are. define it before including this header to change it. */
+#ifndef DCD_MIN_LEVEL
+#	if defined(DC_DEBUG)
+#		define DCD_MIN_LEVEL DCD_LEVEL_DEBUG
+#	else
+#		define DCD_MIN_LEVEL DCD_LEVEL_INFO
+#	endif
+#endif
+
+/** masks select message types at runtime, one bit per DCdMsgType. */
+#define DCD_MSG_MASK(T) (1u << DCD_MSG_TYPE_##T)
+#define DCD_MSG_MASK_ALL 0x3fu
+
+/** returns the mask of the message types at or above a level. */
+unsigned int dcdGetLevelMask(int level);
+
 typedef struct DCdMsgStats {
 	size_t total;
 	unsigned int debug;
@@ -28,14 +55,22 @@ typedef struct DCdMsgStats {
 typedef struct DCdContext {
 	const char *name;
 	DCdMsgStats stats;
+	unsigned int mask; // messages of other types are ignored (not counted either), fatal messages never are. inherited by pushed contexts.
+	bool profile;      // zones are recorded in this context, and contexts pushed on it are zones themselves. inherited as well.
 } DCdContext;
 
+/** returns the messages counted by all threads, including the threads that exited. filtered messages aren't counted. */
+DCdMsgStats dcdGetMsgStats();
+
 typedef void (*DCdFatalHandler)();
 
 void dcdSetFatalHandler(DCdFatalHandler handler);
 DCdFatalHandler dcdGetFatalHandler();
 
-/** returns context from the stack top. @note there always is a context. */
+/**
+ * returns context from the stack top of the calling thread. @note there always is a context, threads start with a
+ * root context named like the one of dcdInit.
+ **/
 DCdContext *dcdGetCurrentContext();
 
 /** creates new context on top of the stack. @see dcdPushContextQuiet */
@@ -55,18 +90,198 @@ size_t dcdPopContext(const char *file, const char *func, int line);
 size_t dcdPopContextQuiet();
 
 void dcdMsgF(DCdMsgType type, const char *file, const char *func, int line, const char *fmt, ...);
+void dcdMsgV(DCdMsgType type, const char *file, const char *func, int line, const char *fmt, va_list va);
+
+/** a place that sends messages, registered in the binary log once instead of being written with every message. */
+typedef struct DCdCallsite {
+	const char *file, *func, *fmt;
+	int line;
+	_Atomic uint32_t id, generation;
+} DCdCallsite;
+
+/** sends a message from a callsite, see DCD_EMSGF. */
+void dcdMsgC(DCdCallsite *callsite, DCdMsgType type, ...);
+
+/** longer messages are cut off in asynchronous mode. */
+#define DCD_ASYNC_MESSAGE_SIZE 256
+
+/** what happens to messages when the ring of the logging thread is full. */
+typedef enum DCdAsyncPolicy {
+	DCD_ASYNC_POLICY_DROP,  // the message is dropped and counted, see dcdGetDroppedMessages.
+	DCD_ASYNC_POLICY_BLOCK, // the sending thread waits for a free slot.
+} DCdAsyncPolicy;
+
+/**
+ * makes logging asynchronous. messages are formatted by the sending thread into a lock-free ring and written to the
+ * sinks by a logging thread, so sending doesn't wait for I/O. fatal messages are never dropped and are flushed
+ * before the fatal handler runs.
+ * @param capacity number of messages the ring holds, rounded up to a power of two.
+ **/
+void dcdStartAsync(size_t capacity, DCdAsyncPolicy policy);
+
+/** writes the queued messages, stops the logging thread and makes logging synchronous again. other threads must not log meanwhile. */
+void dcdStopAsync();
+
+/**
+ * waits until every message sent before is written and flushes the sinks. of the binary sink, only the records of the
+ * calling thread are written, the buffers of other threads are filled without a lock and written by their threads.
+ **/
+void dcdFlush();
+
+/** returns the number of messages dropped since dcdStartAsync. */
+size_t dcdGetDroppedMessages();
+
+/**
+ * writes messages as binary records to a file instead of the sinks, fatal messages still go to both. a record holds
+ * the callsite id, a timestamp and the raw arguments, formatting happens later in dcdDecodeBinaryLog (tools/dcdecode).
+ * records are collected per thread and written when a buffer is full, on dcdFlush of the same thread and when the
+ * thread exits.
+ * @note %n isn't supported, long doubles are stored as doubles and strings are cut at 1024 characters.
+ **/
+bool dcdOpenBinarySink(const char *path);
+
+/** writes the buffered records of every thread and closes the binary log. other threads must not log meanwhile. */
+void dcdCloseBinarySink();
+
+/** turns a binary log back into the text layout of the sinks. @returns false if the log is invalid. */
+bool dcdDecodeBinaryLog(FILE *in, FILE *out);
+
+/**
+ * writes messages into a ring in a memory mapped file, in addition to the other sinks. a message is formatted and
+ * copied into the mapping without a system call or a lock, and the OS keeps the pages when the process crashes, so the
+ * last messages can be read afterwards (dcdReadRingLog, tools/dcdecode -r). the oldest messages are overwritten once
+ * the ring is full, a file that already holds a ring of the same size is continued.
+ * @param size bytes of messages the ring holds, at least 64 KiB, rounded up to the page size.
+ * @param mask the message types written to the ring, context separators count as info.
+ * @note not supported on Windows yet. messages are cut at 1024 characters.
+ **/
+bool dcdOpenRingSink(const char *path, size_t size, unsigned int mask);
+
+/** unmaps the ring file. other threads must not log meanwhile. */
+void dcdCloseRingSink();
+
+/** writes the last count messages of a ring file in the text layout of the sinks. @returns false if it isn't a ring file. */
+bool dcdReadRingLog(FILE *in, FILE *out, size_t count);
+
+/** a message about to be written to a sink. */
+typedef struct DCdMsgInfo {
+	DCdMsgType type;
+	const char *file, *func;
+	int line;
+} DCdMsgInfo;
 
-/** adds a sink. */
+/** decides whether a sink gets a message. @note called by the logging thread in asynchronous mode. */
+typedef bool (*DCdSinkPredicate)(void *user, const DCdMsgInfo *msg);
+
+/**
+ * profiling: zones are timed scopes, recorded into a ring per thread while profiling runs and the current context has
+ * profile set. timestamps are rdtsc on x86 and clock_gettime elsewhere. measured with -O2 on an x86 VM, a recorded zone
+ * costs about 60 ns (mostly the two rdtsc) and a zone that isn't recorded 5 to 7 ns.
+ * zone names aren't copied, they have to live until the profile is written.
+ **/
+typedef struct DCdZoneSummary {
+	const char *name;
+	const char *track; // NULL for zones of the CPU, see dcdSetExternalFrameZones.
+	size_t count;
+	uint64_t totalNs, maxNs;
+} DCdZoneSummary;
+
+/** @param capacity number of zones kept per thread, older zones are overwritten. rounded up to a power of two. */
+void dcdStartProfiling(size_t capacity);
+
+/** frees the recorded zones. other threads must not record zones meanwhile. */
+void dcdStopProfiling();
+
+void dcdBeginZone(const char *name);
+/** ends the last zone begun by the calling thread. */
+void dcdEndZone();
+
+#define DCD_BEGIN_ZONE(NAME) dcdBeginZone(NAME)
+#define DCD_END_ZONE() dcdEndZone()
+
+/** marks the beginning of a frame, the summary covers the zones that began in the previous frame. */
+void dcdMarkFrame();
+
+/**
+ * sums up the zones of the last complete frame by name, sorted by total time.
+ * @returns the number of distinct zones, can be more than maxSummaries.
+ **/
+size_t dcdGetFrameZones(DCdZoneSummary *summaries, size_t maxSummaries);
+
+/**
+ * sets zones measured elsewhere (GPU timestamps), they are reported with the zones of the last complete frame until
+ * they are set again. the zones are copied, their names aren't.
+ **/
+void dcdSetExternalFrameZones(const char *track, const DCdZoneSummary *zones, size_t count);
+
+/** logs the summary of the last complete frame. */
+void dcdPrintFrameZones();
+
+/** writes the recorded zones in the trace event format of chrome://tracing and Perfetto. */
+bool dcdWriteChromeTrace(FILE *file);
+
+/** per frame measurements, recorded into a fixed ring of the last frames. */
+typedef enum DCdFrameStat {
+	DCD_FRAME_STAT_CPU_NS,      // from the beginning of the frame to the beginning of the next one.
+	DCD_FRAME_STAT_WAIT_NS,     // waiting for the GPU to finish the frame that used the same resources.
+	DCD_FRAME_STAT_DRAWS,       // draw calls.
+	DCD_FRAME_STAT_TRIANGLES,   // triangles of the draw calls, instances included.
+	DCD_FRAME_STAT_ALLOCATIONS, // heap and pool allocations.
+	DCD_FRAME_STAT_COUNT,
+} DCdFrameStat;
+
+typedef struct DCdFrameStatSummary {
+	size_t frames;
+	uint64_t p50, p95, p99, max;
+} DCdFrameStatSummary;
+
+/** @param capacity number of frames kept, older frames are overwritten. */
+void dcdStartFrameStats(size_t capacity);
+void dcdStopFrameStats();
+
+/** records the measurements of a frame, ignored if the frame stats aren't started. */
+void dcdRecordFrame(const uint64_t values[DCD_FRAME_STAT_COUNT]);
+
+/** returns the percentiles (nearest rank) of a measurement over the frames in the ring. */
+DCdFrameStatSummary dcdGetFrameStatSummary(DCdFrameStat stat);
+
+/**
+ * counts the frames in the ring per bucket of a measurement, the buckets are as wide as needed for the largest value.
+ * @returns the width of a bucket, 0 if no frame was recorded.
+ **/
+uint64_t dcdGetFrameStatHistogram(DCdFrameStat stat, size_t *buckets, size_t bucketCount);
+
+/** logs the percentiles of every measurement and a histogram of the CPU frame times. */
+void dcdPrintFrameStats();
+
+/** writes the frames in the ring as CSV, oldest first, with a header line. */
+bool dcdWriteFrameStatsCsv(FILE *file);
+
+/** adds a sink that gets every message. */
 void dcdAddSink(FILE *sink);
 
+/**
+ * sets which messages a sink gets: the types in mask, if predicate (can be NULL) accepts them. the masks are checked
+ * before a message is formatted, so messages no sink wants cost a call and a branch. context separators count as info.
+ **/
+void dcdSetSinkFilter(FILE *sink, unsigned int mask, DCdSinkPredicate predicate, void *user);
+
 /** removes a sink. @note warning if sink doesn't exist. */
 void dcdRemoveSink(FILE *sink);
 
 void dcdInit(const char *name);
 void dcdDeInit();
 
-#define DCD_MSGF(T, FMT, ...) DCD_EMSGF(DCD_MSG_TYPE_##T, FMT, ##__VA_ARGS__)
-#define DCD_EMSGF(T, FMT, ...) dcdMsgF(T, __FILE__, __func__, __LINE__, FMT, ##__VA_ARGS__)
+/** messages below DCD_MIN_LEVEL are removed by the compiler, their arguments aren't evaluated. */
+#define DCD_MSGF(T, FMT, ...) \
+	do { \
+		if(DCD_LEVEL_##T >= DCD_MIN_LEVEL || DCD_LEVEL_##T == DCD_LEVEL_FATAL) DCD_EMSGF(DCD_MSG_TYPE_##T, FMT, ##__VA_ARGS__); \
+	} while(0)
+#define DCD_EMSGF(T, FMT, ...) \
+	do { \
+		static DCdCallsite dcdCallsite_ = { __FILE__, __func__, FMT, __LINE__ }; \
+		dcdMsgC(&dcdCallsite_, T, ##__VA_ARGS__); \
+	} while(0)
 #define DEBUGIF(COND) if(COND)
 
 #define DCD_DEBUG(FMT, ...) DCD_MSGF(DEBUG, FMT, ##__VA_ARGS__)
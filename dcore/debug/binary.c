@@ -0,0 +1,406 @@
+#define _DEFAULT_SOURCE // clock_gettime
+#include <dcore/debug/binary.h>
+#include <dcore/debug/internal.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BUFFER_SIZE (64 * 1024)
+/** records are cut to this size, so one always fits into a buffer that has this much space left. */
+#define MAX_RECORD_SIZE (8 * 1024)
+
+/* records are collected in one buffer per thread, so sending a message doesn't take a lock. a buffer is written to
+   the file under the mutex when it's full, when its thread exits and when the sink is closed. */
+typedef struct Buffer {
+	size_t size;
+	struct Buffer *next;
+	uint8_t data[BUFFER_SIZE];
+} Buffer;
+
+static struct {
+	FILE *file;
+	atomic_bool open;
+	atomic_uint generation; // callsites registered in an older generation are written again into the new file.
+	atomic_uint nextId;
+	pthread_mutex_t mutex;
+	Buffer *buffers;
+	pthread_key_t key;
+	pthread_once_t keyOnce;
+} binary = { .mutex = PTHREAD_MUTEX_INITIALIZER, .keyOnce = PTHREAD_ONCE_INIT };
+
+static _Thread_local Buffer *threadBuffer;
+
+/** writes a buffer to the file, the mutex must be locked. */
+static void writeBuffer(Buffer *buffer) {
+	if(binary.file != NULL && buffer->size != 0) fwrite(buffer->data, 1, buffer->size, binary.file);
+	buffer->size = 0;
+}
+
+static void exitThread(void *data) {
+	Buffer *buffer = data;
+	pthread_mutex_lock(&binary.mutex);
+	writeBuffer(buffer);
+	for(Buffer **link = &binary.buffers; *link != NULL; link = &(*link)->next) {
+		if(*link == buffer) {
+			*link = buffer->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&binary.mutex);
+	if(buffer == threadBuffer) threadBuffer = NULL;
+	free(buffer);
+}
+
+static void createKey() { pthread_key_create(&binary.key, &exitThread); }
+
+/** returns the buffer of the calling thread with space for a record. */
+static Buffer *getBuffer() {
+	if(threadBuffer == NULL) {
+		pthread_once(&binary.keyOnce, &createKey);
+		threadBuffer = malloc(sizeof(Buffer));
+		threadBuffer->size = 0;
+		pthread_setspecific(binary.key, threadBuffer);
+		pthread_mutex_lock(&binary.mutex);
+		threadBuffer->next = binary.buffers;
+		binary.buffers = threadBuffer;
+		pthread_mutex_unlock(&binary.mutex);
+	}
+	if(threadBuffer->size + MAX_RECORD_SIZE > BUFFER_SIZE) {
+		pthread_mutex_lock(&binary.mutex);
+		writeBuffer(threadBuffer);
+		pthread_mutex_unlock(&binary.mutex);
+	}
+	return threadBuffer;
+}
+
+typedef struct Writer {
+	uint8_t *data;
+	size_t size, capacity;
+} Writer;
+
+static void put(Writer *writer, const void *data, size_t size) {
+	if(writer->size + size > writer->capacity) size = writer->capacity - writer->size;
+	memcpy(writer->data + writer->size, data, size);
+	writer->size += size;
+}
+
+#define PUT(WRITER, TYPE, VALUE) put((WRITER), &(TYPE){ (VALUE) }, sizeof(TYPE))
+
+/** strings that don't fit are cut, so the length is always followed by as many bytes. */
+static void putString(Writer *writer, const char *string, size_t length) {
+	size_t space = writer->capacity - writer->size;
+	if(space < sizeof(uint16_t)) return;
+	space -= sizeof(uint16_t);
+	if(length > DCDI_BINARY_MAX_STRING) length = DCDI_BINARY_MAX_STRING;
+	if(length > space) length = space;
+	PUT(writer, uint16_t, (uint16_t)length);
+	put(writer, string, length);
+}
+
+static uint64_t now() {
+	struct timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+static Writer beginRecord(Buffer *buffer, DCdiRecordKind kind) {
+	Writer writer = { buffer->data + buffer->size, 0, MAX_RECORD_SIZE };
+	PUT(&writer, uint8_t, (uint8_t)kind);
+	return writer;
+}
+
+static void registerCallsite(Buffer *buffer, DCdCallsite *callsite, unsigned int generation) {
+	unsigned int id = atomic_load_explicit(&callsite->id, memory_order_relaxed);
+	if(id == 0) {
+		unsigned int newId = atomic_fetch_add_explicit(&binary.nextId, 1, memory_order_relaxed) + 1;
+		id = atomic_compare_exchange_strong(&callsite->id, &id, newId) ? newId : id;
+	}
+	// two threads can both write the callsite, the decoder keeps one of them.
+	atomic_store_explicit(&callsite->generation, generation, memory_order_release);
+	Writer writer = beginRecord(buffer, DCDI_RECORD_CALLSITE);
+	PUT(&writer, uint32_t, id);
+	PUT(&writer, uint32_t, (uint32_t)callsite->line);
+	putString(&writer, callsite->file, strlen(callsite->file));
+	putString(&writer, callsite->func, strlen(callsite->func));
+	putString(&writer, callsite->fmt, strlen(callsite->fmt));
+	buffer->size += writer.size;
+}
+
+void dcdiWriteBinaryMessage(DCdCallsite *callsite, int type, size_t depth, va_list va) {
+	Buffer *buffer = getBuffer();
+	unsigned int generation = atomic_load_explicit(&binary.generation, memory_order_relaxed);
+	if(atomic_load_explicit(&callsite->generation, memory_order_acquire) != generation) {
+		registerCallsite(buffer, callsite, generation);
+		buffer = getBuffer();
+	}
+
+	Writer writer = beginRecord(buffer, DCDI_RECORD_MESSAGE);
+	PUT(&writer, uint32_t, atomic_load_explicit(&callsite->id, memory_order_relaxed));
+	PUT(&writer, uint8_t, (uint8_t)type);
+	PUT(&writer, uint16_t, (uint16_t)depth);
+	PUT(&writer, uint64_t, now());
+	size_t argumentSizeOffset = writer.size;
+	PUT(&writer, uint16_t, 0);
+
+	size_t argumentsBegin = writer.size;
+	DCdiConversion conversion;
+	for(const char *fmt = callsite->fmt; (fmt = dcdiNextConversion(fmt, &conversion)) != NULL;) {
+		for(int i = 0; i < conversion.starCount; ++i)
+			PUT(&writer, int64_t, va_arg(va, int));
+		switch(conversion.kind) {
+		case DCDI_ARG_NONE: break;
+		case DCDI_ARG_INT: PUT(&writer, int64_t, va_arg(va, int)); break;
+		case DCDI_ARG_UNSIGNED: PUT(&writer, int64_t, va_arg(va, unsigned int)); break;
+		case DCDI_ARG_LONG: PUT(&writer, int64_t, va_arg(va, long)); break;
+		case DCDI_ARG_UNSIGNED_LONG: PUT(&writer, int64_t, (int64_t)va_arg(va, unsigned long)); break;
+		case DCDI_ARG_LONG_LONG: PUT(&writer, int64_t, va_arg(va, long long)); break;
+		case DCDI_ARG_UNSIGNED_LONG_LONG: PUT(&writer, int64_t, (int64_t)va_arg(va, unsigned long long)); break;
+		case DCDI_ARG_SIZE: PUT(&writer, int64_t, (int64_t)va_arg(va, size_t)); break;
+		case DCDI_ARG_INTMAX: PUT(&writer, int64_t, va_arg(va, intmax_t)); break;
+		case DCDI_ARG_UINTMAX: PUT(&writer, int64_t, (int64_t)va_arg(va, uintmax_t)); break;
+		case DCDI_ARG_PTRDIFF: PUT(&writer, int64_t, va_arg(va, ptrdiff_t)); break;
+		case DCDI_ARG_DOUBLE: PUT(&writer, double, va_arg(va, double)); break;
+		case DCDI_ARG_LONG_DOUBLE: PUT(&writer, double, (double)va_arg(va, long double)); break;
+		case DCDI_ARG_POINTER: PUT(&writer, uint64_t, (uint64_t)(uintptr_t)va_arg(va, void *)); break;
+		case DCDI_ARG_STRING: {
+			const char *string = va_arg(va, const char *);
+			if(string == NULL) PUT(&writer, uint16_t, DCDI_BINARY_NULL_STRING);
+			else putString(&writer, string, strlen(string));
+			break;
+		}
+		}
+	}
+	uint16_t argumentSize = (uint16_t)(writer.size - argumentsBegin);
+	memcpy(writer.data + argumentSizeOffset, &argumentSize, sizeof(argumentSize));
+	buffer->size += writer.size;
+}
+
+void dcdiWriteBinaryText(int type, const char *file, const char *func, int line, size_t depth, const char *fmt, va_list va) {
+	char text[DCDI_BINARY_MAX_STRING + 1];
+	int length = vsnprintf(text, sizeof(text), fmt, va);
+	Buffer *buffer = getBuffer();
+	Writer writer = beginRecord(buffer, DCDI_RECORD_TEXT);
+	uint8_t binaryType = type == DCDI_CONTEXT_PUSH ? DCDI_BINARY_TYPE_CONTEXT_PUSH
+	                   : type == DCDI_CONTEXT_POP  ? DCDI_BINARY_TYPE_CONTEXT_POP
+	                                               : (uint8_t)type;
+	PUT(&writer, uint8_t, binaryType);
+	PUT(&writer, uint16_t, (uint16_t)depth);
+	PUT(&writer, uint64_t, now());
+	PUT(&writer, uint32_t, (uint32_t)line);
+	putString(&writer, file, strlen(file));
+	putString(&writer, func, strlen(func));
+	putString(&writer, text, length < 0 ? 0 : (size_t)length);
+	buffer->size += writer.size;
+}
+
+/** only writes the buffer of the calling thread, the other buffers are filled without the mutex. */
+void dcdiFlushBinary() {
+	if(threadBuffer == NULL) return;
+	pthread_mutex_lock(&binary.mutex);
+	writeBuffer(threadBuffer);
+	if(binary.file != NULL) fflush(binary.file);
+	pthread_mutex_unlock(&binary.mutex);
+}
+
+bool dcdiBinarySinkOpen() { return atomic_load_explicit(&binary.open, memory_order_relaxed); }
+
+bool dcdOpenBinarySink(const char *path) {
+	FILE *file = fopen(path, "wb");
+	if(file == NULL) {
+		DCD_ERROR("Failed to open the binary log %s.", path);
+		return false;
+	}
+	fwrite(DCDI_BINARY_MAGIC, 1, DCDI_BINARY_MAGIC_SIZE, file);
+
+	dcdCloseBinarySink();
+	pthread_mutex_lock(&binary.mutex);
+	binary.file = file;
+	atomic_fetch_add(&binary.generation, 1);
+	atomic_store(&binary.open, true);
+	pthread_mutex_unlock(&binary.mutex);
+	return true;
+}
+
+void dcdCloseBinarySink() {
+	if(!atomic_exchange(&binary.open, false)) return;
+	pthread_mutex_lock(&binary.mutex);
+	for(Buffer *buffer = binary.buffers; buffer != NULL; buffer = buffer->next)
+		writeBuffer(buffer);
+	fclose(binary.file);
+	binary.file = NULL;
+	pthread_mutex_unlock(&binary.mutex);
+}
+
+typedef struct Reader {
+	const uint8_t *data;
+	size_t size;
+} Reader;
+
+static bool get(Reader *reader, void *data, size_t size) {
+	if(reader->size < size) return false;
+	memcpy(data, reader->data, size);
+	reader->data += size, reader->size -= size;
+	return true;
+}
+
+/** reads a string into a null terminated copy, NULL strings become "(null)" like in glibc. */
+static bool getString(Reader *reader, char string[DCDI_BINARY_MAX_STRING + 1]) {
+	uint16_t length;
+	if(!get(reader, &length, sizeof(length))) return false;
+	if(length == DCDI_BINARY_NULL_STRING) {
+		strcpy(string, "(null)");
+		return true;
+	}
+	if(length > DCDI_BINARY_MAX_STRING || !get(reader, string, length)) return false;
+	string[length] = '\0';
+	return true;
+}
+
+typedef struct Callsite {
+	char *file, *func, *fmt;
+	uint32_t line;
+} Callsite;
+
+/** formats the arguments of a message like printf would have, stops at the first argument that was cut off. */
+static void printArguments(FILE *out, const char *fmt, Reader arguments) {
+	DCdiConversion conversion;
+	char spec[64], string[DCDI_BINARY_MAX_STRING + 1];
+	for(const char *rest; (rest = dcdiNextConversion(fmt, &conversion)) != NULL; fmt = rest) {
+		fwrite(fmt, 1, (size_t)(conversion.begin - fmt), out);
+		size_t specLength = (size_t)(conversion.end - conversion.begin) + 1;
+		if(conversion.kind == DCDI_ARG_NONE) {
+			if(specLength == 2 && conversion.end[0] == '%') fputc('%', out);
+			else fwrite(conversion.begin, 1, specLength, out);
+			continue;
+		}
+		if(specLength >= sizeof(spec)) return;
+		memcpy(spec, conversion.begin, specLength);
+		spec[specLength] = '\0';
+
+		int stars[2];
+		for(int i = 0; i < conversion.starCount; ++i) {
+			int64_t star;
+			if(!get(&arguments, &star, sizeof(star))) return;
+			stars[i] = (int)star;
+		}
+		int64_t integer = 0;
+		double floating = 0.0;
+		if(conversion.kind == DCDI_ARG_STRING) {
+			if(!getString(&arguments, string)) return;
+		} else if(!get(&arguments, conversion.kind == DCDI_ARG_DOUBLE || conversion.kind == DCDI_ARG_LONG_DOUBLE ? (void *)&floating : &integer, 8)) {
+			return;
+		}
+
+#define PRINT(VALUE) \
+	(conversion.starCount == 0   ? fprintf(out, spec, (VALUE)) \
+	 : conversion.starCount == 1 ? fprintf(out, spec, stars[0], (VALUE)) \
+	                             : fprintf(out, spec, stars[0], stars[1], (VALUE)))
+		switch(conversion.kind) {
+		case DCDI_ARG_NONE: break;
+		case DCDI_ARG_INT: PRINT((int)integer); break;
+		case DCDI_ARG_UNSIGNED: PRINT((unsigned int)integer); break;
+		case DCDI_ARG_LONG: PRINT((long)integer); break;
+		case DCDI_ARG_UNSIGNED_LONG: PRINT((unsigned long)integer); break;
+		case DCDI_ARG_LONG_LONG: PRINT((long long)integer); break;
+		case DCDI_ARG_UNSIGNED_LONG_LONG: PRINT((unsigned long long)integer); break;
+		case DCDI_ARG_SIZE: PRINT((size_t)integer); break;
+		case DCDI_ARG_INTMAX: PRINT((intmax_t)integer); break;
+		case DCDI_ARG_UINTMAX: PRINT((uintmax_t)integer); break;
+		case DCDI_ARG_PTRDIFF: PRINT((ptrdiff_t)integer); break;
+		case DCDI_ARG_DOUBLE: PRINT(floating); break;
+		case DCDI_ARG_LONG_DOUBLE: PRINT((long double)floating); break;
+		case DCDI_ARG_STRING: PRINT(string); break;
+		case DCDI_ARG_POINTER: PRINT((void *)(uintptr_t)integer); break;
+		}
+#undef PRINT
+	}
+	fputs(fmt, out);
+}
+
+/** reads the callsites (first pass) or prints the messages (second pass). */
+static bool decodeRecords(Reader reader, FILE *out, Callsite **callsites, size_t *callsiteCount) {
+	char file[DCDI_BINARY_MAX_STRING + 1], func[DCDI_BINARY_MAX_STRING + 1], text[DCDI_BINARY_MAX_STRING + 1], timeString[26];
+	while(reader.size != 0) {
+		uint8_t kind, type;
+		uint16_t depth, argumentSize;
+		uint32_t id, line;
+		uint64_t time;
+		switch(kind = *reader.data++, --reader.size, kind) {
+		case DCDI_RECORD_CALLSITE:
+			if(!get(&reader, &id, sizeof(id)) || !get(&reader, &line, sizeof(line)) || !getString(&reader, file) || !getString(&reader, func) ||
+			   !getString(&reader, text))
+				return false;
+			if(id > DCDI_BINARY_MAX_CALLSITE_ID) return false;
+			if(out != NULL || id == 0) break;
+			if(id > *callsiteCount) {
+				Callsite *grown = realloc(*callsites, sizeof(Callsite) * id);
+				if(grown == NULL) return false;
+				*callsites = grown;
+				memset(*callsites + *callsiteCount, 0, sizeof(Callsite) * (id - *callsiteCount));
+				*callsiteCount = id;
+			}
+			Callsite *callsite = &(*callsites)[id - 1];
+			if(callsite->fmt != NULL) break;
+			*callsite = (Callsite){ strdup(file), strdup(func), strdup(text), line };
+			break;
+		case DCDI_RECORD_MESSAGE:
+			if(!get(&reader, &id, sizeof(id)) || !get(&reader, &type, sizeof(type)) || !get(&reader, &depth, sizeof(depth)) ||
+			   !get(&reader, &time, sizeof(time)) || !get(&reader, &argumentSize, sizeof(argumentSize)) || reader.size < argumentSize)
+				return false;
+			Reader arguments = { reader.data, argumentSize };
+			reader.data += argumentSize, reader.size -= argumentSize;
+			if(out == NULL) break;
+			if(id == 0 || id > *callsiteCount || (*callsites)[id - 1].fmt == NULL || type > DCD_MSG_TYPE_SUCCESS) return false;
+
+			const Callsite *site = &(*callsites)[id - 1];
+			dcdiFormatTime((time_t)(time / 1000000000u), timeString);
+			dcdiPrintPrefix(out, type, timeString, site->file, site->func, (int)site->line, depth);
+			printArguments(out, site->fmt, arguments);
+			dcdiPrintSuffix(out);
+			break;
+		case DCDI_RECORD_TEXT:
+			if(!get(&reader, &type, sizeof(type)) || !get(&reader, &depth, sizeof(depth)) || !get(&reader, &time, sizeof(time)) ||
+			   !get(&reader, &line, sizeof(line)) || !getString(&reader, file) || !getString(&reader, func) || !getString(&reader, text))
+				return false;
+			if(out == NULL) break;
+			int textType = type == DCDI_BINARY_TYPE_CONTEXT_PUSH ? DCDI_CONTEXT_PUSH
+			             : type == DCDI_BINARY_TYPE_CONTEXT_POP  ? DCDI_CONTEXT_POP
+			                                                     : type;
+			if(textType > DCD_MSG_TYPE_SUCCESS && textType < DCDI_CONTEXT_PUSH) return false;
+			dcdiFormatTime((time_t)(time / 1000000000u), timeString);
+			dcdiPrintPrefix(out, textType, timeString, file, func, (int)line, depth);
+			fputs(text, out);
+			dcdiPrintSuffix(out);
+			break;
+		default: return false;
+		}
+	}
+	return true;
+}
+
+bool dcdDecodeBinaryLog(FILE *in, FILE *out) {
+	size_t size = 0, capacity = 64 * 1024;
+	uint8_t *data = malloc(capacity);
+	for(size_t read; (read = fread(data + size, 1, capacity - size, in)) != 0;) {
+		size += read;
+		if(size == capacity) data = realloc(data, capacity *= 2);
+	}
+
+	bool valid = size >= DCDI_BINARY_MAGIC_SIZE && memcmp(data, DCDI_BINARY_MAGIC, DCDI_BINARY_MAGIC_SIZE) == 0;
+	Reader records = { data + DCDI_BINARY_MAGIC_SIZE, size - DCDI_BINARY_MAGIC_SIZE };
+	Callsite *callsites = NULL;
+	size_t callsiteCount = 0;
+	// a callsite can come after messages of other threads that use it.
+	valid = valid && decodeRecords(records, NULL, &callsites, &callsiteCount) && decodeRecords(records, out, &callsites, &callsiteCount);
+
+	for(size_t i = 0; i < callsiteCount; ++i)
+		free(callsites[i].file), free(callsites[i].func), free(callsites[i].fmt);
+	free(callsites);
+	free(data);
+	return valid;
+}
@@ -0,0 +1,125 @@
+#ifndef DCORE_DEBUG_BINARY_H
+#define DCORE_DEBUG_BINARY_H
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * layout of binary log files, shared by the binary sink and tools/dcdecode.c. numbers are in the native byte order
+ * of the logging machine, so logs are decoded on a machine of the same byte order. the file starts with the magic,
+ * then records follow, each starting with its kind:
+ *
+ * CALLSITE: u32 id, u32 line, u16 length + file, u16 length + func, u16 length + fmt (strings without the null)
+ * MESSAGE:  u32 callsite id, u8 type, u16 depth, u64 time (ns since the epoch), u16 argument bytes, arguments
+ * TEXT:     u8 type, u16 depth, u64 time, u32 line, u16 length + file, u16 length + func, u16 length + text
+ *
+ * types are DCdMsgType values, text records also use the context separator types below.
+ *
+ * message arguments are stored in the order of the conversions of fmt: '*' widths and precisions and integers as
+ * i64, floating point numbers as f64, pointers as u64 and strings as u16 length + bytes (0xffff for NULL).
+ * a callsite can be written after the first message that uses it, if that message was sent by another thread.
+ **/
+
+#define DCDI_BINARY_MAGIC "DCDLOG1"
+#define DCDI_BINARY_MAGIC_SIZE 8
+#define DCDI_BINARY_NULL_STRING 0xffff
+/** longer strings are cut. */
+#define DCDI_BINARY_MAX_STRING 1024
+/** callsite ids count the DCD_* macros that logged, the decoder rejects larger ones instead of allocating for them. */
+#define DCDI_BINARY_MAX_CALLSITE_ID (1u << 20)
+#define DCDI_BINARY_TYPE_CONTEXT_PUSH 6
+#define DCDI_BINARY_TYPE_CONTEXT_POP 7
+
+typedef enum DCdiRecordKind {
+	DCDI_RECORD_CALLSITE = 1,
+	DCDI_RECORD_MESSAGE,
+	DCDI_RECORD_TEXT,
+} DCdiRecordKind;
+
+/** the C type a conversion reads with va_arg. */
+typedef enum DCdiArgKind {
+	DCDI_ARG_NONE, // %% or an unsupported conversion.
+	DCDI_ARG_INT,
+	DCDI_ARG_UNSIGNED,
+	DCDI_ARG_LONG,
+	DCDI_ARG_UNSIGNED_LONG,
+	DCDI_ARG_LONG_LONG,
+	DCDI_ARG_UNSIGNED_LONG_LONG,
+	DCDI_ARG_SIZE,
+	DCDI_ARG_INTMAX,
+	DCDI_ARG_UINTMAX,
+	DCDI_ARG_PTRDIFF,
+	DCDI_ARG_DOUBLE,
+	DCDI_ARG_LONG_DOUBLE,
+	DCDI_ARG_STRING,
+	DCDI_ARG_POINTER,
+} DCdiArgKind;
+
+typedef struct DCdiConversion {
+	const char *begin, *end; // from '%' to the conversion character, inclusive.
+	int starCount;           // '*' widths and precisions, each takes an int before the value.
+	DCdiArgKind kind;
+} DCdiConversion;
+
+/**
+ * finds the next conversion in a printf format.
+ * @return the rest of the format after the conversion, NULL if there is none.
+ **/
+static inline const char *dcdiNextConversion(const char *fmt, DCdiConversion *conversion) {
+	const char *c = strchr(fmt, '%');
+	if(c == NULL) return NULL;
+	*conversion = (DCdiConversion){ .begin = c++ };
+	while(*c != '\0' && strchr("-+ #0", *c) != NULL)
+		++c;
+	if(*c == '*') ++conversion->starCount, ++c;
+	while(*c >= '0' && *c <= '9')
+		++c;
+	if(*c == '.') {
+		++c;
+		if(*c == '*') ++conversion->starCount, ++c;
+		while(*c >= '0' && *c <= '9')
+			++c;
+	}
+
+	char length = 0;
+	if(c[0] == 'h') length = 'h', c += c[1] == 'h' ? 2 : 1;
+	else if(c[0] == 'l' && c[1] == 'l') length = 'L', c += 2;
+	else if(c[0] == 'l') length = 'l', ++c;
+	else if(*c == 'z' || *c == 'j' || *c == 't') length = *c++;
+	else if(*c == 'L') length = 'D', ++c;
+
+	bool isSigned = *c == 'd' || *c == 'i';
+	switch(*c) {
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		switch(length) {
+		case 'l': conversion->kind = isSigned ? DCDI_ARG_LONG : DCDI_ARG_UNSIGNED_LONG; break;
+		case 'L': conversion->kind = isSigned ? DCDI_ARG_LONG_LONG : DCDI_ARG_UNSIGNED_LONG_LONG; break;
+		case 'z': conversion->kind = DCDI_ARG_SIZE; break;
+		case 'j': conversion->kind = isSigned ? DCDI_ARG_INTMAX : DCDI_ARG_UINTMAX; break;
+		case 't': conversion->kind = DCDI_ARG_PTRDIFF; break;
+		default: conversion->kind = isSigned ? DCDI_ARG_INT : DCDI_ARG_UNSIGNED; break;
+		}
+		break;
+	case 'c': conversion->kind = DCDI_ARG_INT; break;
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A': conversion->kind = length == 'D' ? DCDI_ARG_LONG_DOUBLE : DCDI_ARG_DOUBLE; break;
+	case 's': conversion->kind = DCDI_ARG_STRING; break;
+	case 'p': conversion->kind = DCDI_ARG_POINTER; break;
+	default: conversion->kind = DCDI_ARG_NONE; break;
+	}
+	conversion->end = *c != '\0' ? c : c - 1;
+	return *c != '\0' ? c + 1 : c;
+}
+
+#endif
@@ -1,5 +1,9 @@
+#define _DEFAULT_SOURCE // localtime_r
 #include <dcore/debug.h>
+#include <dcore/debug/internal.h>
 #include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
 #	include <unistd.h>
 int fileno(FILE *stream);
@@ -7,6 +11,9 @@ int fileno(FILE *stream);
 #else
 #	define ISATTY(FILE) 1
 #endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,41 +22,155 @@ int fileno(FILE *stream);
 static void defaultFatalHandler() { exit(1); }
 
 static DCdFatalHandler fatalHandler;
+
+typedef struct Sink {
+	FILE *file;
+	unsigned int mask;
+	DCdSinkPredicate predicate;
+	void *user;
+} Sink;
+
 static size_t sinkCount;
-static FILE **sinks;
-static size_t contextStackSize;
-static DCdContext *contextStack;
+static Sink *sinks;
+static pthread_mutex_t sinkMutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_uint sinkMask; // union of the sink masks, messages outside it aren't formatted.
+
+/* every thread has its own context stack, so messages of a thread are indented by its own contexts and pushing
+   doesn't need a lock. stacks only grow (doubling), so pushes and pops don't allocate once a stack is deep enough.
+   messages are also counted per thread, dcdGetMsgStats sums up the live threads and the threads that exited. */
+typedef struct ThreadState {
+	DCdContext *contexts;
+	size_t size, capacity;
+	_Atomic size_t counts[DCD_MSG_TYPE_SUCCESS + 1]; // only written by their thread.
+	struct ThreadState *next;
+} ThreadState;
+
+static const char *rootName = "main";
+static pthread_mutex_t threadStateMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t threadStateKey;
+static pthread_once_t threadStateKeyOnce = PTHREAD_ONCE_INIT;
+static ThreadState *threadStateList;
+static DCdMsgStats exitedThreadStats;
+static _Thread_local ThreadState *threadState;
+
+static void addThreadStats(DCdMsgStats *stats, ThreadState *thread) {
+	unsigned int *counts = &stats->debug;
+	for(int type = 0; type <= DCD_MSG_TYPE_SUCCESS; ++type) {
+		size_t count = atomic_load_explicit(&thread->counts[type], memory_order_relaxed);
+		stats->total += count;
+		counts[type] += (unsigned int)count;
+	}
+}
+
+/** unlinks and frees the state of a thread, its messages stay in the stats. */
+static void exitThread(void *data) {
+	ThreadState *thread = data;
+	pthread_mutex_lock(&threadStateMutex);
+	addThreadStats(&exitedThreadStats, thread);
+	for(ThreadState **link = &threadStateList; *link != NULL; link = &(*link)->next) {
+		if(*link == thread) {
+			*link = thread->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&threadStateMutex);
+	if(thread == threadState) threadState = NULL;
+	free(thread->contexts);
+	free(thread);
+}
+
+static void createThreadStateKey() { pthread_key_create(&threadStateKey, &exitThread); }
+
+/** returns the state of the calling thread, registers it with a root context on first use. */
+static ThreadState *getThreadState() {
+	if(threadState != NULL) return threadState;
+
+	pthread_once(&threadStateKeyOnce, &createThreadStateKey);
+	threadState = calloc(1, sizeof(ThreadState));
+	threadState->capacity = 8;
+	threadState->contexts = malloc(sizeof(DCdContext) * threadState->capacity);
+	threadState->contexts[0] = (DCdContext){ .name = rootName, .mask = DCD_MSG_MASK_ALL };
+	threadState->size = 1;
+	pthread_setspecific(threadStateKey, threadState);
+
+	pthread_mutex_lock(&threadStateMutex);
+	threadState->next = threadStateList;
+	threadStateList = threadState;
+	pthread_mutex_unlock(&threadStateMutex);
+	return threadState;
+}
+
+const char *dcdiGetThreadName() { return getThreadState()->contexts[0].name; }
+
+DCdMsgStats dcdGetMsgStats() {
+	pthread_mutex_lock(&threadStateMutex);
+	DCdMsgStats stats = exitedThreadStats;
+	for(ThreadState *thread = threadStateList; thread != NULL; thread = thread->next)
+		addThreadStats(&stats, thread);
+	pthread_mutex_unlock(&threadStateMutex);
+	return stats;
+}
 
 void dcdSetFatalHandler(DCdFatalHandler handler) { fatalHandler = handler; }
 
 DCdFatalHandler dcdGetFatalHandler() { return fatalHandler; }
 
-DCdContext *dcdGetCurrentContext() { return &contextStack[contextStackSize - 1]; }
+DCdContext *dcdGetCurrentContext() {
+	ThreadState *thread = getThreadState();
+	return &thread->contexts[thread->size - 1];
+}
+
 DCdContext *dcdPushContext(const char *name, const char *file, const char *func, int line) {
-	dcdMsgF(10000, file, func, line, "[ %s ]", name);
+	dcdMsgF(DCDI_CONTEXT_PUSH, file, func, line, "[ %s ]", name);
 	return dcdPushContextQuiet(name);
 }
 
 DCdContext *dcdPushContextQuiet(const char *name) {
-	if(contextStack)
-		contextStack = realloc(contextStack, sizeof(DCdContext) * ++contextStackSize);
-	else
-		contextStack = malloc(sizeof(DCdContext) * (contextStackSize = 1));
-	dcdGetCurrentContext()->name = name;
-	memset(&dcdGetCurrentContext()->stats, 0, sizeof(DCdMsgStats));
-	return dcdGetCurrentContext();
+	ThreadState *thread = getThreadState();
+	if(thread->size == thread->capacity) thread->contexts = realloc(thread->contexts, sizeof(DCdContext) * (thread->capacity *= 2));
+	DCdContext *context = &thread->contexts[thread->size++];
+	*context = (DCdContext){ .name = name, .mask = context[-1].mask, .profile = context[-1].profile };
+	dcdiProfilePushContext(name, thread->size, context->profile);
+	return context;
 }
 
 size_t dcdPopContext(const char *file, const char *func, int line) {
-	dcdMsgF(10001, file, func, line, "[ %s ]", dcdGetCurrentContext()->name);
+	dcdMsgF(DCDI_CONTEXT_POP, file, func, line, "[ %s ]", dcdGetCurrentContext()->name);
 	return dcdPopContextQuiet();
 }
 
 size_t dcdPopContextQuiet() {
-	if(contextStack == NULL) return 0;
-	if(contextStackSize == 1) return 1;
-	contextStack = realloc(contextStack, sizeof(DCdContext) * --contextStackSize);
-	return contextStackSize;
+	ThreadState *thread = getThreadState();
+	if(thread->size == 1) return 1;
+	dcdiProfilePopContext(thread->size);
+	return --thread->size;
+}
+
+unsigned int dcdGetLevelMask(int level) {
+	static const int levels[] = { DCD_LEVEL_DEBUG, DCD_LEVEL_INFO, DCD_LEVEL_WARNING, DCD_LEVEL_ERROR, DCD_LEVEL_FATAL, DCD_LEVEL_SUCCESS };
+	unsigned int mask = 0;
+	for(int type = 0; type < 6; ++type)
+		if(levels[type] >= level) mask |= 1u << type;
+	return mask;
+}
+
+/** context separators are filtered like info messages. */
+static unsigned int typeMask(int type) { return type >= DCDI_CONTEXT_PUSH ? DCD_MSG_MASK(INFO) : 1u << type; }
+
+static bool contextAccepts(int type) { return type == DCD_MSG_TYPE_FATAL || (dcdGetCurrentContext()->mask & typeMask(type)) != 0; }
+
+static bool sinkAccepts(const Sink *sink, int type, const char *file, const char *func, int line) {
+	if((sink->mask & typeMask(type)) == 0) return false;
+	if(sink->predicate == NULL) return true;
+	return sink->predicate(sink->user, &(DCdMsgInfo){ type >= DCDI_CONTEXT_PUSH ? DCD_MSG_TYPE_INFO : type, file, func, line });
+}
+
+/** the sink mutex must be locked. */
+static void updateSinkMask() {
+	unsigned int mask = 0;
+	for(size_t i = 0; i < sinkCount; ++i)
+		mask |= sinks[i].mask;
+	atomic_store_explicit(&sinkMask, mask, memory_order_relaxed);
 }
 
 static const char *messageTypePrefix[] = { "DEBUG", "INFO", "WARN", "ERROR", "FATAL", "SUCCESS" };
@@ -68,70 +189,349 @@ static void printSepratator(FILE *sink) {
 	fputc('\n', sink);
 }
 
-void dcdMsgF(DCdMsgType type, const char *file, const char *func, int line, const char *fmt, ...) {
-	// increment stats
-	if((int)type < 10000) {
-		dcdGetCurrentContext()->stats.total += 1;
-		*(&dcdGetCurrentContext()->stats.debug + (size_t)type) += 1;
+void dcdiPrintPrefix(FILE *sink, int type, const char *timeString, const char *file, const char *func, int line, size_t depth) {
+	// TODO: Configure separator length (also whether it exists or not) and char
+	if(type == DCDI_CONTEXT_PUSH) printSepratator(sink);
+	fprintf(
+	  sink, "%s%s | %25s:%-3d @%-20s | %7s | ", (!ISATTY(sink) || type >= DCDI_CONTEXT_PUSH) ? "" : messageColor[type], timeString, file, line, func,
+	  type >= DCDI_CONTEXT_PUSH ? "" : messageTypePrefix[type]
+	);
+
+	// indentation
+	// TODO: different indent size
+	for(size_t j = 1 + (type == DCDI_CONTEXT_POP ? 1 : 0); j < depth; ++j)
+		fputs("  ", sink);
+}
+
+void dcdiPrintSuffix(FILE *sink) { fputs(ISATTY(sink) ? "\033[m\n" : "\n", sink); }
+
+void dcdiFormatTime(time_t timer, char timeString[26]) {
+	struct tm tmInfo;
+	localtime_r(&timer, &tmInfo);
+	strftime(timeString, 26, "%Y-%m-%d %H:%M:%S", &tmInfo);
+}
+
+/** a message waiting for the logging thread, formatted by the thread that sent it. */
+typedef struct Record {
+	int type;
+	const char *file, *func;
+	int line;
+	size_t depth;
+	time_t time;
+	char text[DCD_ASYNC_MESSAGE_SIZE];
+} Record;
+
+/** sequence == position: free for the producer at position, sequence == position + 1: filled. */
+typedef struct Slot {
+	atomic_size_t sequence;
+	Record record;
+} Slot;
+
+static struct {
+	Slot *slots;
+	size_t mask;
+	DCdAsyncPolicy policy;
+	atomic_size_t head, tail; // next position to fill and to write.
+	atomic_size_t dropped;
+	atomic_bool enabled, running;
+	atomic_bool sleeping; // the logging thread waits for wake, set and cleared with mutex locked.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t wake;
+} async = { .mutex = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+
+/**
+ * wakes the logging thread if it sleeps, called after publishing a record. the logging thread checks for records
+ * after saying it sleeps, so either it sees the record or this sees it sleeping. signaling with the mutex locked
+ * makes sure it is already waiting.
+ **/
+static void wakeLoggingThread() {
+	atomic_thread_fence(memory_order_seq_cst);
+	if(!atomic_load_explicit(&async.sleeping, memory_order_relaxed)) return;
+	pthread_mutex_lock(&async.mutex);
+	pthread_cond_signal(&async.wake);
+	pthread_mutex_unlock(&async.mutex);
+}
+
+/** claims a slot (lock-free, producers only compete for the head), returns NULL if the ring is full and messages are dropped. */
+static Slot *claimSlot(bool mayDrop) {
+	size_t position = atomic_load_explicit(&async.head, memory_order_relaxed);
+	for(;;) {
+		Slot *slot = &async.slots[position & async.mask];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+		if(difference == 0) {
+			if(atomic_compare_exchange_weak_explicit(&async.head, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) return slot;
+		} else if(difference < 0) {
+			// full, the slot still holds a record from the previous round.
+			if(mayDrop) return NULL;
+			wakeLoggingThread();
+			sched_yield();
+			position = atomic_load_explicit(&async.head, memory_order_relaxed);
+		} else {
+			position = atomic_load_explicit(&async.head, memory_order_relaxed);
+		}
+	}
+}
+
+/** writes every filled record, only called by the logging thread. @returns the number of records written. */
+static size_t drainRecords() {
+	size_t tail = atomic_load_explicit(&async.tail, memory_order_relaxed), written = 0;
+	pthread_mutex_lock(&sinkMutex);
+	for(;;) {
+		Slot *slot = &async.slots[tail & async.mask];
+		if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != tail + 1) break;
+
+		Record *record = &slot->record;
+		char timeString[26];
+		dcdiFormatTime(record->time, timeString);
+		for(size_t i = 0; i < sinkCount; ++i) {
+			if(!sinkAccepts(&sinks[i], record->type, record->file, record->func, record->line)) continue;
+			dcdiPrintPrefix(sinks[i].file, record->type, timeString, record->file, record->func, record->line, record->depth);
+			fputs(record->text, sinks[i].file);
+			dcdiPrintSuffix(sinks[i].file);
+		}
+
+		atomic_store_explicit(&slot->sequence, tail + async.mask + 1, memory_order_release);
+		atomic_store_explicit(&async.tail, ++tail, memory_order_release);
+		++written;
 	}
-	if(!sinks) {
-		if(type == DCD_MSG_TYPE_FATAL) fatalHandler();
+	if(written != 0)
+		for(size_t i = 0; i < sinkCount; ++i)
+			fflush(sinks[i].file);
+	pthread_mutex_unlock(&sinkMutex);
+	return written;
+}
+
+/** returns true if the record at the tail was filled. */
+static bool recordReady() {
+	size_t tail = atomic_load_explicit(&async.tail, memory_order_relaxed);
+	return atomic_load_explicit(&async.slots[tail & async.mask].sequence, memory_order_acquire) == tail + 1;
+}
+
+static void *loggingThread(void *data) {
+	while(atomic_load(&async.running)) {
+		if(drainRecords() != 0) continue;
+		// producers only signal while the thread sleeps, see wakeLoggingThread.
+		pthread_mutex_lock(&async.mutex);
+		atomic_store(&async.sleeping, true);
+		atomic_thread_fence(memory_order_seq_cst);
+		if(atomic_load(&async.running) && !recordReady()) pthread_cond_wait(&async.wake, &async.mutex);
+		atomic_store(&async.sleeping, false);
+		pthread_mutex_unlock(&async.mutex);
+	}
+	drainRecords();
+	return NULL;
+}
+
+void dcdStartAsync(size_t capacity, DCdAsyncPolicy policy) {
+	if(atomic_load(&async.enabled)) return;
+	size_t roundedCapacity = 2;
+	while(roundedCapacity < capacity)
+		roundedCapacity *= 2;
+
+	async.slots = malloc(sizeof(Slot) * roundedCapacity);
+	for(size_t i = 0; i < roundedCapacity; ++i)
+		atomic_init(&async.slots[i].sequence, i);
+	async.mask = roundedCapacity - 1;
+	async.policy = policy;
+	atomic_store(&async.head, 0);
+	atomic_store(&async.tail, 0);
+	atomic_store(&async.dropped, 0);
+	atomic_store(&async.running, true);
+	if(pthread_create(&async.thread, NULL, loggingThread, NULL) != 0) {
+		atomic_store(&async.running, false);
+		free(async.slots);
+		async.slots = NULL;
+		DCD_WARNING("Failed to start the logging thread, messages stay synchronous.");
 		return;
 	}
+	atomic_store(&async.enabled, true);
+}
 
-	time_t timer;
-	char timeString[26];
-	struct tm *tmInfo;
-	timer = time(NULL);
-	tmInfo = localtime(&timer);
-	strftime(timeString, 26, "%Y-%m-%d %H:%M:%S", tmInfo);
-
-	for(int i = 0; i < sinkCount; ++i) {
-		// TODO: Configure separator length (also whether it exists or not) and char
-		if((int)type == 10000) printSepratator(sinks[i]);
-		fprintf(
-		  sinks[i], "%s%s | %25s:%-3d @%-20s | %7s | ", (!ISATTY(sinks[i]) || (int)type >= 10000) ? "" : messageColor[type], timeString, file, line, func,
-		  (int)type >= 10000 ? "" : messageTypePrefix[type]
-		);
-
-		// indentation
-		// TODO: different indent size
-		for(int j = 0; j < contextStackSize - 1 - ((int)type == 10001 ? 1 : 0); ++j) {
-			fputs("  ", sinks[i]);
+void dcdStopAsync() {
+	if(!atomic_exchange(&async.enabled, false)) return;
+	atomic_store(&async.running, false);
+	pthread_mutex_lock(&async.mutex);
+	pthread_cond_signal(&async.wake);
+	pthread_mutex_unlock(&async.mutex);
+	pthread_join(async.thread, NULL);
+	free(async.slots);
+	async.slots = NULL;
+}
+
+void dcdFlush() {
+	dcdiFlushBinary();
+	if(atomic_load(&async.enabled)) {
+		size_t head = atomic_load(&async.head);
+		while(atomic_load_explicit(&async.tail, memory_order_acquire) < head) {
+			wakeLoggingThread();
+			sched_yield();
 		}
+		return;
+	}
+	pthread_mutex_lock(&sinkMutex);
+	for(size_t i = 0; i < sinkCount; ++i)
+		fflush(sinks[i].file);
+	pthread_mutex_unlock(&sinkMutex);
+}
 
-		va_list va;
-		va_start(va, fmt);
-		vfprintf(sinks[i], fmt, va);
-		va_end(va);
+size_t dcdGetDroppedMessages() { return atomic_load(&async.dropped); }
+
+static void countMessage(int type) {
+	if(type < DCDI_CONTEXT_PUSH) {
+		ThreadState *thread = getThreadState();
+		DCdContext *context = &thread->contexts[thread->size - 1];
+		context->stats.total += 1;
+		*(&context->stats.debug + (size_t)type) += 1;
+		size_t count = atomic_load_explicit(&thread->counts[type], memory_order_relaxed);
+		atomic_store_explicit(&thread->counts[type], count + 1, memory_order_relaxed);
+	}
+}
+
+/** writes a message to the text sinks, directly or through the logging thread. */
+static void writeMessage(int type, const char *file, const char *func, int line, const char *fmt, va_list va) {
+	if((atomic_load_explicit(&sinkMask, memory_order_relaxed) & typeMask(type)) == 0) return;
+	size_t depth = getThreadState()->size;
+
+	if(atomic_load_explicit(&async.enabled, memory_order_relaxed)) {
+		// fatal messages are never dropped and are written before the fatal handler runs.
+		Slot *slot = claimSlot(async.policy == DCD_ASYNC_POLICY_DROP && type != DCD_MSG_TYPE_FATAL);
+		if(slot == NULL) {
+			atomic_fetch_add_explicit(&async.dropped, 1, memory_order_relaxed);
+			return;
+		}
+		Record *record = &slot->record;
+		*record = (Record){ .type = type, .file = file, .func = func, .line = line, .depth = depth, .time = time(NULL) };
+		vsnprintf(record->text, sizeof(record->text), fmt, va);
+		size_t position = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+		atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+		wakeLoggingThread();
+		return;
+	}
 
-		if(ISATTY(sinks[i])) fputs("\033[m\n", sinks[i]);
+	char timeString[26];
+	dcdiFormatTime(time(NULL), timeString);
+
+	pthread_mutex_lock(&sinkMutex);
+	for(size_t i = 0; i < sinkCount; ++i) {
+		if(!sinkAccepts(&sinks[i], type, file, func, line)) continue;
+		dcdiPrintPrefix(sinks[i].file, type, timeString, file, func, line, depth);
+		va_list copy;
+		va_copy(copy, va);
+		vfprintf(sinks[i].file, fmt, copy);
+		va_end(copy);
+		dcdiPrintSuffix(sinks[i].file);
 	}
+	pthread_mutex_unlock(&sinkMutex);
+}
 
-	if(type == DCD_MSG_TYPE_FATAL) fatalHandler();
+static void writeRing(int type, const char *file, const char *func, int line, const char *fmt, va_list va) {
+	va_list copy;
+	va_copy(copy, va);
+	dcdiWriteRing(type, file, func, line, getThreadState()->size, fmt, copy);
+	va_end(copy);
+}
+
+static void handleFatal() {
+	dcdFlush();
+	fatalHandler();
+}
+
+void dcdMsgV(DCdMsgType type, const char *file, const char *func, int line, const char *fmt, va_list va) {
+	if(!contextAccepts((int)type)) return;
+	countMessage((int)type);
+	writeRing((int)type, file, func, line, fmt, va);
+	if(dcdiBinarySinkOpen()) {
+		va_list copy;
+		va_copy(copy, va);
+		dcdiWriteBinaryText((int)type, file, func, line, getThreadState()->size, fmt, copy);
+		va_end(copy);
+		if(type != DCD_MSG_TYPE_FATAL) return;
+	}
+	writeMessage((int)type, file, func, line, fmt, va);
+	if(type == DCD_MSG_TYPE_FATAL) handleFatal();
+}
+
+void dcdMsgF(DCdMsgType type, const char *file, const char *func, int line, const char *fmt, ...) {
+	va_list va;
+	va_start(va, fmt);
+	dcdMsgV(type, file, func, line, fmt, va);
+	va_end(va);
+}
+
+void dcdMsgC(DCdCallsite *callsite, DCdMsgType type, ...) {
+	if(!contextAccepts((int)type)) return;
+	va_list va;
+	va_start(va, type);
+	if(!dcdiBinarySinkOpen()) {
+		dcdMsgV(type, callsite->file, callsite->func, callsite->line, callsite->fmt, va);
+		va_end(va);
+		return;
+	}
+
+	countMessage((int)type);
+	writeRing((int)type, callsite->file, callsite->func, callsite->line, callsite->fmt, va);
+	va_list copy;
+	va_copy(copy, va);
+	dcdiWriteBinaryMessage(callsite, (int)type, getThreadState()->size, copy);
+	va_end(copy);
+	if(type == DCD_MSG_TYPE_FATAL) {
+		writeMessage((int)type, callsite->file, callsite->func, callsite->line, callsite->fmt, va);
+		handleFatal();
+	}
+	va_end(va);
 }
 
 void dcdInit(const char *name) {
 	fatalHandler = &defaultFatalHandler;
 	sinkCount = 1;
-	sinks = malloc(sinkCount * sizeof(FILE *));
-	sinks[0] = stdout;
-	contextStack = NULL;
-	contextStackSize = 0;
-	dcdPushContextQuiet(name);
+	sinks = malloc(sinkCount * sizeof(Sink));
+	sinks[0] = (Sink){ stdout, DCD_MSG_MASK_ALL };
+	updateSinkMask();
+	// the calling thread gets name as its root context, threads that log later get it too.
+	rootName = name;
+	ThreadState *thread = getThreadState();
+	thread->contexts[0] = (DCdContext){ .name = name, .mask = DCD_MSG_MASK_ALL };
+	thread->size = 1;
 }
 
 void dcdAddSink(FILE *sink) {
-	sinks = realloc(sinks, ++sinkCount * sizeof(FILE *));
-	sinks[sinkCount - 1] = sink;
+	pthread_mutex_lock(&sinkMutex);
+	sinks = realloc(sinks, ++sinkCount * sizeof(Sink));
+	sinks[sinkCount - 1] = (Sink){ sink, DCD_MSG_MASK_ALL };
+	updateSinkMask();
+	pthread_mutex_unlock(&sinkMutex);
 }
 
-void dcdRemoveSink(FILE *sink) {
+static size_t findSink(FILE *sink) {
 	size_t pos = 0;
-	for(; pos <= sinkCount; ++pos)
-		if(pos < sinkCount && sinks[pos] == sink) break;
+	while(pos < sinkCount && sinks[pos].file != sink)
+		++pos;
+	return pos;
+}
+
+void dcdSetSinkFilter(FILE *sink, unsigned int mask, DCdSinkPredicate predicate, void *user) {
+	// queued messages are filtered when they are written, so they get the new filter.
+	pthread_mutex_lock(&sinkMutex);
+	size_t pos = findSink(sink);
+	if(pos == sinkCount) {
+		pthread_mutex_unlock(&sinkMutex);
+		DCD_WARNING("Tried to filter non-existing sink!");
+		return;
+	}
+	sinks[pos] = (Sink){ sink, mask, predicate, user };
+	updateSinkMask();
+	pthread_mutex_unlock(&sinkMutex);
+}
 
+void dcdRemoveSink(FILE *sink) {
+	// messages already queued for the sink are still written to it.
+	dcdFlush();
+	pthread_mutex_lock(&sinkMutex);
+	size_t pos = findSink(sink);
 	if(pos == sinkCount) {
+		pthread_mutex_unlock(&sinkMutex);
 		DCD_WARNING("Tried to remove non-existing sink!");
 		return;
 	}
@@ -139,13 +539,24 @@ void dcdRemoveSink(FILE *sink) {
 	for(size_t i = pos + 1; i < sinkCount; ++i)
 		sinks[i - 1] = sinks[i];
 
-	sinks = realloc(sinks, --sinkCount * sizeof(FILE *));
+	sinks = realloc(sinks, --sinkCount * sizeof(Sink));
+	updateSinkMask();
+	pthread_mutex_unlock(&sinkMutex);
 }
 
 void dcdDeInit() {
+	dcdCloseBinarySink();
+	dcdCloseRingSink();
+	dcdStopAsync();
+	dcdStopProfiling();
 	for(int i = 0; i < sinkCount; ++i)
-		printSepratator(sinks[i]);
+		printSepratator(sinks[i].file);
 
+	atomic_store(&sinkMask, 0);
 	if(sinks != NULL) free(sinks);
-	if(contextStack != NULL) free(contextStack);
+	if(threadState != NULL) {
+		pthread_setspecific(threadStateKey, NULL);
+		exitThread(threadState);
+	}
+	sinks = NULL, sinkCount = 0;
 }
@@ -0,0 +1,154 @@
+#include <dcore/debug.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTOGRAM_BUCKETS 16
+#define HISTOGRAM_BAR 40
+
+typedef struct Frame {
+	uint64_t number;
+	uint64_t values[DCD_FRAME_STAT_COUNT];
+} Frame;
+
+static struct {
+	pthread_mutex_t mutex;
+	Frame *frames;
+	size_t capacity;
+	uint64_t count; // number of frames recorded since the start.
+	uint64_t *scratch;
+} frameStats = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static const char *statNames[DCD_FRAME_STAT_COUNT] = { "cpu_ns", "wait_ns", "draws", "triangles", "allocations" };
+
+void dcdStartFrameStats(size_t capacity) {
+	pthread_mutex_lock(&frameStats.mutex);
+	free(frameStats.frames);
+	free(frameStats.scratch);
+	frameStats.capacity = capacity != 0 ? capacity : 1;
+	frameStats.frames = malloc(sizeof(Frame) * frameStats.capacity);
+	frameStats.scratch = malloc(sizeof(uint64_t) * frameStats.capacity);
+	frameStats.count = 0;
+	pthread_mutex_unlock(&frameStats.mutex);
+}
+
+void dcdStopFrameStats() {
+	pthread_mutex_lock(&frameStats.mutex);
+	free(frameStats.frames);
+	free(frameStats.scratch);
+	frameStats.frames = NULL, frameStats.scratch = NULL;
+	frameStats.capacity = 0, frameStats.count = 0;
+	pthread_mutex_unlock(&frameStats.mutex);
+}
+
+void dcdRecordFrame(const uint64_t values[DCD_FRAME_STAT_COUNT]) {
+	pthread_mutex_lock(&frameStats.mutex);
+	if(frameStats.frames != NULL) {
+		Frame *frame = &frameStats.frames[frameStats.count % frameStats.capacity];
+		frame->number = frameStats.count++;
+		memcpy(frame->values, values, sizeof(frame->values));
+	}
+	pthread_mutex_unlock(&frameStats.mutex);
+}
+
+/** number of frames in the ring, the mutex must be locked. */
+static size_t getFrameCount() { return frameStats.count < frameStats.capacity ? (size_t)frameStats.count : frameStats.capacity; }
+
+static int compareValues(const void *a, const void *b) {
+	uint64_t valueA = *(const uint64_t *)a, valueB = *(const uint64_t *)b;
+	return valueA < valueB ? -1 : valueA > valueB ? 1 : 0;
+}
+
+/** the value that percent of the sorted values are less than or equal to. */
+static uint64_t percentile(const uint64_t *sorted, size_t count, unsigned int percent) {
+	size_t rank = (count * percent + 99) / 100;
+	return sorted[rank != 0 ? rank - 1 : 0];
+}
+
+DCdFrameStatSummary dcdGetFrameStatSummary(DCdFrameStat stat) {
+	DCdFrameStatSummary summary = { 0 };
+	pthread_mutex_lock(&frameStats.mutex);
+	size_t count = getFrameCount();
+	if(count != 0) {
+		for(size_t i = 0; i < count; ++i)
+			frameStats.scratch[i] = frameStats.frames[i].values[stat];
+		qsort(frameStats.scratch, count, sizeof(uint64_t), compareValues);
+		summary = (DCdFrameStatSummary){
+			.frames = count,
+			.p50 = percentile(frameStats.scratch, count, 50),
+			.p95 = percentile(frameStats.scratch, count, 95),
+			.p99 = percentile(frameStats.scratch, count, 99),
+			.max = frameStats.scratch[count - 1],
+		};
+	}
+	pthread_mutex_unlock(&frameStats.mutex);
+	return summary;
+}
+
+uint64_t dcdGetFrameStatHistogram(DCdFrameStat stat, size_t *buckets, size_t bucketCount) {
+	memset(buckets, 0, sizeof(size_t) * bucketCount);
+	pthread_mutex_lock(&frameStats.mutex);
+	size_t count = getFrameCount();
+	uint64_t max = 0, width = 0;
+	for(size_t i = 0; i < count; ++i)
+		if(frameStats.frames[i].values[stat] > max) max = frameStats.frames[i].values[stat];
+	if(count != 0 && bucketCount != 0) {
+		width = max / bucketCount + 1;
+		for(size_t i = 0; i < count; ++i)
+			buckets[frameStats.frames[i].values[stat] / width] += 1;
+	}
+	pthread_mutex_unlock(&frameStats.mutex);
+	return width;
+}
+
+void dcdPrintFrameStats() {
+	DCdFrameStatSummary summaries[DCD_FRAME_STAT_COUNT];
+	for(int s = 0; s < DCD_FRAME_STAT_COUNT; ++s)
+		summaries[s] = dcdGetFrameStatSummary(s);
+	DCD_INFO("Stats of the last %zu frames:", summaries[0].frames);
+	for(int s = 0; s < DCD_FRAME_STAT_COUNT; ++s) {
+		const DCdFrameStatSummary *summary = &summaries[s];
+		if(s == DCD_FRAME_STAT_CPU_NS || s == DCD_FRAME_STAT_WAIT_NS)
+			DCD_INFO(
+			  "%-12s p50 %8.3f ms p95 %8.3f ms p99 %8.3f ms max %8.3f ms", statNames[s], summary->p50 / 1e6, summary->p95 / 1e6, summary->p99 / 1e6,
+			  summary->max / 1e6
+			);
+		else
+			DCD_INFO(
+			  "%-12s p50 %8llu    p95 %8llu    p99 %8llu    max %8llu", statNames[s], (unsigned long long)summary->p50, (unsigned long long)summary->p95,
+			  (unsigned long long)summary->p99, (unsigned long long)summary->max
+			);
+	}
+
+	size_t buckets[HISTOGRAM_BUCKETS], largest = 1;
+	uint64_t width = dcdGetFrameStatHistogram(DCD_FRAME_STAT_CPU_NS, buckets, HISTOGRAM_BUCKETS);
+	if(width == 0) return;
+	for(int b = 0; b < HISTOGRAM_BUCKETS; ++b)
+		if(buckets[b] > largest) largest = buckets[b];
+	char bar[HISTOGRAM_BAR + 1];
+	for(int b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+		size_t length = (buckets[b] * HISTOGRAM_BAR + largest - 1) / largest;
+		memset(bar, '#', length);
+		bar[length] = '\0';
+		DCD_INFO("%8.3f ms %6zu %s", (double)(width * b) / 1e6, buckets[b], bar);
+	}
+}
+
+bool dcdWriteFrameStatsCsv(FILE *file) {
+	fputs("frame", file);
+	for(int s = 0; s < DCD_FRAME_STAT_COUNT; ++s)
+		fprintf(file, ",%s", statNames[s]);
+	fputc('\n', file);
+	pthread_mutex_lock(&frameStats.mutex);
+	size_t count = getFrameCount();
+	for(uint64_t n = frameStats.count - count; n < frameStats.count; ++n) {
+		const Frame *frame = &frameStats.frames[n % frameStats.capacity];
+		fprintf(file, "%llu", (unsigned long long)frame->number);
+		for(int s = 0; s < DCD_FRAME_STAT_COUNT; ++s)
+			fprintf(file, ",%llu", (unsigned long long)frame->values[s]);
+		fputc('\n', file);
+	}
+	pthread_mutex_unlock(&frameStats.mutex);
+	return ferror(file) == 0;
+}
@@ -0,0 +1,42 @@
+#ifndef DCORE_DEBUG_INTERNAL_H
+#define DCORE_DEBUG_INTERNAL_H
+#include <dcore/debug.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+/** message types of context separators, they aren't counted in the stats. */
+#define DCDI_CONTEXT_PUSH 10000
+#define DCDI_CONTEXT_POP 10001
+
+/** layout of text sinks, also used to decode binary logs. */
+void dcdiFormatTime(time_t timer, char timeString[26]);
+void dcdiPrintPrefix(FILE *sink, int type, const char *timeString, const char *file, const char *func, int line, size_t depth);
+void dcdiPrintSuffix(FILE *sink);
+
+/** returns the name of the root context of the calling thread. */
+const char *dcdiGetThreadName();
+
+/** begins a zone for a pushed context if it's profiled, depth is the stack size with the context. */
+void dcdiProfilePushContext(const char *name, size_t depth, bool profile);
+
+/** ends the zone of a context that is popped, and the zones left open inside it. */
+void dcdiProfilePopContext(size_t depth);
+
+/** returns whether messages go to the binary sink. */
+bool dcdiBinarySinkOpen();
+
+/** writes a message from a callsite, its arguments are copied as they are. */
+void dcdiWriteBinaryMessage(DCdCallsite *callsite, int type, size_t depth, va_list va);
+
+/** writes a message that doesn't come from a callsite (context separators), formatted as text. */
+void dcdiWriteBinaryText(int type, const char *file, const char *func, int line, size_t depth, const char *fmt, va_list va);
+
+/** writes the buffered records of the calling thread to the file. */
+void dcdiFlushBinary();
+
+/** writes a message to the ring sink if it's open and takes the type. */
+void dcdiWriteRing(int type, const char *file, const char *func, int line, size_t depth, const char *fmt, va_list va);
+
+#endif
@@ -0,0 +1,286 @@
+#define _DEFAULT_SOURCE // clock_gettime
+#include <dcore/debug.h>
+#include <dcore/debug/internal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#	include <x86intrin.h>
+#	define TSC
+#endif
+
+/** deeper zones aren't recorded, but still have to be ended. */
+#define MAX_ZONE_DEPTH 64
+
+typedef struct Event {
+	const char *name;
+	uint64_t begin, end; // ticks
+} Event;
+
+/** the events of a thread, the oldest are overwritten when it's full. only the thread writes to it. */
+typedef struct Ring {
+	atomic_size_t head; // number of events written.
+	size_t mask;
+	uint32_t thread;
+	const char *threadName;
+	struct Ring *next;
+	Event events[];
+} Ring;
+
+/** a zone that hasn't ended yet. */
+typedef struct Zone {
+	const char *name;
+	uint64_t begin; // 0 if the zone isn't recorded.
+	size_t context; // depth of the context that began the zone, 0 for DCD_BEGIN_ZONE.
+} Zone;
+
+static struct {
+	atomic_bool enabled;
+	atomic_uint generation; // rings of an older generation were freed.
+	size_t capacity;
+	pthread_mutex_t mutex;
+	Ring *rings;
+	uint32_t threadCount;
+	uint64_t startTicks, startNs;
+	_Atomic uint64_t frameBegin, previousFrameBegin;
+	DCdZoneSummary *externalZones;
+	size_t externalZoneCount;
+} profiler = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local Zone zones[MAX_ZONE_DEPTH];
+static _Thread_local size_t zoneDepth;
+static _Thread_local Ring *threadRing;
+static _Thread_local unsigned int threadRingGeneration;
+
+static uint64_t monotonicNs() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+/** the time stamp counter on x86 (constant rate on every CPU of the last decade), nanoseconds elsewhere. */
+static inline uint64_t readTicks() {
+#if defined(TSC)
+	return __rdtsc();
+#else
+	return monotonicNs();
+#endif
+}
+
+/** measures the tick rate against the monotonic clock over the whole session, at least a millisecond. */
+static double getNsPerTick() {
+#if defined(TSC)
+	uint64_t ns, ticks;
+	do {
+		ns = monotonicNs();
+		ticks = readTicks();
+	} while(ns - profiler.startNs < 1000000);
+	return (double)(ns - profiler.startNs) / (double)(ticks - profiler.startTicks);
+#else
+	return 1.0;
+#endif
+}
+
+static Ring *getRing() {
+	unsigned int generation = atomic_load_explicit(&profiler.generation, memory_order_acquire);
+	if(threadRing != NULL && threadRingGeneration == generation) return threadRing;
+
+	Ring *ring = malloc(sizeof(Ring) + sizeof(Event) * profiler.capacity);
+	if(ring == NULL) return NULL;
+	atomic_init(&ring->head, 0);
+	ring->mask = profiler.capacity - 1;
+	ring->threadName = dcdiGetThreadName();
+	pthread_mutex_lock(&profiler.mutex);
+	ring->thread = ++profiler.threadCount;
+	ring->next = profiler.rings;
+	profiler.rings = ring;
+	pthread_mutex_unlock(&profiler.mutex);
+	threadRing = ring, threadRingGeneration = generation;
+	return ring;
+}
+
+static void recordEvent(const char *name, uint64_t begin, uint64_t end) {
+	if(!atomic_load_explicit(&profiler.enabled, memory_order_relaxed)) return;
+	Ring *ring = getRing();
+	if(ring == NULL) return;
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	ring->events[head & ring->mask] = (Event){ name, begin, end };
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static void beginZone(const char *name, size_t context) {
+	if(zoneDepth < MAX_ZONE_DEPTH) {
+		bool recorded = atomic_load_explicit(&profiler.enabled, memory_order_relaxed) && dcdGetCurrentContext()->profile;
+		zones[zoneDepth] = (Zone){ name, recorded ? readTicks() : 0, context };
+	}
+	++zoneDepth;
+}
+
+void dcdBeginZone(const char *name) { beginZone(name, 0); }
+
+void dcdEndZone() {
+	if(zoneDepth == 0) return;
+	if(--zoneDepth < MAX_ZONE_DEPTH && zones[zoneDepth].begin != 0) recordEvent(zones[zoneDepth].name, zones[zoneDepth].begin, readTicks());
+}
+
+void dcdiProfilePushContext(const char *name, size_t depth, bool profile) {
+	if(profile && atomic_load_explicit(&profiler.enabled, memory_order_relaxed)) beginZone(name, depth);
+}
+
+void dcdiProfilePopContext(size_t depth) {
+	// zones left open inside the context end with it.
+	for(size_t i = zoneDepth < MAX_ZONE_DEPTH ? zoneDepth : MAX_ZONE_DEPTH; i-- > 0;) {
+		if(zones[i].context == depth) {
+			while(zoneDepth > i)
+				dcdEndZone();
+			return;
+		}
+		if(zones[i].context != 0 && zones[i].context < depth) return;
+	}
+}
+
+void dcdStartProfiling(size_t capacity) {
+	if(atomic_load(&profiler.enabled)) return;
+	profiler.capacity = 2;
+	while(profiler.capacity < capacity)
+		profiler.capacity *= 2;
+	profiler.startNs = monotonicNs();
+	profiler.startTicks = readTicks();
+	atomic_store(&profiler.frameBegin, 0);
+	atomic_store(&profiler.previousFrameBegin, 0);
+	atomic_fetch_add_explicit(&profiler.generation, 1, memory_order_release);
+	atomic_store(&profiler.enabled, true);
+}
+
+void dcdStopProfiling() {
+	if(!atomic_exchange(&profiler.enabled, false)) return;
+	pthread_mutex_lock(&profiler.mutex);
+	while(profiler.rings != NULL) {
+		Ring *next = profiler.rings->next;
+		free(profiler.rings);
+		profiler.rings = next;
+	}
+	profiler.threadCount = 0;
+	free(profiler.externalZones);
+	profiler.externalZones = NULL;
+	profiler.externalZoneCount = 0;
+	pthread_mutex_unlock(&profiler.mutex);
+}
+
+void dcdSetExternalFrameZones(const char *track, const DCdZoneSummary *zones, size_t count) {
+	if(!atomic_load(&profiler.enabled)) return;
+	pthread_mutex_lock(&profiler.mutex);
+	profiler.externalZones = realloc(profiler.externalZones, sizeof(DCdZoneSummary) * (count != 0 ? count : 1));
+	for(size_t i = 0; i < count; ++i) {
+		profiler.externalZones[i] = zones[i];
+		profiler.externalZones[i].track = track;
+	}
+	profiler.externalZoneCount = count;
+	pthread_mutex_unlock(&profiler.mutex);
+}
+
+void dcdMarkFrame() {
+	atomic_store_explicit(&profiler.previousFrameBegin, atomic_load_explicit(&profiler.frameBegin, memory_order_relaxed), memory_order_relaxed);
+	atomic_store_explicit(&profiler.frameBegin, readTicks(), memory_order_relaxed);
+}
+
+/** runs the body for every event still in the rings, the mutex must be locked. */
+#define FOR_EACH_EVENT(RING, EVENT, ...) \
+	for(Ring *RING = profiler.rings; RING != NULL; RING = RING->next) { \
+		size_t head_ = atomic_load_explicit(&RING->head, memory_order_acquire); \
+		for(size_t i_ = head_ > RING->mask ? head_ - RING->mask - 1 : 0; i_ < head_; ++i_) { \
+			const Event *EVENT = &RING->events[i_ & RING->mask]; \
+			__VA_ARGS__ \
+		} \
+	}
+
+static int compareSummaries(const void *a, const void *b) {
+	uint64_t totalA = ((const DCdZoneSummary *)a)->totalNs, totalB = ((const DCdZoneSummary *)b)->totalNs;
+	return totalA < totalB ? 1 : totalA > totalB ? -1 : 0;
+}
+
+size_t dcdGetFrameZones(DCdZoneSummary *summaries, size_t maxSummaries) {
+	uint64_t frameBegin = atomic_load_explicit(&profiler.previousFrameBegin, memory_order_relaxed);
+	uint64_t frameEnd = atomic_load_explicit(&profiler.frameBegin, memory_order_relaxed);
+	if(!atomic_load(&profiler.enabled) || frameBegin == 0) return 0;
+
+	double nsPerTick = getNsPerTick();
+	size_t count = 0, capacity = 16;
+	DCdZoneSummary *all = malloc(sizeof(DCdZoneSummary) * capacity);
+	pthread_mutex_lock(&profiler.mutex);
+	FOR_EACH_EVENT(ring, event, {
+		if(event->begin < frameBegin || event->begin >= frameEnd) continue;
+		size_t s = 0;
+		while(s < count && all[s].name != event->name && strcmp(all[s].name, event->name) != 0)
+			++s;
+		if(s == count) {
+			if(count == capacity) all = realloc(all, sizeof(DCdZoneSummary) * (capacity *= 2));
+			all[count++] = (DCdZoneSummary){ .name = event->name };
+		}
+		uint64_t duration = (uint64_t)((double)(event->end - event->begin) * nsPerTick);
+		all[s].count += 1;
+		all[s].totalNs += duration;
+		if(duration > all[s].maxNs) all[s].maxNs = duration;
+	})
+	if(profiler.externalZoneCount != 0) {
+		all = realloc(all, sizeof(DCdZoneSummary) * (count + profiler.externalZoneCount));
+		memcpy(all + count, profiler.externalZones, sizeof(DCdZoneSummary) * profiler.externalZoneCount);
+		count += profiler.externalZoneCount;
+	}
+	pthread_mutex_unlock(&profiler.mutex);
+
+	qsort(all, count, sizeof(DCdZoneSummary), compareSummaries);
+	if(maxSummaries != 0) memcpy(summaries, all, sizeof(DCdZoneSummary) * (count < maxSummaries ? count : maxSummaries));
+	free(all);
+	return count;
+}
+
+void dcdPrintFrameZones() {
+	DCdZoneSummary summaries[32];
+	size_t count = dcdGetFrameZones(summaries, 32);
+	DCD_INFO("Zones of the last frame:");
+	for(size_t i = 0; i < count && i < 32; ++i)
+		DCD_INFO(
+		  "%-4s %-32s %6zu calls %10.3f ms total %10.3f ms max", summaries[i].track != NULL ? summaries[i].track : "cpu", summaries[i].name,
+		  summaries[i].count, summaries[i].totalNs / 1e6, summaries[i].maxNs / 1e6
+		);
+	if(count > 32) DCD_INFO("%zu more zones.", count - 32);
+}
+
+static void writeJsonString(FILE *file, const char *string) {
+	fputc('"', file);
+	for(const char *c = string; *c != '\0'; ++c) {
+		if(*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+		else if((unsigned char)*c < 0x20) fprintf(file, "\\u%04x", *c);
+		else fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool dcdWriteChromeTrace(FILE *file) {
+	if(!atomic_load(&profiler.enabled)) return false;
+	double usPerTick = getNsPerTick() / 1000.0;
+	bool first = true;
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+	pthread_mutex_lock(&profiler.mutex);
+	for(Ring *ring = profiler.rings; ring != NULL; ring = ring->next) {
+		fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",", ring->thread);
+		writeJsonString(file, ring->threadName);
+		fputs("}}", file);
+		first = false;
+	}
+	FOR_EACH_EVENT(ring, event, {
+		fputs(",\n{\"name\":", file);
+		writeJsonString(file, event->name);
+		fprintf(
+		  file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", ring->thread, (double)(event->begin - profiler.startTicks) * usPerTick,
+		  (double)(event->end - event->begin) * usPerTick
+		);
+	})
+	pthread_mutex_unlock(&profiler.mutex);
+	fputs("\n]}\n", file);
+	return ferror(file) == 0;
+}
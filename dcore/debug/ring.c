@@ -0,0 +1,213 @@
+#define _DEFAULT_SOURCE // clock_gettime, ftruncate
+#include <dcore/debug/binary.h>
+#include <dcore/debug/internal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if !defined(_WIN32)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+/**
+ * layout of ring files: a header of 64 bytes, then capacity bytes of records. a record starts at a multiple of 8 and
+ * can wrap around the end of the ring. the cursor in the header counts the bytes reserved since the file was created,
+ * a record reserved at cursor c lies at c % capacity. the first word of a record is its position (the cursor it was
+ * reserved at) and is written last, so a record that was overwritten or not finished doesn't have its own position.
+ **/
+#define RING_MAGIC "DCDRING1"
+#define RING_MIN_CAPACITY (64 * 1024)
+#define RING_MAX_STRING 255
+#define RING_MAX_TEXT 1024
+
+typedef struct RingHeader {
+	char magic[8];
+	uint64_t capacity;
+	_Atomic uint64_t cursor;
+	uint64_t unused[5];
+} RingHeader;
+
+typedef struct RingRecord {
+	uint64_t position;
+	uint32_t size; // including this header and the padding to a multiple of 8.
+	uint8_t type;  // DCdMsgType or a context separator type of binary.h.
+	uint8_t unused;
+	uint16_t depth;
+	uint64_t time; // ns since the epoch.
+	uint32_t line;
+	uint16_t fileLength, funcLength, textLength; // the strings follow without their nulls.
+} RingRecord;
+
+static struct {
+	atomic_uint mask; // 0 while no ring is open.
+	RingHeader *header;
+	uint8_t *records;
+	size_t mapSize;
+	int fd;
+} ring;
+
+static uint64_t now() {
+	struct timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+/** copies into the ring at a position, wrapping at its end. */
+static void copyIn(uint64_t position, const void *data, size_t size) {
+	size_t capacity = ring.header->capacity, offset = (size_t)(position % capacity), first = capacity - offset < size ? capacity - offset : size;
+	memcpy(ring.records + offset, data, first);
+	memcpy(ring.records, (const uint8_t *)data + first, size - first);
+}
+
+static size_t putString(uint8_t *dst, const char *string, size_t maxLength) {
+	size_t length = strlen(string);
+	if(length > maxLength) length = maxLength;
+	memcpy(dst, string, length);
+	return length;
+}
+
+void dcdiWriteRing(int type, const char *file, const char *func, int line, size_t depth, const char *fmt, va_list va) {
+	unsigned int typeMask = type >= DCDI_CONTEXT_PUSH ? DCD_MSG_MASK(INFO) : 1u << type;
+	if((atomic_load_explicit(&ring.mask, memory_order_relaxed) & typeMask) == 0) return;
+
+	_Alignas(8) uint8_t data[sizeof(RingRecord) + 2 * RING_MAX_STRING + RING_MAX_TEXT + 8];
+	RingRecord *record = (RingRecord *)data;
+	uint8_t *strings = data + sizeof(RingRecord);
+	record->fileLength = (uint16_t)putString(strings, file, RING_MAX_STRING);
+	record->funcLength = (uint16_t)putString(strings + record->fileLength, func, RING_MAX_STRING);
+	char *text = (char *)strings + record->fileLength + record->funcLength;
+	int length = vsnprintf(text, RING_MAX_TEXT + 1, fmt, va);
+	record->textLength = length < 0 ? 0 : length > RING_MAX_TEXT ? RING_MAX_TEXT : (uint16_t)length;
+	record->type = type == DCDI_CONTEXT_PUSH ? DCDI_BINARY_TYPE_CONTEXT_PUSH : type == DCDI_CONTEXT_POP ? DCDI_BINARY_TYPE_CONTEXT_POP : (uint8_t)type;
+	record->unused = 0;
+	record->depth = (uint16_t)depth;
+	record->time = now();
+	record->line = (uint32_t)line;
+	size_t size = sizeof(RingRecord) + record->fileLength + record->funcLength + record->textLength;
+	record->size = (uint32_t)((size + 7) & ~(size_t)7);
+	memset(data + size, 0, record->size - size);
+
+	// writers only compete for the cursor, the position is published once the rest of the record is in place.
+	uint64_t position = atomic_fetch_add_explicit(&ring.header->cursor, record->size, memory_order_relaxed);
+	copyIn(position + sizeof(uint64_t), data + sizeof(uint64_t), record->size - sizeof(uint64_t));
+	atomic_store_explicit((_Atomic uint64_t *)(ring.records + position % ring.header->capacity), position, memory_order_release);
+}
+
+bool dcdOpenRingSink(const char *path, size_t size, unsigned int mask) {
+#if defined(_WIN32)
+	DCD_WARNING("Ring sinks aren't supported on Windows yet.");
+	return false;
+#else
+	dcdCloseRingSink();
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE), capacity = size < RING_MIN_CAPACITY ? RING_MIN_CAPACITY : size;
+	size_t mapSize = (sizeof(RingHeader) + capacity + pageSize - 1) / pageSize * pageSize;
+	capacity = mapSize - sizeof(RingHeader);
+
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	struct stat info;
+	if(fd < 0 || fstat(fd, &info) != 0) {
+		DCD_ERROR("Failed to open the ring sink %s.", path);
+		if(fd >= 0) close(fd);
+		return false;
+	}
+	// a ring of the same size is continued, so the messages before a crash stay until they are overwritten.
+	bool resized = (size_t)info.st_size != mapSize;
+	if(resized && ftruncate(fd, (off_t)mapSize) != 0) {
+		DCD_ERROR("Failed to resize the ring sink %s.", path);
+		close(fd);
+		return false;
+	}
+	void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED) {
+		DCD_ERROR("Failed to map the ring sink %s.", path);
+		close(fd);
+		return false;
+	}
+
+	RingHeader *header = map;
+	if(resized || memcmp(header->magic, RING_MAGIC, sizeof(header->magic)) != 0 || header->capacity != capacity) {
+		memset(map, 0, mapSize);
+		memcpy(header->magic, RING_MAGIC, sizeof(header->magic));
+		header->capacity = capacity;
+		atomic_init(&header->cursor, 0);
+	}
+	ring.header = header, ring.records = (uint8_t *)map + sizeof(RingHeader), ring.mapSize = mapSize, ring.fd = fd;
+	atomic_store_explicit(&ring.mask, mask, memory_order_release);
+	return true;
+#endif
+}
+
+void dcdCloseRingSink() {
+#if !defined(_WIN32)
+	atomic_store(&ring.mask, 0);
+	if(ring.header == NULL) return;
+	munmap(ring.header, ring.mapSize);
+	close(ring.fd);
+	ring.header = NULL, ring.records = NULL;
+#endif
+}
+
+/** copies out of a ring read from a file, wrapping at its end. */
+static void copyOut(const uint8_t *records, size_t capacity, uint64_t position, void *data, size_t size) {
+	size_t offset = (size_t)(position % capacity), first = capacity - offset < size ? capacity - offset : size;
+	memcpy(data, records + offset, first);
+	memcpy((uint8_t *)data + first, records, size - first);
+}
+
+bool dcdReadRingLog(FILE *in, FILE *out, size_t count) {
+	RingHeader header;
+	if(fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, RING_MAGIC, sizeof(header.magic)) != 0) return false;
+	size_t capacity = (size_t)header.capacity;
+	uint64_t cursor = atomic_load(&header.cursor);
+	if(capacity < RING_MIN_CAPACITY || capacity % 8 != 0) return false;
+	uint8_t *records = malloc(capacity);
+	if(records == NULL || fread(records, 1, capacity, in) != capacity) {
+		free(records);
+		return false;
+	}
+
+	// records that began before the oldest byte still in the ring are lost, the first complete one is found by its position.
+	size_t positionCount = 0, positionCapacity = 64;
+	uint64_t *positions = malloc(sizeof(uint64_t) * positionCapacity);
+	uint64_t position = cursor > capacity ? (cursor - capacity + 7) & ~(uint64_t)7 : 0;
+	while(position + sizeof(RingRecord) <= cursor) {
+		RingRecord record;
+		copyOut(records, capacity, position, &record, sizeof(record));
+		size_t size = sizeof(RingRecord) + record.fileLength + record.funcLength + record.textLength;
+		bool complete = record.position == position && record.size % 8 == 0 && record.size >= size && record.size <= cursor - position;
+		if(!complete || record.fileLength > RING_MAX_STRING || record.funcLength > RING_MAX_STRING || record.textLength > RING_MAX_TEXT) {
+			position += 8;
+			continue;
+		}
+		if(positionCount == positionCapacity) positions = realloc(positions, sizeof(uint64_t) * (positionCapacity *= 2));
+		positions[positionCount++] = position;
+		position += record.size;
+	}
+
+	char file[RING_MAX_STRING + 1], func[RING_MAX_STRING + 1], text[RING_MAX_TEXT + 1], timeString[26];
+	for(size_t i = positionCount > count ? positionCount - count : 0; i < positionCount; ++i) {
+		RingRecord record;
+		copyOut(records, capacity, positions[i], &record, sizeof(record));
+		uint64_t strings = positions[i] + sizeof(RingRecord);
+		copyOut(records, capacity, strings, file, record.fileLength);
+		copyOut(records, capacity, strings + record.fileLength, func, record.funcLength);
+		copyOut(records, capacity, strings + record.fileLength + record.funcLength, text, record.textLength);
+		file[record.fileLength] = '\0', func[record.funcLength] = '\0', text[record.textLength] = '\0';
+		int type = record.type == DCDI_BINARY_TYPE_CONTEXT_PUSH ? DCDI_CONTEXT_PUSH
+		         : record.type == DCDI_BINARY_TYPE_CONTEXT_POP  ? DCDI_CONTEXT_POP
+		                                                        : record.type;
+		if(type > DCD_MSG_TYPE_SUCCESS && type < DCDI_CONTEXT_PUSH) continue;
+		dcdiFormatTime((time_t)(record.time / 1000000000u), timeString);
+		dcdiPrintPrefix(out, type, timeString, file, func, (int)record.line, record.depth);
+		fputs(text, out);
+		dcdiPrintSuffix(out);
+	}
+	free(positions);
+	free(records);
+	return true;
+}
@@ -2,6 +2,7 @@
 #define DCORE_GRAPHICS_H
 #include <dcore/common.h>
 #include <dcore/math/vector.h>
+#include <dcore/math/bvh.h>
 #include <stddef.h>
 
 typedef struct DCgState DCgState;
@@ -9,7 +10,7 @@ typedef struct DCgAlloc DCgAlloc;
 typedef struct DCgBuffer DCgBuffer;
 typedef struct DCgMaterial DCgMaterial;
 typedef struct DCgCmdBuffer DCgCmdBuffer;
-typedef void *DCgCmdPool;
+typedef struct DCgCmdPool DCgCmdPool;
 
 typedef DCgBuffer DCgVertexBuffer;
 typedef DCgBuffer DCgIndexBuffer;
@@ -39,36 +40,161 @@ void dcgClose(DCgState *state);
 /** Retries the position of the mouse relative to the window. */
 void dcgGetMousePosition(DCgState *state, DCmVector2i mousePosition);
 
+/**
+ * Retrieves the world space ray under the mouse, for picking with dcmBvhRaycast.
+ * @param inverseViewProjection inverse of the view projection matrix the scene is drawn with.
+ **/
+void dcgGetMouseRay(DCgState *state, DCmMatrix4x4f inverseViewProjection, DCmRay *ray);
+
 /** Updates the window. (polls for new events) */
 void dcgUpdate(DCgState *state);
 
+/**
+ * Starts a new frame, waits until the GPU is done with the frame that last used the same slot and resets its scratch memory.
+ * The previous frame is recorded in the frame stats (dcdStartFrameStats).
+ **/
+void dcgBeginFrame(DCgState *state);
+
+/** Ends the current frame, its slot can be reused once the GPU finished all work submitted before. */
+void dcgEndFrame(DCgState *state);
+
+/** lifetime of the host memory the Vulkan driver allocates, same values as VkSystemAllocationScope. */
+typedef enum DCgHostMemoryScope {
+	DCG_HOST_MEMORY_SCOPE_COMMAND,
+	DCG_HOST_MEMORY_SCOPE_OBJECT,
+	DCG_HOST_MEMORY_SCOPE_CACHE,
+	DCG_HOST_MEMORY_SCOPE_DEVICE,
+	DCG_HOST_MEMORY_SCOPE_INSTANCE,
+	DCG_HOST_MEMORY_SCOPE_COUNT,
+} DCgHostMemoryScope;
+
+/** host memory used by the Vulkan driver in a single scope. */
+typedef struct DCgHostMemoryStats {
+	size_t allocCount, reallocCount, freeCount, failedCount;
+	size_t liveBytes, peakBytes, totalBytes;
+	size_t internalBytes; // reported through the internal allocation notifications (executable memory).
+	size_t limit;         // 0 if unlimited.
+} DCgHostMemoryStats;
+
+/** Copies the driver host memory statistics of every scope into stats. */
+void dcgGetHostMemoryStats(DCgState *state, DCgHostMemoryStats stats[DCG_HOST_MEMORY_SCOPE_COUNT]);
+
+/** Prints the driver host memory statistics of every scope. */
+void dcgPrintHostMemoryStats(DCgState *state);
+
+/**
+ * Limits the live driver host memory of a scope, allocations past the limit fail with VK_ERROR_OUT_OF_HOST_MEMORY.
+ * @param limit maximum number of live bytes, 0 to remove the limit.
+ **/
+void dcgSetHostMemoryLimit(DCgState *state, DCgHostMemoryScope scope, size_t limit);
+
+/** how a buffer is used, same values as VkBufferUsageFlagBits. */
+typedef enum DCgBufferUsage {
+	DCG_BUFFER_USAGE_TRANSFER_SRC = 0x01,
+	DCG_BUFFER_USAGE_TRANSFER_DST = 0x02,
+	DCG_BUFFER_USAGE_UNIFORM = 0x10,
+	DCG_BUFFER_USAGE_STORAGE = 0x20,
+	DCG_BUFFER_USAGE_INDEX = 0x40,
+	DCG_BUFFER_USAGE_VERTEX = 0x80,
+	DCG_BUFFER_USAGE_INDIRECT = 0x100,
+} DCgBufferUsage;
+
+/** who accesses the memory of a resource, selects the memory type. */
+typedef enum DCgMemoryUsage {
+	DCG_MEMORY_USAGE_GPU_ONLY,   // device local, not mapped.
+	DCG_MEMORY_USAGE_CPU_TO_GPU, // host visible, persistently mapped, written by the CPU and read by the GPU.
+	DCG_MEMORY_USAGE_GPU_TO_CPU, // host visible (cached if possible), persistently mapped, read back by the CPU.
+} DCgMemoryUsage;
+
+/**
+ * Creates a buffer, its memory is sub-allocated from a large block of device memory.
+ * @param usage combination of DCgBufferUsage flags.
+ **/
+DCgBuffer *dcgNewBuffer(DCgState *state, size_t size, unsigned int usage, DCgMemoryUsage memoryUsage);
+
+/** Frees a buffer, the GPU must be done using it. */
+void dcgFreeBuffer(DCgState *state, DCgBuffer *buffer);
+
+/** Returns the persistent mapping of a host visible buffer, NULL for DCG_MEMORY_USAGE_GPU_ONLY buffers. */
+void *dcgGetBufferMapping(DCgState *state, DCgBuffer *buffer);
+
+/** Makes CPU writes to a mapped buffer range visible to the GPU, only needed for non-coherent memory. */
+void dcgFlushBuffer(DCgState *state, DCgBuffer *buffer, size_t offset, size_t size);
+
+/**
+ * Moves buffers out of sparsely used device memory blocks and frees the blocks that became empty.
+ * Waits until the device is idle, buffers keep their DCgBuffer but previously recorded commands that use them become invalid.
+ * @param maxMoves maximum number of buffers to move.
+ * @return number of buffers moved.
+ **/
+size_t dcgDefragmentDeviceMemory(DCgState *state, size_t maxMoves);
+
+/** Prints the device memory blocks and their usage. */
+void dcgPrintDeviceMemoryStats(DCgState *state);
+
 typedef enum DCgQueueFamilyType {
 	DCG_CMD_POOL_TYPE_GRAPHICS,
 	DCG_CMD_POOL_TYPE_COMPUTE,
 } DCgCmdPoolType;
 
+/**
+ * Creates a command pool, it holds a Vulkan command pool per frame in flight. The command buffers of a frame are
+ * recycled together, with a single vkResetCommandPool when the pool is used again DCG_FRAMES_IN_FLIGHT frames later.
+ * @note a pool must only be used by one thread at a time, record on several threads with a pool per thread.
+ * @note the frame fence only covers the graphics queue, work submitted to another queue must be done by the time the
+ * frame slot is reused.
+ **/
 DCgCmdPool *dcgNewCmdPool(DCgState *s, DCgCmdPoolType type);
+
+/** Frees a command pool and its command buffers, the GPU must be done using them. */
 void dcgFreeCmdPool(DCgState *s, DCgCmdPool *pool);
 
-/** Creates a new command buffer */
+/** Returns a command buffer for the current frame, valid until the frame slot is reused. Record it with dcgCmdBegin. */
 DCgCmdBuffer *dcgGetNewCmdBuffer(DCgState *s, DCgCmdPool *pool);
 
-/** Begin command */
+/** Begins recording, the command buffer is submitted once. */
 void dcgCmdBegin(DCgState *s, DCgCmdBuffer *cmds);
-/** Binds a vertex buffer */
+/** Binds a vertex buffer to binding 0, skipped if it's bound already. */
 void dcgCmdBindVertexBuf(DCgState *s, DCgCmdBuffer *cmds, DCgVertexBuffer *vbuf);
-/** Binds an index buffer */
+/** Binds an index buffer of 32 bit indices, skipped if it's bound already. */
 void dcgCmdBindIndexBuf(DCgState *s, DCgCmdBuffer *cmds, DCgIndexBuffer *ibuf);
-/** Binds a material (pipelines + stuff) */
+/** Binds the pipeline of a material, skipped if it's bound already. */
 void dcgCmdBindMat(DCgState *s, DCgCmdBuffer *cmds, DCgMaterial *mat);
 /** Draws some instances with the specified
  * number indices from the bound vertex/index buffers.
  * @param indices number of indices to draw per instance.
  * @param instances number of instances to draw. */
 void dcgCmdDraw(DCgState *s, DCgCmdBuffer *cmds, size_t indices, size_t instances);
-/** Submit a command buffer into a queue. */
+/**
+ * Ends recording and submits a command buffer to the queue of its pool, its draws are added to the frame stats.
+ * @param queue index of the queue in the family of the pool, only 0 is created.
+ **/
 void dcgSubmit(DCgState *s, DCgCmdBuffer *cmds, int queue);
 
+/** GPU time of a zone, relative to the first zone of its frame. */
+typedef struct DCgGpuZone {
+	const char *name;
+	uint32_t depth; // number of zones the zone is nested in.
+	uint64_t beginNs, durationNs;
+} DCgGpuZone;
+
+/**
+ * begins a GPU zone, timed with timestamp queries. zones can be recorded inside render passes and nest per command
+ * buffer, only zones of graphics command buffers are timed. zones are read back without waiting when the slot is
+ * reused, DCG_FRAMES_IN_FLIGHT frames later, and are reported with the CPU zones of dcdPrintFrameZones. nothing is
+ * timed if the graphics queue has no timestamps.
+ * @note zones of a frame have to be recorded by a single thread.
+ **/
+void dcgCmdBeginGpuZone(DCgState *s, DCgCmdBuffer *cmds, const char *name);
+/** ends the last GPU zone begun in the command buffer. */
+void dcgCmdEndGpuZone(DCgState *s, DCgCmdBuffer *cmds);
+
+/**
+ * returns the GPU zones that were read back last, in the order they began.
+ * @param frameNumber set to the frame the zones were recorded in, if not NULL.
+ **/
+size_t dcgGetGpuZones(DCgState *s, const DCgGpuZone **zones, uint64_t *frameNumber);
+
 typedef enum DCgPipelineStage {
 	DCG_SHADER_STAGE_VERTEX = 0x01,
 	DCG_SHADER_STAGE_GEOMETRY = 0x08,
@@ -115,7 +241,7 @@ typedef struct DCgMaterialOptions {
 	float minDepthBound, maxDepthBound;
 	bool enableStencilTest;
 	DCmExtent2 viewportExtent;
-	int pushConstantsIndex, descriptorSetsIndex, vertexInputIndex;
+	DCmemHandle pushConstants, descriptorSets, vertexInput; // handles returned by the renderer that registered them.
 } DCgMaterialOptions;
 
 typedef struct DCgMaterialCache DCgMaterialCache;
@@ -0,0 +1,486 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <string.h>
+
+#define FREE_BIT 0x80
+#define NO_UNIT UINT32_MAX
+
+static uint32_t ceilLog2(VkDeviceSize value) { return value <= 1 ? 0 : 64 - __builtin_clzll(value - 1); }
+
+static void pushFree(DCgiMemoryBlock *block, uint32_t unit, uint32_t order) {
+	block->orders[unit] = order | FREE_BIT;
+	block->prevFree[unit] = NO_UNIT;
+	block->nextFree[unit] = block->freeHeads[order];
+	if(block->freeHeads[order] != NO_UNIT) block->prevFree[block->freeHeads[order]] = unit;
+	block->freeHeads[order] = unit;
+}
+
+static void removeFree(DCgiMemoryBlock *block, uint32_t unit) {
+	uint32_t order = block->orders[unit] & ~FREE_BIT;
+	if(block->prevFree[unit] != NO_UNIT)
+		block->nextFree[block->prevFree[unit]] = block->nextFree[unit];
+	else
+		block->freeHeads[order] = block->nextFree[unit];
+	if(block->nextFree[unit] != NO_UNIT) block->prevFree[block->nextFree[unit]] = block->prevFree[unit];
+	block->orders[unit] = order;
+}
+
+/** takes the smallest free node that fits and splits it down to the order, returns NO_UNIT if the block is too full. */
+static uint32_t buddyAllocate(DCgiMemoryBlock *block, uint32_t order) {
+	uint32_t found = order;
+	while(found <= block->maxOrder && block->freeHeads[found] == NO_UNIT)
+		found += 1;
+	if(found > block->maxOrder) return NO_UNIT;
+
+	uint32_t unit = block->freeHeads[found];
+	removeFree(block, unit);
+	while(found > order) {
+		found -= 1;
+		pushFree(block, unit + (1u << found), found);
+	}
+
+	block->orders[unit] = order;
+	return unit;
+}
+
+/** frees a node and merges it with its buddy as long as the buddy is free too. */
+static void buddyFree(DCgiMemoryBlock *block, uint32_t unit) {
+	uint32_t order = block->orders[unit];
+	while(order < block->maxOrder) {
+		uint32_t buddy = unit ^ (1u << order);
+		if(block->orders[buddy] != (order | FREE_BIT)) break;
+		removeFree(block, buddy);
+		unit &= ~(1u << order);
+		order += 1;
+	}
+	pushFree(block, unit, order);
+}
+
+static uint32_t findMemoryType(DCgState *state, uint32_t typeBits, VkMemoryPropertyFlags properties) {
+	for(uint32_t i = 0; i < state->memoryProperties.memoryTypeCount; ++i)
+		if((typeBits & (1u << i)) && (state->memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) return i;
+	return UINT32_MAX;
+}
+
+/** regular block size of a memory type, small heaps (e.g. host visible device local memory) get smaller blocks. */
+static VkDeviceSize getBlockSize(DCgState *state, uint32_t memoryType) {
+	VkDeviceSize heapSize = state->memoryProperties.memoryHeaps[state->memoryProperties.memoryTypes[memoryType].heapIndex].size;
+	VkDeviceSize size = DCGI_MEMORY_BLOCK_SIZE;
+	while(size > (VkDeviceSize)1 << (DCGI_MEMORY_MIN_ORDER + 4) && size > heapSize / 8)
+		size /= 2;
+	return size;
+}
+
+static DCgiMemoryBlock *newBlock(DCgState *state, uint32_t memoryType, DCgiMemoryTiling tiling, VkDeviceSize size, bool dedicated) {
+	if(state->memoryBlockCount >= state->maxMemoryAllocationCount) {
+		DCD_ERROR("Reached maxMemoryAllocationCount (%u) device memory allocations.", state->maxMemoryAllocationCount);
+		return NULL;
+	}
+
+	VkMemoryAllocateInfo allocateInfo = { 0 };
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = size;
+	allocateInfo.memoryTypeIndex = memoryType;
+
+	VkDeviceMemory memory;
+	VkResult result = vkAllocateMemory(state->device, &allocateInfo, state->allocator, &memory);
+	if(result != VK_SUCCESS) {
+		DCD_ERROR("Failed to allocate %llu bytes of device memory (type %u): %d", (unsigned long long)size, memoryType, result);
+		return NULL;
+	}
+
+	// the free lists and orders of the buddy allocator are stored right after the block.
+	uint32_t units = dedicated ? 0 : (uint32_t)(size >> DCGI_MEMORY_MIN_ORDER);
+	DCgiMemoryBlock *block = dcmemAllocate(sizeof(DCgiMemoryBlock) + units * (2 * sizeof(uint32_t) + sizeof(uint8_t)));
+	*block = (DCgiMemoryBlock){ .memory = memory, .size = size, .memoryType = memoryType, .tiling = tiling, .dedicated = dedicated };
+	block->nextFree = (uint32_t *)(block + 1);
+	block->prevFree = block->nextFree + units;
+	block->orders = (uint8_t *)(block->prevFree + units);
+
+	if(!dedicated) {
+		memset(block->orders, 0, units);
+		for(size_t i = 0; i < DCGI_MEMORY_MAX_ORDERS; ++i)
+			block->freeHeads[i] = NO_UNIT;
+		block->maxOrder = ceilLog2(units);
+		pushFree(block, 0, block->maxOrder);
+	}
+
+	if(state->memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if(vkMapMemory(state->device, memory, 0, VK_WHOLE_SIZE, 0, (void **)&block->mapping) != VK_SUCCESS) {
+			DCD_WARNING("Failed to map host visible device memory.");
+			block->mapping = NULL;
+		}
+	}
+
+	// blocks are appended, so allocations fill the oldest blocks first and defragmentation empties the newest.
+	DCgiMemoryBlock **link = &state->memoryBlocks[memoryType][tiling];
+	while(*link != NULL)
+		link = &(*link)->next;
+	*link = block;
+
+	state->memoryBlockCount += 1;
+	return block;
+}
+
+static void freeBlock(DCgState *state, DCgiMemoryBlock *block) {
+	for(DCgiMemoryBlock **link = &state->memoryBlocks[block->memoryType][block->tiling]; *link != NULL; link = &(*link)->next) {
+		if(*link == block) {
+			*link = block->next;
+			break;
+		}
+	}
+
+	vkFreeMemory(state->device, block->memory, state->allocator); // implicitly unmaps.
+	dcmemDeallocate(block);
+	state->memoryBlockCount -= 1;
+}
+
+static bool allocateFromBlock(DCgiMemoryBlock *block, uint32_t order, VkDeviceSize size, DCgAlloc *alloc) {
+	if(block->dedicated || order > block->maxOrder) return false;
+	uint32_t unit = buddyAllocate(block, order);
+	if(unit == NO_UNIT) return false;
+
+	*alloc = (DCgAlloc){ .block = block, .offset = (VkDeviceSize)unit << DCGI_MEMORY_MIN_ORDER, .size = size };
+	block->usedBytes += (VkDeviceSize)1 << (order + DCGI_MEMORY_MIN_ORDER);
+	block->allocationCount += 1;
+	return true;
+}
+
+/** buddy nodes are aligned to their size, so the order covers both the size and the alignment. */
+static uint32_t getOrder(const VkMemoryRequirements *requirements) {
+	VkDeviceSize size = requirements->size > requirements->alignment ? requirements->size : requirements->alignment;
+	uint32_t order = ceilLog2(size);
+	return order > DCGI_MEMORY_MIN_ORDER ? order - DCGI_MEMORY_MIN_ORDER : 0;
+}
+
+bool dcgiAllocate(
+  DCgState *state, const VkMemoryRequirements *requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, DCgiMemoryTiling tiling,
+  DCgAlloc *alloc
+) {
+	uint32_t memoryType = findMemoryType(state, requirements->memoryTypeBits, required | preferred);
+	if(memoryType == UINT32_MAX) memoryType = findMemoryType(state, requirements->memoryTypeBits, required);
+	if(memoryType == UINT32_MAX) {
+		DCD_ERROR("No memory type with the properties %#x for memory type bits %#x.", required, requirements->memoryTypeBits);
+		return false;
+	}
+
+	VkDeviceSize blockSize = getBlockSize(state, memoryType);
+	uint32_t order = getOrder(requirements);
+	if(((VkDeviceSize)1 << (order + DCGI_MEMORY_MIN_ORDER)) > blockSize / 2) {
+		// big resources get their own allocation instead of wasting most of a block.
+		DCgiMemoryBlock *block = newBlock(state, memoryType, tiling, requirements->size, true);
+		if(block == NULL) return false;
+		block->usedBytes = requirements->size;
+		block->allocationCount = 1;
+		*alloc = (DCgAlloc){ .block = block, .offset = 0, .size = requirements->size };
+		return true;
+	}
+
+	for(DCgiMemoryBlock *block = state->memoryBlocks[memoryType][tiling]; block != NULL; block = block->next)
+		if(allocateFromBlock(block, order, requirements->size, alloc)) return true;
+
+	DCgiMemoryBlock *block = newBlock(state, memoryType, tiling, blockSize, false);
+	return block != NULL && allocateFromBlock(block, order, requirements->size, alloc);
+}
+
+void dcgiFree(DCgState *state, DCgAlloc *alloc) {
+	DCgiMemoryBlock *block = alloc->block;
+	if(block == NULL) return;
+	alloc->block = NULL;
+
+	if(block->dedicated) {
+		freeBlock(state, block);
+		return;
+	}
+
+	uint32_t unit = (uint32_t)(alloc->offset >> DCGI_MEMORY_MIN_ORDER);
+	block->usedBytes -= (VkDeviceSize)1 << (block->orders[unit] + DCGI_MEMORY_MIN_ORDER);
+	block->allocationCount -= 1;
+	buddyFree(block, unit);
+	// empty blocks are kept for the next allocations, dcgDefragmentDeviceMemory frees them.
+}
+
+void dcgiInitDeviceMemory(DCgState *state) {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(state->physicalDevice, &properties);
+	vkGetPhysicalDeviceMemoryProperties(state->physicalDevice, &state->memoryProperties);
+	state->nonCoherentAtomSize = properties.limits.nonCoherentAtomSize != 0 ? properties.limits.nonCoherentAtomSize : 1;
+	state->maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+	memset(state->memoryBlocks, 0, sizeof(state->memoryBlocks));
+	state->memoryBlockCount = 0;
+	state->buffers = NULL;
+}
+
+void dcgiFreeDeviceMemory(DCgState *state) {
+	size_t leaked = 0;
+	while(state->buffers != NULL) {
+		dcgFreeBuffer(state, state->buffers);
+		leaked += 1;
+	}
+	if(leaked != 0) DCD_WARNING("%zu buffers weren't freed.", leaked);
+
+	for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+		for(size_t j = 0; j < DCGI_MEMORY_TILING_COUNT; ++j)
+			while(state->memoryBlocks[i][j] != NULL)
+				freeBlock(state, state->memoryBlocks[i][j]);
+}
+
+static VkBuffer createBuffer(DCgState *state, VkDeviceSize size, VkBufferUsageFlags usage, DCgAlloc *alloc) {
+	VkBufferCreateInfo createInfo = { 0 };
+	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	createInfo.size = size;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	DC_RVASSERT(vkCreateBuffer(state->device, &createInfo, state->allocator, &buffer) == VK_SUCCESS, "Failed to create buffer", VK_NULL_HANDLE);
+	if(alloc->block != NULL && vkBindBufferMemory(state->device, buffer, alloc->block->memory, alloc->offset) != VK_SUCCESS) {
+		DCD_ERROR("Failed to bind buffer memory.");
+		vkDestroyBuffer(state->device, buffer, state->allocator);
+		return VK_NULL_HANDLE;
+	}
+	return buffer;
+}
+
+static void getMemoryProperties(DCgMemoryUsage usage, VkMemoryPropertyFlags *required, VkMemoryPropertyFlags *preferred) {
+	switch(usage) {
+	case DCG_MEMORY_USAGE_GPU_ONLY:
+		*required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		*preferred = 0;
+		break;
+	case DCG_MEMORY_USAGE_CPU_TO_GPU:
+		*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		*preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		break;
+	case DCG_MEMORY_USAGE_GPU_TO_CPU:
+		*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		*preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		break;
+	}
+}
+
+DCgBuffer *dcgNewBuffer(DCgState *state, size_t size, unsigned int usage, DCgMemoryUsage memoryUsage) {
+	DCgBuffer *buffer = DCMEM_POOL_ALLOCATE(&state->bufferPool, DCgBuffer);
+	buffer->size = size;
+	buffer->memoryUsage = memoryUsage;
+	buffer->usage = usage;
+	// device local buffers can only be moved by the GPU.
+	if(memoryUsage == DCG_MEMORY_USAGE_GPU_ONLY) buffer->usage |= DCG_BUFFER_USAGE_TRANSFER_SRC | DCG_BUFFER_USAGE_TRANSFER_DST;
+	buffer->alloc = (DCgAlloc){ 0 };
+
+	buffer->buffer = createBuffer(state, size, buffer->usage, &buffer->alloc);
+	if(buffer->buffer == VK_NULL_HANDLE) {
+		dcmemPoolDeallocate(&state->bufferPool, buffer);
+		return NULL;
+	}
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(state->device, buffer->buffer, &requirements);
+
+	VkMemoryPropertyFlags required, preferred;
+	getMemoryProperties(memoryUsage, &required, &preferred);
+	bool allocated = dcgiAllocate(state, &requirements, required, preferred, DCGI_MEMORY_TILING_LINEAR, &buffer->alloc);
+	if(!allocated || vkBindBufferMemory(state->device, buffer->buffer, buffer->alloc.block->memory, buffer->alloc.offset) != VK_SUCCESS) {
+		if(allocated) {
+			DCD_ERROR("Failed to bind buffer memory.");
+			dcgiFree(state, &buffer->alloc);
+		}
+		vkDestroyBuffer(state->device, buffer->buffer, state->allocator);
+		dcmemPoolDeallocate(&state->bufferPool, buffer);
+		return NULL;
+	}
+
+	buffer->prev = NULL;
+	buffer->next = state->buffers;
+	if(state->buffers != NULL) state->buffers->prev = buffer;
+	state->buffers = buffer;
+	return buffer;
+}
+
+void dcgFreeBuffer(DCgState *state, DCgBuffer *buffer) {
+	DEBUGIF(buffer == NULL) {
+		DCD_MSGF(ERROR, "Tried to free NULL buffer");
+		return;
+	}
+
+	if(buffer->prev != NULL)
+		buffer->prev->next = buffer->next;
+	else
+		state->buffers = buffer->next;
+	if(buffer->next != NULL) buffer->next->prev = buffer->prev;
+
+	vkDestroyBuffer(state->device, buffer->buffer, state->allocator);
+	dcgiFree(state, &buffer->alloc);
+	dcmemPoolDeallocate(&state->bufferPool, buffer);
+}
+
+void *dcgGetBufferMapping(DCgState *state, DCgBuffer *buffer) {
+	// GPU only memory is host visible on UMA devices too, its mapping isn't handed out so it stays GPU only everywhere.
+	if(buffer->memoryUsage == DCG_MEMORY_USAGE_GPU_ONLY || buffer->alloc.block->mapping == NULL) return NULL;
+	return buffer->alloc.block->mapping + buffer->alloc.offset;
+}
+
+void dcgFlushBuffer(DCgState *state, DCgBuffer *buffer, size_t offset, size_t size) {
+	DCgiMemoryBlock *block = buffer->alloc.block;
+	if(state->memoryProperties.memoryTypes[block->memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return;
+
+	// flushed ranges must be aligned to nonCoherentAtomSize.
+	VkDeviceSize atom = state->nonCoherentAtomSize;
+	VkDeviceSize begin = (buffer->alloc.offset + offset) / atom * atom;
+	VkDeviceSize end = (buffer->alloc.offset + offset + size + atom - 1) / atom * atom;
+	if(end > block->size) end = block->size;
+
+	VkMappedMemoryRange range = { 0 };
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = block->memory;
+	range.offset = begin;
+	range.size = end - begin;
+	vkFlushMappedMemoryRanges(state->device, 1, &range);
+}
+
+/** moves an allocation into a block that is at least as full as its current one, the old allocation isn't freed. */
+static bool moveAlloc(DCgState *state, const DCgAlloc *from, DCgAlloc *to) {
+	DCgiMemoryBlock *source = from->block;
+	uint32_t order = source->orders[from->offset >> DCGI_MEMORY_MIN_ORDER];
+	for(DCgiMemoryBlock *block = state->memoryBlocks[source->memoryType][source->tiling]; block != NULL; block = block->next)
+		if(block != source && block->usedBytes >= source->usedBytes && allocateFromBlock(block, order, from->size, to)) return true;
+	return false;
+}
+
+/** a copy by the GPU, the buffer is only switched to the new buffer once the copy is done. */
+typedef struct PendingMove {
+	DCgBuffer *buffer;
+	VkBuffer newBuffer;
+	DCgAlloc alloc;
+} PendingMove;
+
+/** creates a command pool with a command buffer that was begun, returns false if any step fails. */
+static bool beginCopies(DCgState *state, VkCommandPool *commandPool, VkCommandBuffer *commandBuffer) {
+	VkCommandPoolCreateInfo poolInfo = { 0 };
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = state->graphicsQueueFamily;
+	if(vkCreateCommandPool(state->device, &poolInfo, state->allocator, commandPool) != VK_SUCCESS) {
+		*commandPool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkCommandBufferAllocateInfo allocateInfo = { 0 };
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = *commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	if(vkAllocateCommandBuffers(state->device, &allocateInfo, commandBuffer) != VK_SUCCESS) return false;
+
+	VkCommandBufferBeginInfo beginInfo = { 0 };
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	return vkBeginCommandBuffer(*commandBuffer, &beginInfo) == VK_SUCCESS;
+}
+
+/** submits the copies and waits for them, returns false if they may not have been done. */
+static bool submitCopies(DCgState *state, VkCommandBuffer commandBuffer) {
+	if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) return false;
+	VkSubmitInfo submitInfo = { 0 };
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	VkQueue queue = dcgiGetQueue(state, state->graphicsQueueFamily);
+	return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS && vkQueueWaitIdle(queue) == VK_SUCCESS;
+}
+
+size_t dcgDefragmentDeviceMemory(DCgState *state, size_t maxMoves) {
+	vkDeviceWaitIdle(state->device);
+
+	// device local buffers are copied by the GPU, the command buffer is set up before anything is moved so a failure
+	// leaves nothing half moved. without it only host visible buffers are moved.
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	bool canCopy = beginCopies(state, &commandPool, &commandBuffer);
+	if(!canCopy) DCD_WARNING("Failed to record the copies of the defragmentation, device local buffers aren't moved.");
+
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+	size_t bufferCount = 0, pendingCount = 0, moves = 0;
+	for(DCgBuffer *counted = state->buffers; counted != NULL; counted = counted->next)
+		bufferCount += 1;
+	PendingMove *pending = DCMEM_PUSH_ARRAY(scratch, PendingMove, maxMoves < bufferCount ? maxMoves : bufferCount);
+
+	for(DCgBuffer *buffer = state->buffers; buffer != NULL && moves < maxMoves; buffer = buffer->next) {
+		DCgiMemoryBlock *block = buffer->alloc.block;
+		// only sparse blocks are evacuated, into fuller blocks, so that they end up empty and can be freed.
+		if(block->dedicated || block->usedBytes * 2 > block->size || (block->mapping == NULL && !canCopy)) continue;
+
+		DCgAlloc alloc;
+		if(!moveAlloc(state, &buffer->alloc, &alloc)) continue;
+		VkBuffer newBuffer = createBuffer(state, buffer->size, buffer->usage, &alloc);
+		if(newBuffer == VK_NULL_HANDLE) {
+			dcgiFree(state, &alloc);
+			continue;
+		}
+		moves += 1;
+
+		if(block->mapping != NULL) {
+			memcpy(alloc.block->mapping + alloc.offset, block->mapping + buffer->alloc.offset, buffer->size);
+			vkDestroyBuffer(state->device, buffer->buffer, state->allocator);
+			dcgiFree(state, &buffer->alloc);
+			buffer->buffer = newBuffer;
+			buffer->alloc = alloc;
+		} else {
+			VkBufferCopy region = { .srcOffset = 0, .dstOffset = 0, .size = buffer->size };
+			vkCmdCopyBuffer(commandBuffer, buffer->buffer, newBuffer, 1, &region);
+			pending[pendingCount++] = (PendingMove){ .buffer = buffer, .newBuffer = newBuffer, .alloc = alloc };
+		}
+	}
+
+	// if the copies failed the buffers keep their memory and the new buffers are dropped.
+	bool copied = pendingCount == 0 || submitCopies(state, commandBuffer);
+	if(!copied) {
+		DCD_ERROR("Failed to submit the copies of the defragmentation, %zu buffers weren't moved.", pendingCount);
+		vkDeviceWaitIdle(state->device);
+		moves -= pendingCount;
+	}
+	for(size_t i = 0; i < pendingCount; ++i) {
+		DCgBuffer *buffer = pending[i].buffer;
+		if(copied) {
+			vkDestroyBuffer(state->device, buffer->buffer, state->allocator);
+			dcgiFree(state, &buffer->alloc);
+			buffer->buffer = pending[i].newBuffer;
+			buffer->alloc = pending[i].alloc;
+		} else {
+			vkDestroyBuffer(state->device, pending[i].newBuffer, state->allocator);
+			dcgiFree(state, &pending[i].alloc);
+		}
+	}
+	// destroying the pool frees the command buffer.
+	if(commandPool != VK_NULL_HANDLE) vkDestroyCommandPool(state->device, commandPool, state->allocator);
+	dcmemRestoreArenaMarker(scratch, marker);
+
+	for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+		for(size_t j = 0; j < DCGI_MEMORY_TILING_COUNT; ++j) {
+			DCgiMemoryBlock *block = state->memoryBlocks[i][j];
+			while(block != NULL) {
+				DCgiMemoryBlock *next = block->next;
+				if(block->allocationCount == 0) freeBlock(state, block);
+				block = next;
+			}
+		}
+	}
+
+	return moves;
+}
+
+void dcgPrintDeviceMemoryStats(DCgState *state) {
+	DCD_INFO("Device memory: %zu allocations (max %u)", state->memoryBlockCount, state->maxMemoryAllocationCount);
+	for(uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i) {
+		for(size_t j = 0; j < DCGI_MEMORY_TILING_COUNT; ++j) {
+			for(DCgiMemoryBlock *block = state->memoryBlocks[i][j]; block != NULL; block = block->next) {
+				DCD_INFO(
+				  "type %u%s%s: %llu/%llu bytes used by %zu allocations", i, j == DCGI_MEMORY_TILING_OPTIMAL ? " (optimal)" : "",
+				  block->dedicated ? " (dedicated)" : "", (unsigned long long)block->usedBytes, (unsigned long long)block->size, block->allocationCount
+				);
+			}
+		}
+	}
+}
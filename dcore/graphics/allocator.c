@@ -0,0 +1,185 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <string.h>
+
+/* every allocation is prefixed with a header, so that frees know the size and scope of the memory.
+   the header is right before the (aligned) pointer that is returned to the driver. */
+typedef struct AllocationHeader {
+	void *base; // what was returned by dcmemAllocate, NULL for allocations in the command arena.
+	size_t size;
+	VkSystemAllocationScope scope;
+} AllocationHeader;
+
+#define HEADER(POINTER) ((AllocationHeader *)((uint8_t *)(POINTER) - sizeof(AllocationHeader)))
+
+static const char *scopeNames[] = {
+	[DCG_HOST_MEMORY_SCOPE_COMMAND] = "command", [DCG_HOST_MEMORY_SCOPE_OBJECT] = "object",
+	[DCG_HOST_MEMORY_SCOPE_CACHE] = "cache",     [DCG_HOST_MEMORY_SCOPE_DEVICE] = "device",
+	[DCG_HOST_MEMORY_SCOPE_INSTANCE] = "instance",
+};
+
+static uint8_t *alignUp(uint8_t *pointer, size_t alignment) {
+	return (uint8_t *)(((uintptr_t)pointer + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+/** allocates with the allocator mutex locked, doesn't count the allocation. */
+static void *allocate(DCgiHostAllocator *allocator, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	if(alignment < alignof(AllocationHeader)) alignment = alignof(AllocationHeader);
+	DCgHostMemoryStats *stats = &allocator->stats[scope];
+	if(stats->limit != 0 && stats->liveBytes + size > stats->limit) {
+		DCD_WARNING("Vulkan %s scope host memory limit reached (%zu + %zu > %zu bytes).", scopeNames[scope], stats->liveBytes, size, stats->limit);
+		stats->failedCount += 1;
+		return NULL;
+	}
+
+	uint8_t *pointer;
+	void *base = NULL;
+	// command scope memory only lives for the duration of a single Vulkan command, so it's pushed into an arena. the
+	// arena is one block that is only reset once none of its allocations is live, what doesn't fit comes from the heap.
+	size_t headerSize = (sizeof(AllocationHeader) + alignment - 1) & ~(alignment - 1);
+	if(scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND && allocator->commandArena.top + alignment - 1 + headerSize + size <= DCGI_COMMAND_ARENA_SIZE) {
+		pointer = dcmemPushAligned(&allocator->commandArena, headerSize + size, alignment);
+		if(pointer != NULL) pointer += headerSize;
+		allocator->commandLiveCount += pointer != NULL;
+	} else {
+		base = dcmemAllocate(sizeof(AllocationHeader) + size + alignment - 1);
+		pointer = base != NULL ? alignUp((uint8_t *)base + sizeof(AllocationHeader), alignment) : NULL;
+	}
+
+	if(pointer == NULL) {
+		stats->failedCount += 1;
+		return NULL;
+	}
+
+	*HEADER(pointer) = (AllocationHeader){ .base = base, .size = size, .scope = scope };
+	stats->liveBytes += size;
+	stats->totalBytes += size;
+	if(stats->liveBytes > stats->peakBytes) stats->peakBytes = stats->liveBytes;
+	return pointer;
+}
+
+/** frees with the allocator mutex locked, doesn't count the free. */
+static void deallocate(DCgiHostAllocator *allocator, void *pointer) {
+	AllocationHeader *header = HEADER(pointer);
+	allocator->stats[header->scope].liveBytes -= header->size;
+
+	if(header->base != NULL) {
+		dcmemDeallocate(header->base);
+		return;
+	}
+
+	// command scope allocations don't outlive their command, the arena is reused once all of them are freed.
+	if(--allocator->commandLiveCount == 0) dcmemResetArena(&allocator->commandArena);
+}
+
+static void *VKAPI_PTR allocationCallback(void *userData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	DCgiHostAllocator *allocator = userData;
+	pthread_mutex_lock(&allocator->mutex);
+	void *pointer = allocate(allocator, size, alignment, scope);
+	allocator->stats[scope].allocCount += pointer != NULL;
+	pthread_mutex_unlock(&allocator->mutex);
+	return pointer;
+}
+
+static void *VKAPI_PTR reallocationCallback(void *userData, void *original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	DCgiHostAllocator *allocator = userData;
+	pthread_mutex_lock(&allocator->mutex);
+
+	void *pointer = NULL;
+	if(original == NULL) {
+		pointer = allocate(allocator, size, alignment, scope);
+		allocator->stats[scope].allocCount += pointer != NULL;
+	} else if(size == 0) {
+		allocator->stats[HEADER(original)->scope].freeCount += 1;
+		deallocate(allocator, original);
+	} else if((pointer = allocate(allocator, size, alignment, scope)) != NULL) {
+		// the original allocation must stay valid if the reallocation fails, so always move.
+		size_t oldSize = HEADER(original)->size;
+		memcpy(pointer, original, oldSize < size ? oldSize : size);
+		deallocate(allocator, original);
+		allocator->stats[scope].reallocCount += 1;
+	}
+
+	pthread_mutex_unlock(&allocator->mutex);
+	return pointer;
+}
+
+static void VKAPI_PTR freeCallback(void *userData, void *pointer) {
+	if(pointer == NULL) return;
+	DCgiHostAllocator *allocator = userData;
+	pthread_mutex_lock(&allocator->mutex);
+	allocator->stats[HEADER(pointer)->scope].freeCount += 1;
+	deallocate(allocator, pointer);
+	pthread_mutex_unlock(&allocator->mutex);
+}
+
+static void VKAPI_PTR internalAllocationCallback(void *userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+	(void)type;
+	DCgiHostAllocator *allocator = userData;
+	pthread_mutex_lock(&allocator->mutex);
+	allocator->stats[scope].internalBytes += size;
+	pthread_mutex_unlock(&allocator->mutex);
+}
+
+static void VKAPI_PTR internalFreeCallback(void *userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope) {
+	(void)type;
+	DCgiHostAllocator *allocator = userData;
+	pthread_mutex_lock(&allocator->mutex);
+	allocator->stats[scope].internalBytes -= size;
+	pthread_mutex_unlock(&allocator->mutex);
+}
+
+void dcgiInitHostAllocator(DCgiHostAllocator *allocator) {
+	*allocator = (DCgiHostAllocator){ 0 };
+	allocator->callbacks = (VkAllocationCallbacks){
+		.pUserData = allocator,
+		.pfnAllocation = &allocationCallback,
+		.pfnReallocation = &reallocationCallback,
+		.pfnFree = &freeCallback,
+		.pfnInternalAllocation = &internalAllocationCallback,
+		.pfnInternalFree = &internalFreeCallback,
+	};
+	pthread_mutex_init(&allocator->mutex, NULL);
+	allocator->commandArena.step = DCGI_COMMAND_ARENA_SIZE;
+}
+
+void dcgiFreeHostAllocator(DCgiHostAllocator *allocator) {
+	for(size_t i = 0; i < DCG_HOST_MEMORY_SCOPE_COUNT; ++i)
+		if(allocator->stats[i].liveBytes != 0)
+			DCD_WARNING("Vulkan leaked %zu bytes of %s scope host memory.", allocator->stats[i].liveBytes, scopeNames[i]);
+
+	dcmemFreeArena(&allocator->commandArena);
+	pthread_mutex_destroy(&allocator->mutex);
+}
+
+void dcgGetHostMemoryStats(DCgState *state, DCgHostMemoryStats stats[DCG_HOST_MEMORY_SCOPE_COUNT]) {
+	pthread_mutex_lock(&state->hostAllocator.mutex);
+	memcpy(stats, state->hostAllocator.stats, sizeof(state->hostAllocator.stats));
+	pthread_mutex_unlock(&state->hostAllocator.mutex);
+}
+
+void dcgPrintHostMemoryStats(DCgState *state) {
+	DCgHostMemoryStats stats[DCG_HOST_MEMORY_SCOPE_COUNT];
+	pthread_mutex_lock(&state->hostAllocator.mutex);
+	memcpy(stats, state->hostAllocator.stats, sizeof(state->hostAllocator.stats));
+	size_t commandArenaSize = state->hostAllocator.commandArena.size;
+	pthread_mutex_unlock(&state->hostAllocator.mutex);
+
+	DCD_INFO("Vulkan host memory (command arena: %zu bytes):", commandArenaSize);
+	for(size_t i = 0; i < DCG_HOST_MEMORY_SCOPE_COUNT; ++i) {
+		DCD_INFO(
+		  "%s: %zu allocs, %zu reallocs, %zu frees, %zu failed, %zu live bytes, %zu peak bytes, %zu total bytes, %zu internal bytes", scopeNames[i],
+		  stats[i].allocCount, stats[i].reallocCount, stats[i].freeCount, stats[i].failedCount, stats[i].liveBytes, stats[i].peakBytes,
+		  stats[i].totalBytes, stats[i].internalBytes
+		);
+	}
+}
+
+void dcgSetHostMemoryLimit(DCgState *state, DCgHostMemoryScope scope, size_t limit) {
+	DC_RASSERT(scope < DCG_HOST_MEMORY_SCOPE_COUNT, "Invalid host memory scope");
+	pthread_mutex_lock(&state->hostAllocator.mutex);
+	state->hostAllocator.stats[scope].limit = limit;
+	pthread_mutex_unlock(&state->hostAllocator.mutex);
+}
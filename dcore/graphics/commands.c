@@ -2,18 +2,31 @@
 #include <dcore/graphics.h>
 #include <dcore/graphics/internal.h>
 
+/** command buffers are allocated from Vulkan in batches, doubling the count of the frame slot. */
+#define FIRST_BATCH 4
+
 DCgCmdPool *dcgNewCmdPool(DCgState *s, DCgCmdPoolType type) {
-	VkCommandPool commandPool;
+	DCgCmdPool *pool = dcmemAllocate(sizeof(DCgCmdPool));
+	switch(type) {
+	case DCG_CMD_POOL_TYPE_COMPUTE: pool->queueFamily = s->computeQueueFamily; break;
+	case DCG_CMD_POOL_TYPE_GRAPHICS: pool->queueFamily = s->graphicsQueueFamily; break;
+	default:
+		DCD_WARNING("Bad DCgCmdPoolType: %d", type);
+		pool->queueFamily = s->graphicsQueueFamily;
+		break;
+	}
+	dcmemInitPool(&pool->bufferPool, sizeof(DCgCmdBuffer), 16);
+
+	// command buffers are never reset one by one, so the pools don't need VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT.
 	VkCommandPoolCreateInfo createInfo = { 0 };
 	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	switch(type) {
-	case DCG_CMD_POOL_TYPE_COMPUTE: createInfo.queueFamilyIndex = s->computeQueueFamily; break;
-	case DCG_CMD_POOL_TYPE_GRAPHICS: createInfo.queueFamilyIndex = s->graphicsQueueFamily; break;
-	default: DCD_WARNING("Bad DCgCmdPoolType: %d", type); break;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	createInfo.queueFamilyIndex = pool->queueFamily;
+	for(int i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i) {
+		pool->frames[i] = (DCgiCmdPoolFrame){ 0 };
+		DC_ASSERT(vkCreateCommandPool(s->device, &createInfo, s->allocator, &pool->frames[i].pool) == VK_SUCCESS, "Failed to create command pool!");
 	}
-	DC_ASSERT(vkCreateCommandPool(s->device, &createInfo, s->allocator, &commandPool) == VK_SUCCESS, "Failed to create command pool!");
-	return (void *)commandPool;
+	return pool;
 }
 
 void dcgFreeCmdPool(DCgState *s, DCgCmdPool *pool) {
@@ -22,5 +35,95 @@ void dcgFreeCmdPool(DCgState *s, DCgCmdPool *pool) {
 		return;
 	}
 
-	vkDestroyCommandPool(s->device, (void *)pool, s->allocator);
+	// destroying a pool frees its command buffers.
+	for(int i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i) {
+		vkDestroyCommandPool(s->device, pool->frames[i].pool, s->allocator);
+		if(pool->frames[i].buffers != NULL) dcmemDeallocate(pool->frames[i].buffers);
+	}
+	dcmemFreePool(&pool->bufferPool);
+	dcmemDeallocate(pool);
+}
+
+/** allocates another batch of command buffers for a frame slot. */
+static void growFrame(DCgState *s, DCgCmdPool *pool, DCgiCmdPoolFrame *frame) {
+	uint32_t capacity = frame->capacity != 0 ? frame->capacity * 2 : FIRST_BATCH, count = capacity - frame->count;
+	size_t bytes = sizeof(DCgCmdBuffer *) * capacity;
+	frame->buffers = frame->buffers == NULL ? dcmemAllocate(bytes) : dcmemReallocate(frame->buffers, bytes);
+	frame->capacity = capacity;
+
+	VkCommandBuffer *commandBuffers = dcmemAllocate(sizeof(VkCommandBuffer) * count);
+	VkCommandBufferAllocateInfo allocateInfo = { 0 };
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = frame->pool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = count;
+	DC_ASSERT(vkAllocateCommandBuffers(s->device, &allocateInfo, commandBuffers) == VK_SUCCESS, "Failed to allocate command buffers!");
+	for(uint32_t i = 0; i < count; ++i) {
+		DCgCmdBuffer *cmds = DCMEM_POOL_ALLOCATE(&pool->bufferPool, DCgCmdBuffer);
+		*cmds = (DCgCmdBuffer){ .commandBuffer = commandBuffers[i], .pool = pool };
+		frame->buffers[frame->count++] = cmds;
+	}
+	dcmemDeallocate(commandBuffers);
+}
+
+DCgCmdBuffer *dcgGetNewCmdBuffer(DCgState *s, DCgCmdPool *pool) {
+	DCgiCmdPoolFrame *frame = &pool->frames[s->frame];
+	if(frame->frameNumber != s->frameNumber) {
+		// dcgBeginFrame waited for the fence of the slot, the GPU is done with the last frame that used it.
+		if(frame->used != 0) vkResetCommandPool(s->device, frame->pool, 0);
+		frame->frameNumber = s->frameNumber;
+		frame->used = 0;
+	}
+	if(frame->used == frame->count) growFrame(s, pool, frame);
+	return frame->buffers[frame->used++];
+}
+
+void dcgCmdBegin(DCgState *s, DCgCmdBuffer *cmds) {
+	VkCommandBufferBeginInfo beginInfo = { 0 };
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	DC_ASSERT(vkBeginCommandBuffer(cmds->commandBuffer, &beginInfo) == VK_SUCCESS, "Failed to begin command buffer!");
+	cmds->pipeline = VK_NULL_HANDLE;
+	cmds->vertexBuffer = VK_NULL_HANDLE, cmds->indexBuffer = VK_NULL_HANDLE;
+	cmds->draws = 0, cmds->triangles = 0;
+	cmds->zoneDepth = 0;
+}
+
+void dcgCmdBindVertexBuf(DCgState *s, DCgCmdBuffer *cmds, DCgVertexBuffer *vbuf) {
+	if(vbuf->buffer == cmds->vertexBuffer) return;
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(cmds->commandBuffer, 0, 1, &vbuf->buffer, &offset);
+	cmds->vertexBuffer = vbuf->buffer;
+}
+
+void dcgCmdBindIndexBuf(DCgState *s, DCgCmdBuffer *cmds, DCgIndexBuffer *ibuf) {
+	if(ibuf->buffer == cmds->indexBuffer) return;
+	vkCmdBindIndexBuffer(cmds->commandBuffer, ibuf->buffer, 0, VK_INDEX_TYPE_UINT32);
+	cmds->indexBuffer = ibuf->buffer;
+}
+
+void dcgCmdBindMat(DCgState *s, DCgCmdBuffer *cmds, DCgMaterial *mat) {
+	if(mat->pipeline == cmds->pipeline) return;
+	vkCmdBindPipeline(cmds->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mat->pipeline);
+	cmds->pipeline = mat->pipeline;
+}
+
+void dcgCmdDraw(DCgState *s, DCgCmdBuffer *cmds, size_t indices, size_t instances) {
+	vkCmdDrawIndexed(cmds->commandBuffer, (uint32_t)indices, (uint32_t)instances, 0, 0, 0);
+	cmds->draws += 1;
+	cmds->triangles += indices / 3 * instances;
+}
+
+void dcgSubmit(DCgState *s, DCgCmdBuffer *cmds, int queue) {
+	DC_ASSERT(queue == 0, "Only one queue is created per family!");
+	DC_ASSERT(vkEndCommandBuffer(cmds->commandBuffer) == VK_SUCCESS, "Failed to end command buffer!");
+	VkSubmitInfo submitInfo = { 0 };
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmds->commandBuffer;
+	DC_RASSERT(
+	  vkQueueSubmit(dcgiGetQueue(s, cmds->pool->queueFamily), 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS, "Failed to submit command buffer"
+	);
+	s->frameStats.draws += cmds->draws;
+	s->frameStats.triangles += cmds->triangles;
 }
@@ -34,12 +34,15 @@ static void createInstance(DCgState *state, uint32_t appVersion, const char *app
 		state->suggestedLayers.layers[j].name = suggestedLayers[j];
 	}
 
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	// extensions required by glfw
 	uint32_t requiredExtensionCount;
 	const char **requiredExtensions = glfwGetRequiredInstanceExtensions(&requiredExtensionCount);
 
 	// allocate maximum number of extensions.
-	const char **enabledExtensions = dcmemAllocate((requiredExtensionCount + ARRAYSIZE(suggestedExtensions)) * sizeof(const char *));
+	const char **enabledExtensions = DCMEM_PUSH_ARRAY(scratch, const char *, requiredExtensionCount + ARRAYSIZE(suggestedExtensions));
 	size_t enabledExtensionCount = requiredExtensionCount; // filled with requiredExtensionCount extensions when used
 
 	DCD_MSGF(DEBUG, "Required extension count: %d", requiredExtensionCount);
@@ -53,7 +56,7 @@ static void createInstance(DCgState *state, uint32_t appVersion, const char *app
 	uint32_t extensionPropertiesCount;
 
 	vkEnumerateInstanceExtensionProperties(NULL, &extensionPropertiesCount, NULL);
-	extensionProperties = dcmemAllocate(sizeof(VkExtensionProperties) * extensionPropertiesCount);
+	extensionProperties = DCMEM_PUSH_ARRAY(scratch, VkExtensionProperties, extensionPropertiesCount);
 	vkEnumerateInstanceExtensionProperties(NULL, &extensionPropertiesCount, extensionProperties);
 
 	// check if we have a matching suggestedExtension.
@@ -77,12 +80,12 @@ static void createInstance(DCgState *state, uint32_t appVersion, const char *app
 	}
 
 	uint32_t enabledLayerCount = 0;
-	const char **enabledLayers = dcmemAllocate(sizeof(const char *) * ARRAYSIZE(suggestedLayers));
+	const char **enabledLayers = DCMEM_PUSH_ARRAY(scratch, const char *, ARRAYSIZE(suggestedLayers));
 
 	// all available layers
 	uint32_t layerPropertiesCount;
 	vkEnumerateInstanceLayerProperties(&layerPropertiesCount, NULL);
-	VkLayerProperties *layerProperties = dcmemAllocate(sizeof(VkLayerProperties) * layerPropertiesCount);
+	VkLayerProperties *layerProperties = DCMEM_PUSH_ARRAY(scratch, VkLayerProperties, layerPropertiesCount);
 	vkEnumerateInstanceLayerProperties(&layerPropertiesCount, layerProperties);
 
 	for(int j = 0; j < state->suggestedLayers.count; ++j) {
@@ -142,12 +145,9 @@ static void createInstance(DCgState *state, uint32_t appVersion, const char *app
 	createInfo.enabledLayerCount = enabledLayerCount;
 	createInfo.ppEnabledLayerNames = enabledLayers;
 
-	DC_RASSERT(vkCreateInstance(&createInfo, state->allocator, &state->instance) == VK_SUCCESS, "Failed to create Vulkan instance");
-
-	dcmemDeallocate(enabledExtensions);
-	dcmemDeallocate(enabledLayers);
-	dcmemDeallocate(extensionProperties);
-	dcmemDeallocate(layerProperties);
+	VkResult result = vkCreateInstance(&createInfo, state->allocator, &state->instance);
+	dcmemRestoreArenaMarker(scratch, marker);
+	DC_RASSERT(result == VK_SUCCESS, "Failed to create Vulkan instance");
 	DCD_MSGF(DEBUG, "Done creating instance...");
 }
 
@@ -163,9 +163,12 @@ static void findQueueFamilies(DCgState *state, VkPhysicalDevice physicalDevice,
 	families->compute = UINT32_MAX;
 	families->graphics = UINT32_MAX;
 
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	uint32_t queueFamilyCount = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, NULL);
-	VkQueueFamilyProperties *queueFamilies = dcmemAllocate(sizeof(VkQueueFamilyProperties) * queueFamilyCount);
+	VkQueueFamilyProperties *queueFamilies = DCMEM_PUSH_ARRAY(scratch, VkQueueFamilyProperties, queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies);
 	for(uint32_t i = 0; i < queueFamilyCount; ++i) {
 		if(queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) families->graphics = i;
@@ -175,13 +178,16 @@ static void findQueueFamilies(DCgState *state, VkPhysicalDevice physicalDevice,
 		if(supported) families->present = i;
 	}
 
-	dcmemDeallocate(queueFamilies);
+	dcmemRestoreArenaMarker(scratch, marker);
 }
 
-static bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, size_t extCount, const char **exts) {
+static bool checkDeviceExtensionSupport(DCgState *state, VkPhysicalDevice physicalDevice, size_t extCount, const char **exts) {
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	uint32_t propertiesCount = 0;
 	vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &propertiesCount, NULL);
-	VkExtensionProperties *properties = dcmemAllocate(sizeof(VkExtensionProperties) * propertiesCount);
+	VkExtensionProperties *properties = DCMEM_PUSH_ARRAY(scratch, VkExtensionProperties, propertiesCount);
 	vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &propertiesCount, properties);
 
 	size_t notFound = extCount; // number of extensions that are not yet found.
@@ -196,14 +202,17 @@ static bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, size_t
 		}
 	}
 
-	dcmemDeallocate(properties);
+	dcmemRestoreArenaMarker(scratch, marker);
 	return notFound == 0;
 }
 
 static void selectPhysicalDevice(DCgState *state) {
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	uint32_t deviceCount;
 	vkEnumeratePhysicalDevices(state->instance, &deviceCount, NULL);
-	VkPhysicalDevice *devices = dcmemAllocate(sizeof(VkPhysicalDevice) * deviceCount);
+	VkPhysicalDevice *devices = DCMEM_PUSH_ARRAY(scratch, VkPhysicalDevice, deviceCount);
 	vkEnumeratePhysicalDevices(state->instance, &deviceCount, devices);
 
 	int maxScrore = 0;
@@ -231,7 +240,7 @@ static void selectPhysicalDevice(DCgState *state) {
 		if(queueFamilies.graphics == queueFamilies.present) score += score / 10;
 
 		const char *requiredExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
-		bool supported = checkDeviceExtensionSupport(devices[i], ARRAYSIZE(requiredExtensions), requiredExtensions);
+		bool supported = checkDeviceExtensionSupport(state, devices[i], ARRAYSIZE(requiredExtensions), requiredExtensions);
 		if(!supported) {
 			DCD_FATAL("Required extensions not supported.");
 			score = 0;
@@ -246,7 +255,7 @@ static void selectPhysicalDevice(DCgState *state) {
 		}
 	}
 
-	dcmemDeallocate(devices);
+	dcmemRestoreArenaMarker(scratch, marker);
 
 	DC_RASSERT(state->graphicsQueueFamily != UINT32_MAX, "Could not find a graphics queue family (required)");
 	DC_RASSERT(state->presentQueueFamily != UINT32_MAX, "Could not find a present queue family (required)");
@@ -270,13 +279,16 @@ static size_t addUniqueQueueFamily(uint32_t *families, size_t last, uint32_t new
 
 static void createLogicalDevice(DCgState *state) {
 	DCD_DEBUG("Creating a logical device...");
-	uint32_t *queueFamilies = dcmemAllocate(sizeof(uint32_t) * 2); // maximum possible number of queue families.
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
+	uint32_t *queueFamilies = DCMEM_PUSH_ARRAY(scratch, uint32_t, 3); // maximum possible number of queue families.
 	size_t queueFamilyCount = 0;
 	queueFamilyCount = addUniqueQueueFamily(queueFamilies, queueFamilyCount, state->graphicsQueueFamily);
 	queueFamilyCount = addUniqueQueueFamily(queueFamilies, queueFamilyCount, state->computeQueueFamily);
 	queueFamilyCount = addUniqueQueueFamily(queueFamilies, queueFamilyCount, state->presentQueueFamily);
 
-	VkDeviceQueueCreateInfo *queues = dcmemAllocate(sizeof(VkDeviceQueueCreateInfo) * queueFamilyCount);
+	VkDeviceQueueCreateInfo *queues = DCMEM_PUSH_ARRAY(scratch, VkDeviceQueueCreateInfo, queueFamilyCount);
 	memset(queues, 0, sizeof(VkDeviceQueueCreateInfo) * queueFamilyCount);
 	float queuePriority = 1.0f;
 	for(int i = 0; i < queueFamilyCount; ++i) {
@@ -290,9 +302,9 @@ static void createLogicalDevice(DCgState *state) {
 
 	uint32_t propertiesCount;
 	vkEnumerateDeviceExtensionProperties(state->physicalDevice, NULL, &propertiesCount, NULL);
-	VkExtensionProperties *properties = dcmemAllocate(sizeof(VkExtensionProperties) * propertiesCount);
+	VkExtensionProperties *properties = DCMEM_PUSH_ARRAY(scratch, VkExtensionProperties, propertiesCount);
 	vkEnumerateDeviceExtensionProperties(state->physicalDevice, NULL, &propertiesCount, properties);
-	const char **enabledExtensions = dcmemAllocate(sizeof(const char *) * propertiesCount); // TODO: this is the maximum number of names
+	const char **enabledExtensions = DCMEM_PUSH_ARRAY(scratch, const char *, propertiesCount + 1); // TODO: this is the maximum number of names
 
 	size_t enabledExtensionCount = 0;
 	enabledExtensions[enabledExtensionCount++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
@@ -314,12 +326,9 @@ static void createLogicalDevice(DCgState *state) {
 	createInfo.ppEnabledExtensionNames = enabledExtensions;
 	createInfo.pEnabledFeatures = &features;
 
-	DC_RASSERT(vkCreateDevice(state->physicalDevice, &createInfo, state->allocator, &state->device) == VK_SUCCESS, "Failed to create logical device");
-
-	dcmemDeallocate(properties);
-	dcmemDeallocate(enabledExtensions);
-	dcmemDeallocate(queueFamilies);
-	dcmemDeallocate(queues);
+	VkResult result = vkCreateDevice(state->physicalDevice, &createInfo, state->allocator, &state->device);
+	dcmemRestoreArenaMarker(scratch, marker);
+	DC_RASSERT(result == VK_SUCCESS, "Failed to create logical device");
 	DCD_DEBUG("Logical device created!");
 }
 
@@ -337,36 +346,42 @@ void createRenderPasses(DCgState *state) {
 }
 
 static void selectPresentMode(DCgState *state) {
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	uint32_t presentModeCount = 0;
 	vkGetPhysicalDeviceSurfacePresentModesKHR(state->physicalDevice, state->surface, &presentModeCount, NULL);
-	VkPresentModeKHR *presentModes = dcmemAllocate(sizeof(VkPresentModeKHR) * presentModeCount);
+	VkPresentModeKHR *presentModes = DCMEM_PUSH_ARRAY(scratch, VkPresentModeKHR, presentModeCount);
 	vkGetPhysicalDeviceSurfacePresentModesKHR(state->physicalDevice, state->surface, &presentModeCount, presentModes);
 	for(uint32_t i = 0; i < presentModeCount; ++i) {
 		if(presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR) {
 			state->presentMode = presentModes[i];
-			dcmemDeallocate(presentModes);
+			dcmemRestoreArenaMarker(scratch, marker);
 			return;
 		}
 	}
-	dcmemDeallocate(presentModes);
+	dcmemRestoreArenaMarker(scratch, marker);
 	state->presentMode = VK_PRESENT_MODE_FIFO_KHR;
 }
 
 static void selectSurfaceFormat(DCgState *state) {
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+
 	uint32_t surfaceFormatCount = 0;
 	vkGetPhysicalDeviceSurfaceFormatsKHR(state->physicalDevice, state->surface, &surfaceFormatCount, NULL);
-	VkSurfaceFormatKHR *surfaceFormats = dcmemAllocate(sizeof(VkSurfaceFormatKHR) * surfaceFormatCount);
+	VkSurfaceFormatKHR *surfaceFormats = DCMEM_PUSH_ARRAY(scratch, VkSurfaceFormatKHR, surfaceFormatCount);
 	vkGetPhysicalDeviceSurfaceFormatsKHR(state->physicalDevice, state->surface, &surfaceFormatCount, surfaceFormats);
 	for(uint32_t i = 0; i < surfaceFormatCount; ++i) {
 		if(surfaceFormats[i].format == VK_FORMAT_B8G8R8A8_SRGB && surfaceFormats[i].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
 			state->surfaceFormat = surfaceFormats[i];
-			dcmemDeallocate(surfaceFormats);
+			dcmemRestoreArenaMarker(scratch, marker);
 			return;
 		}
 	}
 
 	state->surfaceFormat = surfaceFormats[0];
-	dcmemDeallocate(surfaceFormats);
+	dcmemRestoreArenaMarker(scratch, marker);
 }
 
 static void createSwapchain(DCgState *state) {
@@ -414,38 +429,79 @@ static void createSwapchain(DCgState *state) {
 	DC_RASSERT(vkCreateSwapchainKHR(state->device, &createInfo, state->allocator, &state->swapchain) == VK_SUCCESS, "Failed to create swapchain");
 }
 
+static void createFrameFences(DCgState *state) {
+	VkFenceCreateInfo createInfo = { 0 };
+	createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	createInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // the first wait on each frame slot shouldn't block.
+	for(size_t i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i)
+		DC_RASSERT(vkCreateFence(state->device, &createInfo, state->allocator, &state->frameFences[i]) == VK_SUCCESS, "Failed to create frame fence");
+}
+
 DCgState *dcgNewState() {
 	DCgState *state = dcmemAllocate(sizeof(DCgState));
-	state->allocator = NULL; // TODO: custom state->allocator for logging
+	dcgiInitHostAllocator(&state->hostAllocator);
+	state->allocator = &state->hostAllocator.callbacks;
 	state->instance = NULL;
 	state->physicalDevice = NULL;
 	state->renderPassCount = 0;
 
-	state->renderPassCount = 0;
-	state->descriptorSetLayoutsCount = 0;
-	state->vertexAttributesCount = 0;
-	state->vertexBindingsCount = 0;
-	state->pushConstantRangesCount = 0;
+	dcmemInitRegistry(&state->pushConstantRanges, sizeof(DCgiPushConstantRanges));
+	dcmemInitRegistry(&state->descriptorSetLayouts, sizeof(DCgiDescriptorSetLayouts));
+	dcmemInitRegistry(&state->vertexInputs, sizeof(DCgiVertexInput));
+
+	state->frame = 0;
+	state->frameNumber = 0;
+	state->frameStats = (DCgiFrameStats){ 0 };
+	dcmemInitFrameAllocator(&state->frameAllocator, DCG_FRAMES_IN_FLIGHT, 64 * 1024);
+	dcmemInitPool(&state->materialPool, sizeof(DCgMaterial), 64);
+	dcmemInitPool(&state->bufferPool, sizeof(DCgBuffer), 256);
 	return state;
 }
 
-void dcgFreeState(DCgState *state) { dcmemDeallocate(state); }
+void dcgFreeState(DCgState *state) {
+	dcmemFreeFrameAllocator(&state->frameAllocator);
+	dcmemFreePool(&state->materialPool);
+	dcmemFreePool(&state->bufferPool);
+	dcmemFreeRegistry(&state->pushConstantRanges);
+	dcmemFreeRegistry(&state->descriptorSetLayouts);
+	dcmemFreeRegistry(&state->vertexInputs);
+	dcgiFreeHostAllocator(&state->hostAllocator);
+	dcmemDeallocate(state);
+}
 
 void dcgInit(DCgState *state, uint32_t appVersion, const char *appName) {
+	DCD_BEGIN_ZONE("dcgInit");
+	DCD_BEGIN_ZONE("window");
 	if(!glfwInit()) dcgiPrintGlfwErrors();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	state->window = glfwCreateWindow(640, 480, appName, NULL, NULL);
 	if(state->window == NULL) dcgiPrintGlfwErrors();
+	DCD_END_ZONE();
 
+	DCD_BEGIN_ZONE("instance");
 	createInstance(state, appVersion, appName);
 	createSurface(state);
+	DCD_END_ZONE();
+	DCD_BEGIN_ZONE("device");
 	selectPhysicalDevice(state);
 	createLogicalDevice(state);
+	dcgiInitDeviceMemory(state);
+	DCD_END_ZONE();
+	DCD_BEGIN_ZONE("swapchain");
 	createSwapchain(state);
+	createFrameFences(state);
+	DCD_END_ZONE();
+	dcgiInitGpuTimer(state);
+	DCD_END_ZONE();
 }
 
 void dcgDeinit(DCgState *state) {
+	vkDeviceWaitIdle(state->device);
+	dcgiFreeGpuTimer(state);
+	for(size_t i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i)
+		vkDestroyFence(state->device, state->frameFences[i], state->allocator);
+
 	if(state->swapchain != VK_NULL_HANDLE) {
 		vkDestroySwapchainKHR(state->device, state->swapchain, state->allocator);
 	}
@@ -460,33 +516,20 @@ void dcgDeinit(DCgState *state) {
 		dcmemDeallocate(state->renderPasses);
 	}
 
-	if(state->descriptorSetLayoutsCount) {
-		DC_ASSERT(state->descriptorSetLayouts != NULL, "state->descriptorSetLayouts == NULL and state->descriptorSetLayoutsCount != 0");
-		for(size_t i = 0; i < state->descriptorSetLayoutsCount; ++i)
-			for(size_t j = 0; j < state->descriptorSetLayouts[i].count; ++j) {
-				if(state->descriptorSetLayouts[i].layouts[j] != VK_NULL_HANDLE)
-					vkDestroyDescriptorSetLayout(state->device, state->descriptorSetLayouts[i].layouts[j], state->allocator);
-				else
-					DCD_WARNING("state->descriptorSetLayouts[%zu].layouts[%zu] == VK_NULL_HANDLE", i, j);
-			}
-		dcmemDeallocate(state->descriptorSetLayouts);
-	}
-
-	if(state->pushConstantRangesCount) {
-		DC_ASSERT(state->pushConstantRanges != NULL, "state->pushConstantRanges == NULL and state->pushConstantRangesCount != 0");
-		dcmemDeallocate(state->pushConstantRanges);
-	}
-
-	if(state->vertexAttributesCount) {
-		DC_ASSERT(state->vertexAttributes != NULL, "state->vertexAttributes == NULL and state->vertexAttributesCount != 0");
-		dcmemDeallocate(state->vertexAttributes);
-	}
-
-	if(state->vertexBindingsCount) {
-		DC_ASSERT(state->vertexBindings != NULL, "state->vertexBindings == NULL and state->vertexBindingsCount != 0");
-		dcmemDeallocate(state->vertexBindings);
+	for(uint32_t i = 0; i < state->descriptorSetLayouts.count; ++i) {
+		DCgiDescriptorSetLayouts *layouts = DCMEM_REGISTRY_AT(&state->descriptorSetLayouts, i, DCgiDescriptorSetLayouts);
+		for(uint32_t j = 0; j < layouts->count; ++j) {
+			if(layouts->layouts[j] != VK_NULL_HANDLE)
+				vkDestroyDescriptorSetLayout(state->device, layouts->layouts[j], state->allocator);
+			else
+				DCD_WARNING("descriptor set layout %u of group %u == VK_NULL_HANDLE", j, i);
+		}
 	}
+	dcmemFreeRegistry(&state->descriptorSetLayouts);
+	dcmemFreeRegistry(&state->pushConstantRanges);
+	dcmemFreeRegistry(&state->vertexInputs);
 
+	dcgiFreeDeviceMemory(state);
 	vkDestroySurfaceKHR(state->instance, state->surface, state->allocator);
 	vkDestroyDevice(state->device, state->allocator);
 	vkDestroyInstance(state->instance, state->allocator);
@@ -504,28 +547,32 @@ void dcgiPrintGlfwErrors() {
 	}
 }
 
-size_t dcgiGetPushConstantRanges(DCgState *state, int index, const VkPushConstantRange **ranges) {
-	DC_ASSERT(index < state->pushConstantRangesCount, "Tried to access push constant renages with index out of bounds.");
-	if(ranges != NULL) *ranges = state->pushConstantRanges[index].ranges;
-	return state->pushConstantRanges[index].count;
+size_t dcgiGetPushConstantRanges(DCgState *state, DCmemHandle handle, const VkPushConstantRange **ranges) {
+	DCgiPushConstantRanges *group = DCMEM_REGISTRY_GET(&state->pushConstantRanges, handle, DCgiPushConstantRanges);
+	DC_RVASSERT(group != NULL, "Tried to access push constant ranges with an invalid handle.", 0);
+	if(ranges != NULL) *ranges = group->ranges;
+	return group->count;
 }
 
-size_t dcgiGetSetLayouts(DCgState *state, int index, const VkDescriptorSetLayout **layouts) {
-	DC_ASSERT(index < state->descriptorSetLayoutsCount, "Tried to access descriptor set layouts with index out of bounds.");
-	if(layouts != NULL) *layouts = state->descriptorSetLayouts[index].layouts;
-	return state->descriptorSetLayouts[index].count;
+size_t dcgiGetSetLayouts(DCgState *state, DCmemHandle handle, const VkDescriptorSetLayout **layouts) {
+	DCgiDescriptorSetLayouts *group = DCMEM_REGISTRY_GET(&state->descriptorSetLayouts, handle, DCgiDescriptorSetLayouts);
+	DC_RVASSERT(group != NULL, "Tried to access descriptor set layouts with an invalid handle.", 0);
+	if(layouts != NULL) *layouts = group->layouts;
+	return group->count;
 }
 
-size_t dcgiGetVertexBindings(DCgState *state, int index, const VkVertexInputBindingDescription **descriptions) {
-	DC_ASSERT(index < state->vertexBindingsCount, "Tried to access vertex bindings with index out of bounds.");
-	if(descriptions != NULL) *descriptions = state->vertexBindings[index].bindings;
-	return state->vertexBindings[index].count;
+size_t dcgiGetVertexBindings(DCgState *state, DCmemHandle handle, const VkVertexInputBindingDescription **descriptions) {
+	DCgiVertexInput *input = DCMEM_REGISTRY_GET(&state->vertexInputs, handle, DCgiVertexInput);
+	DC_RVASSERT(input != NULL, "Tried to access vertex bindings with an invalid handle.", 0);
+	if(descriptions != NULL) *descriptions = input->bindings;
+	return input->bindingCount;
 }
 
-size_t dcgiGetVertexAttributes(DCgState *state, int index, const VkVertexInputAttributeDescription **descriptions) {
-	DC_ASSERT(index < state->vertexAttributesCount, "Tried to access vertex attributes with index out of bounds.");
-	if(descriptions != NULL) *descriptions = state->vertexAttributes[index].attributes;
-	return state->vertexAttributes[index].count;
+size_t dcgiGetVertexAttributes(DCgState *state, DCmemHandle handle, const VkVertexInputAttributeDescription **descriptions) {
+	DCgiVertexInput *input = DCMEM_REGISTRY_GET(&state->vertexInputs, handle, DCgiVertexInput);
+	DC_RVASSERT(input != NULL, "Tried to access vertex attributes with an invalid handle.", 0);
+	if(descriptions != NULL) *descriptions = input->attributes;
+	return input->attributeCount;
 }
 
 VkRenderPass dcgiGetRenderPass(DCgState *state, size_t index) {
@@ -533,92 +580,58 @@ VkRenderPass dcgiGetRenderPass(DCgState *state, size_t index) {
 	return state->renderPasses[index];
 }
 
-VkPushConstantRange *dcgiAddPushConstantRanges(DCgState *state, size_t count) {
-	if(state->pushConstantRangesCount == 0) {
-		state->pushConstantRanges = dcmemAllocate(sizeof(*state->pushConstantRanges) + sizeof(VkPushConstantRange) * count);
-		state->pushConstantRangesCount += 1;
-	} else {
-		/* due to each element in the array being a different size, we manually
-		   compute the size of the array. */
-
-		size_t totalSize = 0;
-		for(size_t i = 0; i < state->pushConstantRangesCount; ++i) {
-			totalSize += sizeof(state->pushConstantRanges[i]);
-			totalSize += state->pushConstantRanges[i].count * sizeof(VkPushConstantRange);
-		}
-
-		state->pushConstantRanges
-		  = dcmemReallocate(state->pushConstantRanges, totalSize + sizeof(*state->pushConstantRanges) + sizeof(VkPushConstantRange) * count);
-	}
-
-	state->pushConstantRanges[state->pushConstantRangesCount - 1].count = count;
-	return state->pushConstantRanges[state->pushConstantRangesCount - 1].ranges;
+DCmemHandle dcgiAddPushConstantRanges(DCgState *state, size_t count, VkPushConstantRange **ranges) {
+	DC_RVASSERT(count <= DCGI_MAX_PUSH_CONSTANT_RANGES, "Too many push constant ranges in one group.", DCMEM_INVALID_HANDLE);
+	DCgiPushConstantRanges *group;
+	DCmemHandle handle = dcmemRegistryAdd(&state->pushConstantRanges, (void **)&group);
+	if(handle == DCMEM_INVALID_HANDLE) return handle;
+	group->count = (uint32_t)count;
+	if(ranges != NULL) *ranges = group->ranges;
+	return handle;
 }
 
-VkDescriptorSetLayout *dcgiAddDescriptorSetLayouts(DCgState *state, size_t count) {
-	if(state->descriptorSetLayoutsCount == 0) {
-		state->descriptorSetLayouts = dcmemAllocate(sizeof(*state->descriptorSetLayouts) + sizeof(VkDescriptorSetLayout) * count);
-		state->descriptorSetLayoutsCount += 1;
-	} else {
-		/* due to each element in the array being a different size, we manually
-		   compute the size of the array. */
-
-		size_t totalSize = 0;
-		for(size_t i = 0; i < state->descriptorSetLayoutsCount; ++i) {
-			totalSize += sizeof(state->descriptorSetLayouts[i]);
-			totalSize += state->descriptorSetLayouts[i].count * sizeof(VkDescriptorSetLayout);
-		}
-
-		state->descriptorSetLayouts
-		  = dcmemReallocate(state->descriptorSetLayouts, totalSize + sizeof(*state->descriptorSetLayouts) + sizeof(VkDescriptorSetLayout) * count);
-	}
-
-	state->descriptorSetLayouts[state->descriptorSetLayoutsCount - 1].count = count;
-	return state->descriptorSetLayouts[state->descriptorSetLayoutsCount - 1].layouts;
+DCmemHandle dcgiAddDescriptorSetLayouts(DCgState *state, size_t count, VkDescriptorSetLayout **layouts) {
+	DC_RVASSERT(count <= DCGI_MAX_DESCRIPTOR_SETS, "Too many descriptor set layouts in one group.", DCMEM_INVALID_HANDLE);
+	DCgiDescriptorSetLayouts *group;
+	DCmemHandle handle = dcmemRegistryAdd(&state->descriptorSetLayouts, (void **)&group);
+	if(handle == DCMEM_INVALID_HANDLE) return handle;
+	group->count = (uint32_t)count;
+	for(size_t i = 0; i < count; ++i)
+		group->layouts[i] = VK_NULL_HANDLE;
+	if(layouts != NULL) *layouts = group->layouts;
+	return handle;
 }
 
-VkVertexInputBindingDescription *dcgiAddVertexBindings(DCgState *state, size_t count) {
-	if(state->vertexBindingsCount == 0) {
-		state->vertexBindings = dcmemAllocate(sizeof(*state->vertexBindings) + sizeof(VkVertexInputBindingDescription) * count);
-		state->vertexBindingsCount += 1;
-	} else {
-		/* due to each element in the array being a different size, we manually
-		   compute the size of the array. */
-
-		size_t totalSize = 0;
-		for(size_t i = 0; i < state->vertexBindingsCount; ++i) {
-			totalSize += sizeof(state->vertexBindings[i]);
-			totalSize += state->vertexBindings[i].count * sizeof(VkVertexInputBindingDescription);
-		}
-
-		state->vertexBindings
-		  = dcmemReallocate(state->vertexBindings, totalSize + sizeof(*state->vertexBindings) + sizeof(VkVertexInputBindingDescription) * count);
-	}
-
-	state->vertexBindings[state->vertexBindingsCount - 1].count = count;
-	return state->vertexBindings[state->vertexBindingsCount - 1].bindings;
+DCmemHandle dcgiAddVertexInput(
+  DCgState *state, size_t bindingCount, VkVertexInputBindingDescription **bindings, size_t attributeCount,
+  VkVertexInputAttributeDescription **attributes
+) {
+	DC_RVASSERT(bindingCount <= DCGI_MAX_VERTEX_BINDINGS, "Too many vertex bindings in one vertex input.", DCMEM_INVALID_HANDLE);
+	DC_RVASSERT(attributeCount <= DCGI_MAX_VERTEX_ATTRIBUTES, "Too many vertex attributes in one vertex input.", DCMEM_INVALID_HANDLE);
+	DCgiVertexInput *input;
+	DCmemHandle handle = dcmemRegistryAdd(&state->vertexInputs, (void **)&input);
+	if(handle == DCMEM_INVALID_HANDLE) return handle;
+	input->bindingCount = (uint32_t)bindingCount;
+	input->attributeCount = (uint32_t)attributeCount;
+	if(bindings != NULL) *bindings = input->bindings;
+	if(attributes != NULL) *attributes = input->attributes;
+	return handle;
 }
 
-VkVertexInputAttributeDescription *dcgiAddVertexAttributes(DCgState *state, size_t count) {
-	if(state->vertexAttributesCount == 0) {
-		state->vertexAttributes = dcmemAllocate(sizeof(*state->vertexAttributes) + sizeof(VkVertexInputAttributeDescription) * count);
-		state->vertexAttributesCount += 1;
-	} else {
-		/* due to each element in the array being a different size, we manually
-		   compute the size of the array. */
-
-		size_t totalSize = 0;
-		for(size_t i = 0; i < state->vertexAttributesCount; ++i) {
-			totalSize += sizeof(state->vertexAttributes[i]);
-			totalSize += state->vertexAttributes[i].count * sizeof(VkVertexInputAttributeDescription);
-		}
+void dcgiRemovePushConstantRanges(DCgState *state, DCmemHandle handle) {
+	if(!dcmemRegistryRemove(&state->pushConstantRanges, handle)) DCD_WARNING("Tried to remove push constant ranges with an invalid handle.");
+}
 
-		state->vertexAttributes
-		  = dcmemReallocate(state->vertexAttributes, totalSize + sizeof(*state->vertexAttributes) + sizeof(VkVertexInputAttributeDescription) * count);
-	}
+void dcgiRemoveDescriptorSetLayouts(DCgState *state, DCmemHandle handle) {
+	DCgiDescriptorSetLayouts *group = DCMEM_REGISTRY_GET(&state->descriptorSetLayouts, handle, DCgiDescriptorSetLayouts);
+	DC_RASSERT(group != NULL, "Tried to remove descriptor set layouts with an invalid handle.");
+	for(uint32_t i = 0; i < group->count; ++i)
+		if(group->layouts[i] != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(state->device, group->layouts[i], state->allocator);
+	dcmemRegistryRemove(&state->descriptorSetLayouts, handle);
+}
 
-	state->vertexAttributes[state->vertexAttributesCount - 1].count = count;
-	return state->vertexAttributes[state->vertexAttributesCount - 1].attributes;
+void dcgiRemoveVertexInput(DCgState *state, DCmemHandle handle) {
+	if(!dcmemRegistryRemove(&state->vertexInputs, handle)) DCD_WARNING("Tried to remove a vertex input with an invalid handle.");
 }
 
 VkRenderPass dcgiAddRenderPass(
@@ -3,6 +3,123 @@
 #include <dcore/graphics.h>
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
+#include <pthread.h>
+
+/** number of frames the CPU can record ahead of the GPU. */
+#define DCG_FRAMES_IN_FLIGHT 2
+
+/** size of the single block of the command scope arena, command allocations that don't fit come from the heap. */
+#define DCGI_COMMAND_ARENA_SIZE (256 * 1024)
+
+/** VkAllocationCallbacks backed by dcmem, counts driver host memory per VkSystemAllocationScope. */
+typedef struct DCgiHostAllocator {
+	VkAllocationCallbacks callbacks;
+	pthread_mutex_t mutex; // drivers may call back from any thread that uses Vulkan.
+	DCgHostMemoryStats stats[DCG_HOST_MEMORY_SCOPE_COUNT];
+	DCmemArena commandArena; // command scope allocations, reset once none of them is live.
+	size_t commandLiveCount; // live allocations in the command arena.
+} DCgiHostAllocator;
+
+void dcgiInitHostAllocator(DCgiHostAllocator *allocator);
+void dcgiFreeHostAllocator(DCgiHostAllocator *allocator);
+
+/** size of the device memory blocks sub-allocations are taken from. */
+#define DCGI_MEMORY_BLOCK_SIZE (64 * 1024 * 1024)
+/** log2 of the smallest sub-allocation. */
+#define DCGI_MEMORY_MIN_ORDER 10
+#define DCGI_MEMORY_MAX_ORDERS 32
+
+/** resources with linear (buffers) and optimal (images) tiling are kept in separate blocks, so bufferImageGranularity never applies. */
+typedef enum DCgiMemoryTiling {
+	DCGI_MEMORY_TILING_LINEAR,
+	DCGI_MEMORY_TILING_OPTIMAL,
+	DCGI_MEMORY_TILING_COUNT,
+} DCgiMemoryTiling;
+
+/**
+ * a single VkDeviceMemory allocation, managed by a buddy allocator with a unit of 1 << DCGI_MEMORY_MIN_ORDER bytes.
+ * dedicated blocks hold a single allocation that is too big for a regular block.
+ **/
+typedef struct DCgiMemoryBlock {
+	VkDeviceMemory memory;
+	VkDeviceSize size, usedBytes;
+	size_t allocationCount;
+	uint32_t memoryType;
+	DCgiMemoryTiling tiling;
+	bool dedicated;
+	uint8_t *mapping; // persistent mapping of host visible blocks.
+
+	uint32_t maxOrder;
+	uint32_t freeHeads[DCGI_MEMORY_MAX_ORDERS]; // first free unit of every order, UINT32_MAX if there's none.
+	uint32_t *nextFree, *prevFree;              // free list links, valid for the first unit of free nodes.
+	uint8_t *orders;                            // order of the node starting at a unit, the high bit is set if the node is free.
+
+	struct DCgiMemoryBlock *next;
+} DCgiMemoryBlock;
+
+struct DCgAlloc {
+	DCgiMemoryBlock *block;
+	VkDeviceSize offset, size;
+};
+
+struct DCgBuffer {
+	VkBuffer buffer;
+	DCgAlloc alloc;
+	VkDeviceSize size;
+	VkBufferUsageFlags usage;
+	DCgMemoryUsage memoryUsage;
+	DCgBuffer *prev, *next; // list of all buffers, walked when defragmenting.
+};
+
+/**
+ * sub-allocates device memory, required properties must be supported by the memory type, preferred ones are taken if possible.
+ * returns false if there isn't a fitting memory type or the device is out of memory.
+ **/
+bool dcgiAllocate(
+  DCgState *state, const VkMemoryRequirements *requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, DCgiMemoryTiling tiling,
+  DCgAlloc *alloc
+);
+void dcgiFree(DCgState *state, DCgAlloc *alloc);
+void dcgiInitDeviceMemory(DCgState *state);
+void dcgiFreeDeviceMemory(DCgState *state);
+
+/** GPU zones per frame, each takes two timestamp queries. */
+#define DCGI_MAX_GPU_ZONES 128
+/** deeper GPU zones aren't timed. */
+#define DCGI_MAX_GPU_ZONE_DEPTH 16
+
+/** the GPU zones recorded in a frame slot, read back when the slot is reused. */
+typedef struct DCgiGpuFrame {
+	bool reset; // the reset of the queries was submitted by dcgBeginFrame, zones aren't timed before.
+	uint32_t zoneCount;
+	const char *names[DCGI_MAX_GPU_ZONES];
+	uint32_t depths[DCGI_MAX_GPU_ZONES];
+} DCgiGpuFrame;
+
+typedef struct DCgiGpuTimer {
+	VkQueryPool pools[DCG_FRAMES_IN_FLIGHT]; // VK_NULL_HANDLE if the graphics queue has no timestamps.
+	VkCommandPool commandPool;
+	VkCommandBuffer resets[DCG_FRAMES_IN_FLIGHT]; // recorded once, reset the queries of a slot outside any render pass.
+	double period;                                // nanoseconds per tick.
+	uint64_t validMask;
+	DCgiGpuFrame frames[DCG_FRAMES_IN_FLIGHT];
+	uint32_t resultCount;
+	uint64_t resultFrame;
+	DCgGpuZone results[DCGI_MAX_GPU_ZONES];
+} DCgiGpuTimer;
+
+/** measurements of the current frame, recorded with dcdRecordFrame by the next dcgBeginFrame. */
+typedef struct DCgiFrameStats {
+	uint64_t beginTicks; // glfwGetTimerValue, 0 before the first frame.
+	uint64_t waitNs;
+	uint64_t draws, triangles; // of the command buffers submitted, see dcgSubmit.
+	size_t allocations;        // allocations of dcmem when the frame began.
+} DCgiFrameStats;
+
+void dcgiInitGpuTimer(DCgState *state);
+void dcgiFreeGpuTimer(DCgState *state);
+/** reads back the zones of the frame slot that is reused and submits the reset of its queries, its fence must be signaled. */
+void dcgiReadGpuTimer(DCgState *state);
 
 typedef struct {
 	const char *name;
@@ -13,6 +130,27 @@ typedef struct {
 	bool enabled;
 } DCgiSuggestedLayer;
 
+#define DCGI_MAX_PUSH_CONSTANT_RANGES 8
+#define DCGI_MAX_DESCRIPTOR_SETS 8
+#define DCGI_MAX_VERTEX_BINDINGS 16
+#define DCGI_MAX_VERTEX_ATTRIBUTES 16
+
+typedef struct DCgiPushConstantRanges {
+	uint32_t count;
+	VkPushConstantRange ranges[DCGI_MAX_PUSH_CONSTANT_RANGES];
+} DCgiPushConstantRanges;
+
+typedef struct DCgiDescriptorSetLayouts {
+	uint32_t count;
+	VkDescriptorSetLayout layouts[DCGI_MAX_DESCRIPTOR_SETS];
+} DCgiDescriptorSetLayouts;
+
+typedef struct DCgiVertexInput {
+	uint32_t bindingCount, attributeCount;
+	VkVertexInputBindingDescription bindings[DCGI_MAX_VERTEX_BINDINGS];
+	VkVertexInputAttributeDescription attributes[DCGI_MAX_VERTEX_ATTRIBUTES];
+} DCgiVertexInput;
+
 struct DCgState {
 	VkInstance instance;
 	VkPhysicalDevice physicalDevice;
@@ -37,35 +175,33 @@ struct DCgState {
 
 	VkSwapchainKHR swapchain;
 
-	VkAllocationCallbacks *allocator;
+	VkAllocationCallbacks *allocator; // &hostAllocator.callbacks
+	DCgiHostAllocator hostAllocator;
 
 	uint32_t graphicsQueueFamily, computeQueueFamily, presentQueueFamily;
 
 	GLFWwindow *window;
 
-	size_t pushConstantRangesCount;
-	struct {
-		size_t count;
-		VkPushConstantRange ranges[];
-	} * pushConstantRanges;
+	uint32_t frame;       // index of the current frame in flight.
+	uint64_t frameNumber; // total number of frames started.
+	VkFence frameFences[DCG_FRAMES_IN_FLIGHT];
+	DCmemFrameAllocator frameAllocator; // scratch memory, valid until the frame slot is reused.
+	DCgiGpuTimer gpuTimer;
+	DCgiFrameStats frameStats;
 
-	size_t descriptorSetLayoutsCount;
-	struct {
-		size_t count;
-		VkDescriptorSetLayout layouts[];
-	} * descriptorSetLayouts;
+	DCmemPool materialPool;
 
-	size_t vertexBindingsCount;
-	struct {
-		size_t count;
-		VkVertexInputBindingDescription bindings[];
-	} * vertexBindings;
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDeviceSize nonCoherentAtomSize;
+	uint32_t maxMemoryAllocationCount;
+	DCgiMemoryBlock *memoryBlocks[VK_MAX_MEMORY_TYPES][DCGI_MEMORY_TILING_COUNT];
+	size_t memoryBlockCount; // number of live vkAllocateMemory allocations.
+	DCmemPool bufferPool;
+	DCgBuffer *buffers;
 
-	size_t vertexAttributesCount;
-	struct {
-		size_t count;
-		VkVertexInputAttributeDescription attributes[];
-	} * vertexAttributes;
+	DCmemRegistry pushConstantRanges;   // DCgiPushConstantRanges
+	DCmemRegistry descriptorSetLayouts; // DCgiDescriptorSetLayouts
+	DCmemRegistry vertexInputs;         // DCgiVertexInput
 };
 
 struct DCgMaterial {
@@ -73,21 +209,58 @@ struct DCgMaterial {
 	VkPipelineLayout layout;
 };
 
+/** a command buffer and the state bound in it, binds that repeat the state are skipped. */
+struct DCgCmdBuffer {
+	VkCommandBuffer commandBuffer;
+	DCgCmdPool *pool;
+	VkPipeline pipeline;
+	VkBuffer vertexBuffer, indexBuffer;
+	uint64_t draws, triangles;                   // added to the frame stats on submission.
+	uint32_t zoneDepth;                          // open GPU zones of the command buffer.
+	uint32_t zoneStack[DCGI_MAX_GPU_ZONE_DEPTH]; // UINT32_MAX for zones that aren't timed.
+};
+
+/** the command buffers handed out in a frame slot, they are reused once the slot's pool was reset. */
+typedef struct DCgiCmdPoolFrame {
+	VkCommandPool pool;
+	uint64_t frameNumber; // the frame the slot was last used in.
+	uint32_t used, count, capacity;
+	DCgCmdBuffer **buffers;
+} DCgiCmdPoolFrame;
+
+/** one VkCommandPool per frame in flight, each reset as a whole the first time it's used after its fence. */
+struct DCgCmdPool {
+	uint32_t queueFamily;
+	DCgiCmdPoolFrame frames[DCG_FRAMES_IN_FLIGHT];
+	DCmemPool bufferPool; // DCgCmdBuffer
+};
+
 VkRenderPass dcgiAddRenderPass(
   DCgState *state, size_t attachmentCount, VkAttachmentDescription *attachments, size_t subpassCount, VkSubpassDescription *subpasses,
   size_t dependencyCount, VkSubpassDependency *dependencies
 );
 
-VkPushConstantRange *dcgiAddPushConstantRanges(DCgState *state, size_t count);
-VkDescriptorSetLayout *dcgiAddDescriptorSetLayouts(DCgState *state, size_t count);
-VkVertexInputBindingDescription *dcgiAddVertexBindings(DCgState *state, size_t count);
-VkVertexInputAttributeDescription *dcgiAddVertexAttributes(DCgState *state, size_t count);
+/**
+ * the add functions register a group and return its handle, the arrays are set to the (uninitialized) entries
+ * and stay valid until the next registration of the same kind.
+ **/
+DCmemHandle dcgiAddPushConstantRanges(DCgState *state, size_t count, VkPushConstantRange **ranges);
+DCmemHandle dcgiAddDescriptorSetLayouts(DCgState *state, size_t count, VkDescriptorSetLayout **layouts);
+DCmemHandle dcgiAddVertexInput(
+  DCgState *state, size_t bindingCount, VkVertexInputBindingDescription **bindings, size_t attributeCount,
+  VkVertexInputAttributeDescription **attributes
+);
+
+/** removing descriptor set layouts destroys them. */
+void dcgiRemovePushConstantRanges(DCgState *state, DCmemHandle handle);
+void dcgiRemoveDescriptorSetLayouts(DCgState *state, DCmemHandle handle);
+void dcgiRemoveVertexInput(DCgState *state, DCmemHandle handle);
 
 VkRenderPass dcgiGetRenderPass(DCgState *state, size_t index);
-size_t dcgiGetPushConstantRanges(DCgState *state, int index, const VkPushConstantRange **ranges);
-size_t dcgiGetSetLayouts(DCgState *state, int index, const VkDescriptorSetLayout **layouts);
-size_t dcgiGetVertexBindings(DCgState *state, int index, const VkVertexInputBindingDescription **descriptions);
-size_t dcgiGetVertexAttributes(DCgState *state, int index, const VkVertexInputAttributeDescription **descriptions);
+size_t dcgiGetPushConstantRanges(DCgState *state, DCmemHandle handle, const VkPushConstantRange **ranges);
+size_t dcgiGetSetLayouts(DCgState *state, DCmemHandle handle, const VkDescriptorSetLayout **layouts);
+size_t dcgiGetVertexBindings(DCgState *state, DCmemHandle handle, const VkVertexInputBindingDescription **descriptions);
+size_t dcgiGetVertexAttributes(DCgState *state, DCmemHandle handle, const VkVertexInputAttributeDescription **descriptions);
 VkQueue dcgiGetQueue(DCgState *state, uint32_t index);
 
 enum DCgiSuggestedExtensionIndex {
@@ -2,28 +2,28 @@
 #include <dcore/graphics.h>
 #include <dcore/graphics/internal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vulkan/vulkan_core.h>
 
 void CreateLayout_(DCgState *state, DCgMaterial *material, DCgMaterialOptions *options) {
 	VkPipelineLayoutCreateInfo createInfo = { 0 };
 	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	createInfo.pushConstantRangeCount = (uint32_t)dcgiGetPushConstantRanges(state, options->pushConstantsIndex, NULL);
-	dcgiGetPushConstantRanges(state, 0, &createInfo.pPushConstantRanges);
-	createInfo.setLayoutCount = (uint32_t)dcgiGetSetLayouts(state, options->descriptorSetsIndex, NULL);
-	dcgiGetSetLayouts(state, options->descriptorSetsIndex, &createInfo.pSetLayouts);
+	createInfo.pushConstantRangeCount = (uint32_t)dcgiGetPushConstantRanges(state, options->pushConstants, &createInfo.pPushConstantRanges);
+	createInfo.setLayoutCount = (uint32_t)dcgiGetSetLayouts(state, options->descriptorSets, &createInfo.pSetLayouts);
 	vkCreatePipelineLayout(state->device, &createInfo, NULL, &material->layout);
 }
 
 DCgMaterial *dcgNewMaterial(DCgState *state, size_t moduleCount, DCgShaderModule *modules, DCgMaterialOptions *options, DCgMaterialCache *cache) {
-	DCgMaterial *material = malloc(sizeof(DCgMaterial));
+	DCD_BEGIN_ZONE("dcgNewMaterial");
+	DCgMaterial *material = DCMEM_POOL_ALLOCATE(&state->materialPool, DCgMaterial);
 	CreateLayout_(state, material, options);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = { 0 };
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = (uint32_t)dcgiGetVertexBindings(state, options->vertexInputIndex, NULL);
-	dcgiGetVertexBindings(state, options->vertexInputIndex, &vertexInputInfo.pVertexBindingDescriptions);
-	vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)dcgiGetVertexAttributes(state, options->vertexInputIndex, NULL);
-	dcgiGetVertexAttributes(state, options->vertexInputIndex, &vertexInputInfo.pVertexAttributeDescriptions);
+	vertexInputInfo.vertexBindingDescriptionCount
+	  = (uint32_t)dcgiGetVertexBindings(state, options->vertexInput, &vertexInputInfo.pVertexBindingDescriptions);
+	vertexInputInfo.vertexAttributeDescriptionCount
+	  = (uint32_t)dcgiGetVertexAttributes(state, options->vertexInput, &vertexInputInfo.pVertexAttributeDescriptions);
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = { 0 };
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -107,7 +107,10 @@ DCgMaterial *dcgNewMaterial(DCgState *state, size_t moduleCount, DCgShaderModule
 	depthStencilState.maxDepthBounds = options->maxDepthBound;
 	depthStencilState.stencilTestEnable = options->enableStencilTest;
 
-	VkPipelineShaderStageCreateInfo *shaderStages = calloc(moduleCount, sizeof(VkPipelineShaderStageCreateInfo));
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+	VkPipelineShaderStageCreateInfo *shaderStages = DCMEM_PUSH_ARRAY(scratch, VkPipelineShaderStageCreateInfo, moduleCount);
+	memset(shaderStages, 0, sizeof(VkPipelineShaderStageCreateInfo) * moduleCount);
 
 	for(size_t i = 0; i < moduleCount; ++i) {
 		shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -140,7 +143,8 @@ DCgMaterial *dcgNewMaterial(DCgState *state, size_t moduleCount, DCgShaderModule
 	  "Failed to create pipeline!"
 	);
 
-	free(shaderStages);
+	dcmemRestoreArenaMarker(scratch, marker);
+	DCD_END_ZONE();
 	return material;
 }
 
@@ -162,7 +166,7 @@ void dcgFreeMaterial(DCgState *state, DCgMaterial *material) {
 	}
 	else vkDestroyPipelineLayout(state->device, material->layout, state->allocator);
 
-	free(material);
+	dcmemPoolDeallocate(&state->materialPool, material);
 }
 
 DCgMaterialCache *dcgGetMaterialCache(DCgState *state, DCgMaterial *material) {
@@ -13,4 +13,62 @@ void dcgGetMousePosition(DCgState *state, DCmVector2i mousePosition) {
 	mousePosition[1] = ypos;
 }
 
+void dcgGetMouseRay(DCgState *state, DCmMatrix4x4f inverseViewProjection, DCmRay *ray) {
+	// the cursor position and the window size are both in screen coordinates.
+	double xpos, ypos;
+	int width, height;
+	glfwGetCursorPos(state->window, &xpos, &ypos);
+	glfwGetWindowSize(state->window, &width, &height);
+	float x = width > 0 ? (float)(xpos / width) * 2.0f - 1.0f : 0.0f;
+	float y = height > 0 ? (float)(ypos / height) * 2.0f - 1.0f : 0.0f;
+	dcmRayFromScreen(ray, inverseViewProjection, x, y);
+}
+
 void dcgUpdate(DCgState *state) { glfwPollEvents(); }
+
+static uint64_t ticksToNs(uint64_t ticks) { return (uint64_t)((double)ticks * 1e9 / (double)glfwGetTimerFrequency()); }
+
+/** records the frame that ends now and starts measuring the next one. */
+static void recordFrameStats(DCgState *state, uint64_t now) {
+	DCgiFrameStats *stats = &state->frameStats;
+	DCmemAllocStats allocStats = dcmemGetAllocStats();
+	size_t allocations = allocStats.allocCount + allocStats.poolAllocCount;
+	if(stats->beginTicks != 0) {
+		uint64_t values[DCD_FRAME_STAT_COUNT] = {
+			[DCD_FRAME_STAT_CPU_NS] = ticksToNs(now - stats->beginTicks),
+			[DCD_FRAME_STAT_WAIT_NS] = stats->waitNs,
+			[DCD_FRAME_STAT_DRAWS] = stats->draws,
+			[DCD_FRAME_STAT_TRIANGLES] = stats->triangles,
+			[DCD_FRAME_STAT_ALLOCATIONS] = allocations - stats->allocations,
+		};
+		dcdRecordFrame(values);
+	}
+	*stats = (DCgiFrameStats){ .beginTicks = now, .allocations = allocations };
+}
+
+void dcgBeginFrame(DCgState *state) {
+	dcdMarkFrame();
+	recordFrameStats(state, glfwGetTimerValue());
+	// ended by dcgEndFrame.
+	DCD_BEGIN_ZONE("frame");
+	DCD_BEGIN_ZONE("frame fence");
+	uint64_t waitBegin = glfwGetTimerValue();
+	vkWaitForFences(state->device, 1, &state->frameFences[state->frame], VK_TRUE, UINT64_MAX);
+	state->frameStats.waitNs = ticksToNs(glfwGetTimerValue() - waitBegin);
+	DCD_END_ZONE();
+	dcgiReadGpuTimer(state);
+	dcmemBeginFrame(&state->frameAllocator, state->frame);
+}
+
+void dcgEndFrame(DCgState *state) {
+	DCD_END_ZONE();
+	// an empty submission signals the fence once all previously submitted work is done.
+	vkResetFences(state->device, 1, &state->frameFences[state->frame]);
+	DC_RASSERT(
+	  vkQueueSubmit(dcgiGetQueue(state, state->graphicsQueueFamily), 0, NULL, state->frameFences[state->frame]) == VK_SUCCESS,
+	  "Failed to submit the frame fence"
+	);
+
+	state->frame = (state->frame + 1) % DCG_FRAMES_IN_FLIGHT;
+	state->frameNumber += 1;
+}
@@ -0,0 +1,166 @@
+#include <dcore/common.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <string.h>
+
+void dcgiInitGpuTimer(DCgState *state) {
+	DCgiGpuTimer *timer = &state->gpuTimer;
+	memset(timer, 0, sizeof(DCgiGpuTimer));
+
+	uint32_t familyCount;
+	vkGetPhysicalDeviceQueueFamilyProperties(state->physicalDevice, &familyCount, NULL);
+	DCmemArena *scratch = dcmemGetFrameArena(&state->frameAllocator);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(scratch);
+	VkQueueFamilyProperties *families = DCMEM_PUSH_ARRAY(scratch, VkQueueFamilyProperties, familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(state->physicalDevice, &familyCount, families);
+	uint32_t validBits = families[state->graphicsQueueFamily].timestampValidBits;
+	dcmemRestoreArenaMarker(scratch, marker);
+	if(validBits == 0) {
+		DCD_INFO("The graphics queue has no timestamps, GPU zones aren't timed.");
+		return;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(state->physicalDevice, &properties);
+	timer->period = properties.limits.timestampPeriod;
+	timer->validMask = validBits >= 64 ? UINT64_MAX : (UINT64_C(1) << validBits) - 1;
+
+	VkQueryPoolCreateInfo createInfo = { 0 };
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = 2 * DCGI_MAX_GPU_ZONES;
+	for(size_t i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i) {
+		if(vkCreateQueryPool(state->device, &createInfo, state->allocator, &timer->pools[i]) != VK_SUCCESS) {
+			DCD_WARNING("Failed to create a timestamp query pool, GPU zones aren't timed.");
+			dcgiFreeGpuTimer(state);
+			return;
+		}
+	}
+
+	// zones are usually recorded inside render passes where queries can't be reset, so each slot has a command buffer
+	// that only resets its queries. dcgBeginFrame submits it before the command buffers of the frame.
+	VkCommandPoolCreateInfo poolInfo = { 0 };
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = state->graphicsQueueFamily;
+	if(vkCreateCommandPool(state->device, &poolInfo, state->allocator, &timer->commandPool) != VK_SUCCESS) {
+		DCD_WARNING("Failed to create the query reset command pool, GPU zones aren't timed.");
+		dcgiFreeGpuTimer(state);
+		return;
+	}
+	VkCommandBufferAllocateInfo allocateInfo = { 0 };
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = timer->commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = DCG_FRAMES_IN_FLIGHT;
+	VkCommandBufferBeginInfo beginInfo = { 0 };
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	bool recorded = vkAllocateCommandBuffers(state->device, &allocateInfo, timer->resets) == VK_SUCCESS;
+	for(size_t i = 0; recorded && i < DCG_FRAMES_IN_FLIGHT; ++i) {
+		recorded = vkBeginCommandBuffer(timer->resets[i], &beginInfo) == VK_SUCCESS;
+		if(recorded) vkCmdResetQueryPool(timer->resets[i], timer->pools[i], 0, 2 * DCGI_MAX_GPU_ZONES);
+		recorded = recorded && vkEndCommandBuffer(timer->resets[i]) == VK_SUCCESS;
+	}
+	if(!recorded) {
+		DCD_WARNING("Failed to record the query reset command buffers, GPU zones aren't timed.");
+		dcgiFreeGpuTimer(state);
+	}
+}
+
+void dcgiFreeGpuTimer(DCgState *state) {
+	DCgiGpuTimer *timer = &state->gpuTimer;
+	// destroying the command pool frees the reset command buffers.
+	if(timer->commandPool != VK_NULL_HANDLE) vkDestroyCommandPool(state->device, timer->commandPool, state->allocator);
+	timer->commandPool = VK_NULL_HANDLE;
+	for(size_t i = 0; i < DCG_FRAMES_IN_FLIGHT; ++i) {
+		if(timer->pools[i] != VK_NULL_HANDLE) vkDestroyQueryPool(state->device, timer->pools[i], state->allocator);
+		timer->pools[i] = VK_NULL_HANDLE;
+		timer->resets[i] = VK_NULL_HANDLE;
+	}
+}
+
+/** converts the zones recorded in a frame slot and reports them with the CPU zones. */
+static void readZones(DCgState *state, DCgiGpuTimer *timer, DCgiGpuFrame *frame) {
+	// the fence of the slot was waited for, so the results are there unless a zone wasn't ended. no waiting either way.
+	uint64_t results[DCGI_MAX_GPU_ZONES * 2][2]; // value, availability
+	vkGetQueryPoolResults(
+	  state->device, timer->pools[state->frame], 0, frame->zoneCount * 2, sizeof(results), results, sizeof(results[0]),
+	  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
+	);
+
+	// zones are summarized by name like the CPU zones, a zone recorded per draw is one summary.
+	DCdZoneSummary summaries[DCGI_MAX_GPU_ZONES];
+	size_t summaryCount = 0;
+	uint64_t first = 0;
+	timer->resultCount = 0;
+	timer->resultFrame = state->frameNumber - DCG_FRAMES_IN_FLIGHT;
+	for(uint32_t zone = 0; zone < frame->zoneCount; ++zone) {
+		const uint64_t *begin = results[zone * 2], *end = results[zone * 2 + 1];
+		if(begin[1] == 0 || end[1] == 0) continue;
+		if(timer->resultCount == 0) first = begin[0];
+		DCgGpuZone *result = &timer->results[timer->resultCount];
+		*result = (DCgGpuZone){
+			.name = frame->names[zone],
+			.depth = frame->depths[zone],
+			.beginNs = (uint64_t)((double)((begin[0] - first) & timer->validMask) * timer->period),
+			.durationNs = (uint64_t)((double)((end[0] - begin[0]) & timer->validMask) * timer->period),
+		};
+		timer->resultCount++;
+
+		size_t s = 0;
+		while(s < summaryCount && summaries[s].name != result->name && strcmp(summaries[s].name, result->name) != 0)
+			++s;
+		if(s == summaryCount) summaries[summaryCount++] = (DCdZoneSummary){ .name = result->name };
+		summaries[s].count += 1;
+		summaries[s].totalNs += result->durationNs;
+		if(result->durationNs > summaries[s].maxNs) summaries[s].maxNs = result->durationNs;
+	}
+	dcdSetExternalFrameZones("gpu", summaries, summaryCount);
+}
+
+void dcgiReadGpuTimer(DCgState *state) {
+	DCgiGpuTimer *timer = &state->gpuTimer;
+	DCgiGpuFrame *frame = &timer->frames[state->frame];
+	if(timer->pools[state->frame] == VK_NULL_HANDLE || (frame->reset && frame->zoneCount == 0)) return;
+	if(frame->zoneCount != 0) readZones(state, timer, frame);
+	frame->zoneCount = 0;
+
+	// query commands of a queue run in submission order, so the reset is done before the zones of the frame.
+	VkSubmitInfo submitInfo = { 0 };
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &timer->resets[state->frame];
+	frame->reset = vkQueueSubmit(dcgiGetQueue(state, state->graphicsQueueFamily), 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS;
+	if(!frame->reset) DCD_WARNING("Failed to submit the reset of the GPU zone queries, the zones of the frame aren't timed.");
+}
+
+void dcgCmdBeginGpuZone(DCgState *s, DCgCmdBuffer *cmds, const char *name) {
+	DCgiGpuTimer *timer = &s->gpuTimer;
+	DCgiGpuFrame *frame = &timer->frames[s->frame];
+	VkQueryPool pool = timer->pools[s->frame];
+	uint32_t depth = cmds->zoneDepth++;
+	if(depth >= DCGI_MAX_GPU_ZONE_DEPTH) return;
+	// the queries are only reset in the graphics queue, see dcgiReadGpuTimer.
+	if(pool == VK_NULL_HANDLE || !frame->reset || frame->zoneCount == DCGI_MAX_GPU_ZONES || cmds->pool->queueFamily != s->graphicsQueueFamily) {
+		cmds->zoneStack[depth] = UINT32_MAX;
+		return;
+	}
+
+	uint32_t zone = frame->zoneCount++;
+	frame->names[zone] = name;
+	frame->depths[zone] = depth;
+	cmds->zoneStack[depth] = zone;
+	vkCmdWriteTimestamp(cmds->commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, zone * 2);
+}
+
+void dcgCmdEndGpuZone(DCgState *s, DCgCmdBuffer *cmds) {
+	if(cmds->zoneDepth == 0) return;
+	uint32_t depth = --cmds->zoneDepth;
+	if(depth >= DCGI_MAX_GPU_ZONE_DEPTH || cmds->zoneStack[depth] == UINT32_MAX) return;
+	vkCmdWriteTimestamp(cmds->commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s->gpuTimer.pools[s->frame], cmds->zoneStack[depth] * 2 + 1);
+}
+
+size_t dcgGetGpuZones(DCgState *s, const DCgGpuZone **zones, uint64_t *frameNumber) {
+	*zones = s->gpuTimer.results;
+	if(frameNumber != NULL) *frameNumber = s->gpuTimer.resultFrame;
+	return s->gpuTimer.resultCount;
+}
@@ -1,3 +1,5 @@
 
 #include <dcore/math/vector.h>
 #include <dcore/math/matrix.h>
+#include <dcore/math/quaternion.h>
+#include <dcore/math/transform.h>
@@ -0,0 +1,349 @@
+#include <dcore/math/batch.h>
+#include <dcore/math/simd.h>
+#include <math.h>
+#include <string.h>
+
+static inline void transformScalar(float *dst, DCmMatrix4x4f m, const float *v, float w) {
+	float x = m[0][0] * v[0] + m[1][0] * v[1] + m[2][0] * v[2] + m[3][0] * w;
+	float y = m[0][1] * v[0] + m[1][1] * v[1] + m[2][1] * v[2] + m[3][1] * w;
+	float z = m[0][2] * v[0] + m[1][2] * v[1] + m[2][2] * v[2] + m[3][2] * w;
+	dst[0] = x, dst[1] = y, dst[2] = z;
+}
+
+static inline float inverseLengthScalar(float x, float y, float z) {
+	float lengthSquared = x * x + y * y + z * z;
+	return lengthSquared > 0.0f ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+}
+
+#if defined(DCM_X86)
+/** the matrix broadcast per element, column major. */
+typedef struct Matrix8 {
+	__m256 m[4][3];
+} Matrix8;
+
+DCM_TARGET("avx2,fma") static inline Matrix8 broadcastMatrix(DCmMatrix4x4f m) {
+	Matrix8 result;
+	for(int c = 0; c < 4; ++c)
+		for(int r = 0; r < 3; ++r)
+			result.m[c][r] = _mm256_set1_ps(m[c][r]);
+	return result;
+}
+
+/** transforms eight vectors, translation is only added for points. */
+DCM_TARGET("avx2,fma") static inline void transform8(const Matrix8 *m, __m256 *x, __m256 *y, __m256 *z, bool point) {
+	__m256 v[3] = { *x, *y, *z };
+	__m256 result[3];
+	for(int r = 0; r < 3; ++r) {
+		__m256 sum = point ? m->m[3][r] : _mm256_setzero_ps();
+		sum = _mm256_fmadd_ps(m->m[0][r], v[0], sum);
+		sum = _mm256_fmadd_ps(m->m[1][r], v[1], sum);
+		result[r] = _mm256_fmadd_ps(m->m[2][r], v[2], sum);
+	}
+	*x = result[0], *y = result[1], *z = result[2];
+}
+
+DCM_TARGET("avx2,fma") static inline void normalize8(__m256 *x, __m256 *y, __m256 *z) {
+	__m256 lengthSquared = _mm256_fmadd_ps(*z, *z, _mm256_fmadd_ps(*y, *y, _mm256_mul_ps(*x, *x)));
+	// a full division instead of rsqrt, so results match the scalar code.
+	__m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSquared));
+	inverse = _mm256_and_ps(inverse, _mm256_cmp_ps(lengthSquared, _mm256_setzero_ps(), _CMP_GT_OQ));
+	*x = _mm256_mul_ps(*x, inverse), *y = _mm256_mul_ps(*y, inverse), *z = _mm256_mul_ps(*z, inverse);
+}
+
+DCM_TARGET("avx2,fma") static inline __m256 dot8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz) {
+	return _mm256_fmadd_ps(az, bz, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(ax, bx)));
+}
+
+DCM_TARGET("avx2,fma") static inline void cross8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz, __m256 *x, __m256 *y, __m256 *z) {
+	*x = _mm256_fmsub_ps(ay, bz, _mm256_mul_ps(az, by));
+	*y = _mm256_fmsub_ps(az, bx, _mm256_mul_ps(ax, bz));
+	*z = _mm256_fmsub_ps(ax, by, _mm256_mul_ps(ay, bx));
+}
+
+/**
+ * transposes eight packed vectors (24 floats) into components. the 128 bit halves hold vectors 0-3 and 4-7,
+ * so each half is transposed with in-lane shuffles.
+ **/
+DCM_TARGET("avx2,fma") static inline void loadVectors8(const float *vectors, __m256 *x, __m256 *y, __m256 *z) {
+	__m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(vectors));
+	__m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(vectors + 4));
+	__m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(vectors + 8));
+	m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(vectors + 12), 1);
+	m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(vectors + 16), 1);
+	m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(vectors + 20), 1);
+
+	__m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	__m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	*x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	*z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+DCM_TARGET("avx2,fma") static inline void storeVectors8(float *vectors, __m256 x, __m256 y, __m256 z) {
+	__m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	__m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 m03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 m14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 m25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(vectors, _mm256_castps256_ps128(m03));
+	_mm_storeu_ps(vectors + 4, _mm256_castps256_ps128(m14));
+	_mm_storeu_ps(vectors + 8, _mm256_castps256_ps128(m25));
+	_mm_storeu_ps(vectors + 12, _mm256_extractf128_ps(m03, 1));
+	_mm_storeu_ps(vectors + 16, _mm256_extractf128_ps(m14, 1));
+	_mm_storeu_ps(vectors + 20, _mm256_extractf128_ps(m25, 1));
+}
+
+/** mask of the first count lanes, for the last iteration over streams. */
+DCM_TARGET("avx2,fma") static inline __m256i tailMask(size_t count) {
+	return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+// AoS loops process the tail in a zero padded copy, stream loops use masked loads and stores.
+#	define AOS_LOOP(COUNT, ...) \
+		size_t i = 0; \
+		for(; i + 8 <= (COUNT); i += 8) { \
+			const size_t n = 8; \
+			__VA_ARGS__ \
+		} \
+		if(i < (COUNT)) { \
+			const size_t n = (COUNT) - i; \
+			__VA_ARGS__ \
+		}
+#	define STREAM_LOOP(COUNT, ...) \
+		size_t i = 0; \
+		__m256i mask = _mm256_set1_epi32(-1); \
+		for(; i + 8 <= (COUNT); i += 8) { \
+			__VA_ARGS__ \
+		} \
+		if(i < (COUNT)) { \
+			mask = tailMask((COUNT) - i); \
+			__VA_ARGS__ \
+		}
+#	define STREAM_LOAD(POINTER) _mm256_maskload_ps((POINTER) + i, mask)
+#	define STREAM_STORE(POINTER, VALUE) _mm256_maskstore_ps((POINTER) + i, mask, (VALUE))
+
+DCM_TARGET("avx2,fma") static void loadVectorsN(const DCmVector3f *vectors, size_t n, __m256 *x, __m256 *y, __m256 *z) {
+	if(n == 8) {
+		loadVectors8(vectors[0], x, y, z);
+		return;
+	}
+	float padded[24] = { 0 };
+	memcpy(padded, vectors, n * sizeof(DCmVector3f));
+	loadVectors8(padded, x, y, z);
+}
+
+DCM_TARGET("avx2,fma") static void storeVectorsN(DCmVector3f *vectors, size_t n, __m256 x, __m256 y, __m256 z) {
+	if(n == 8) {
+		storeVectors8(vectors[0], x, y, z);
+		return;
+	}
+	float padded[24];
+	storeVectors8(padded, x, y, z);
+	memcpy(vectors, padded, n * sizeof(DCmVector3f));
+}
+
+DCM_TARGET("avx2,fma") static void transformVectorsAvx2(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count, bool point) {
+	Matrix8 m8 = broadcastMatrix(m);
+	AOS_LOOP(count, {
+		__m256 x, y, z;
+		loadVectorsN(src + i, n, &x, &y, &z);
+		transform8(&m8, &x, &y, &z, point);
+		storeVectorsN(dst + i, n, x, y, z);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void normalizeVectorsAvx2(DCmVector3f *dst, const DCmVector3f *src, size_t count) {
+	AOS_LOOP(count, {
+		__m256 x, y, z;
+		loadVectorsN(src + i, n, &x, &y, &z);
+		normalize8(&x, &y, &z);
+		storeVectorsN(dst + i, n, x, y, z);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void dotVectorsAvx2(float *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count) {
+	AOS_LOOP(count, {
+		__m256 ax, ay, az, bx, by, bz;
+		loadVectorsN(a + i, n, &ax, &ay, &az);
+		loadVectorsN(b + i, n, &bx, &by, &bz);
+		__m256 dot = dot8(ax, ay, az, bx, by, bz);
+		if(n == 8) _mm256_storeu_ps(dst + i, dot);
+		else _mm256_maskstore_ps(dst + i, tailMask(n), dot);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void crossVectorsAvx2(DCmVector3f *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count) {
+	AOS_LOOP(count, {
+		__m256 ax, ay, az, bx, by, bz, x, y, z;
+		loadVectorsN(a + i, n, &ax, &ay, &az);
+		loadVectorsN(b + i, n, &bx, &by, &bz);
+		cross8(ax, ay, az, bx, by, bz, &x, &y, &z);
+		storeVectorsN(dst + i, n, x, y, z);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void transformStreamAvx2(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count, bool point) {
+	Matrix8 m8 = broadcastMatrix(m);
+	STREAM_LOOP(count, {
+		__m256 x = STREAM_LOAD(src.x), y = STREAM_LOAD(src.y), z = STREAM_LOAD(src.z);
+		transform8(&m8, &x, &y, &z, point);
+		STREAM_STORE(dst.x, x);
+		STREAM_STORE(dst.y, y);
+		STREAM_STORE(dst.z, z);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void normalizeStreamAvx2(DCmStream3f dst, DCmStream3f src, size_t count) {
+	STREAM_LOOP(count, {
+		__m256 x = STREAM_LOAD(src.x), y = STREAM_LOAD(src.y), z = STREAM_LOAD(src.z);
+		normalize8(&x, &y, &z);
+		STREAM_STORE(dst.x, x);
+		STREAM_STORE(dst.y, y);
+		STREAM_STORE(dst.z, z);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void dotStreamAvx2(float *dst, DCmStream3f a, DCmStream3f b, size_t count) {
+	STREAM_LOOP(count, {
+		__m256 dot = dot8(STREAM_LOAD(a.x), STREAM_LOAD(a.y), STREAM_LOAD(a.z), STREAM_LOAD(b.x), STREAM_LOAD(b.y), STREAM_LOAD(b.z));
+		STREAM_STORE(dst, dot);
+	})
+}
+
+DCM_TARGET("avx2,fma") static void crossStreamAvx2(DCmStream3f dst, DCmStream3f a, DCmStream3f b, size_t count) {
+	STREAM_LOOP(count, {
+		__m256 x, y, z;
+		cross8(STREAM_LOAD(a.x), STREAM_LOAD(a.y), STREAM_LOAD(a.z), STREAM_LOAD(b.x), STREAM_LOAD(b.y), STREAM_LOAD(b.z), &x, &y, &z);
+		STREAM_STORE(dst.x, x);
+		STREAM_STORE(dst.y, y);
+		STREAM_STORE(dst.z, z);
+	})
+}
+
+#	define USE_AVX2 (dcmGetSimdLevel() >= DCM_SIMD_LEVEL_AVX2)
+#endif
+
+// with the SSE4.1 level the scalar loops are used, the compiler vectorizes them about as well.
+static void transformVectors(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count, bool point) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		transformVectorsAvx2(dst, m, src, count, point);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i)
+		transformScalar(dst[i], m, src[i], point ? 1.0f : 0.0f);
+}
+
+void dcmVector3fTransformPoints(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count) {
+	transformVectors(dst, m, src, count, true);
+}
+
+void dcmVector3fTransformDirections(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count) {
+	transformVectors(dst, m, src, count, false);
+}
+
+void dcmVector3fNormalize(DCmVector3f *dst, const DCmVector3f *src, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		normalizeVectorsAvx2(dst, src, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i) {
+		float inverse = inverseLengthScalar(src[i][0], src[i][1], src[i][2]);
+		dst[i][0] = src[i][0] * inverse, dst[i][1] = src[i][1] * inverse, dst[i][2] = src[i][2] * inverse;
+	}
+}
+
+void dcmVector3fDot(float *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		dotVectorsAvx2(dst, a, b, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i)
+		dst[i] = DCmVector3fDot(a[i], b[i]);
+}
+
+void dcmVector3fCross(DCmVector3f *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		crossVectorsAvx2(dst, a, b, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i) {
+		DCmVector3f cross = { a[i][0], a[i][1], a[i][2] };
+		DCmVector3fCross(cross, b[i]);
+		dst[i][0] = cross[0], dst[i][1] = cross[1], dst[i][2] = cross[2];
+	}
+}
+
+static void transformStream(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count, bool point) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		transformStreamAvx2(dst, m, src, count, point);
+		return;
+	}
+#endif
+	float w = point ? 1.0f : 0.0f;
+	for(size_t i = 0; i < count; ++i) {
+		float v[3] = { src.x[i], src.y[i], src.z[i] };
+		transformScalar(v, m, v, w);
+		dst.x[i] = v[0], dst.y[i] = v[1], dst.z[i] = v[2];
+	}
+}
+
+void dcmStream3fTransformPoints(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count) { transformStream(dst, m, src, count, true); }
+void dcmStream3fTransformDirections(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count) { transformStream(dst, m, src, count, false); }
+
+void dcmStream3fNormalize(DCmStream3f dst, DCmStream3f src, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		normalizeStreamAvx2(dst, src, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i) {
+		float inverse = inverseLengthScalar(src.x[i], src.y[i], src.z[i]);
+		dst.x[i] = src.x[i] * inverse, dst.y[i] = src.y[i] * inverse, dst.z[i] = src.z[i] * inverse;
+	}
+}
+
+void dcmStream3fDot(float *dst, DCmStream3f a, DCmStream3f b, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		dotStreamAvx2(dst, a, b, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i)
+		dst[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+}
+
+void dcmStream3fCross(DCmStream3f dst, DCmStream3f a, DCmStream3f b, size_t count) {
+#if defined(DCM_X86)
+	if(USE_AVX2) {
+		crossStreamAvx2(dst, a, b, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i) {
+		float x = a.y[i] * b.z[i] - a.z[i] * b.y[i], y = a.z[i] * b.x[i] - a.x[i] * b.z[i];
+		dst.z[i] = a.x[i] * b.y[i] - a.y[i] * b.x[i];
+		dst.x[i] = x, dst.y[i] = y;
+	}
+}
+
+void dcmStream3fFromVectors(DCmStream3f dst, const DCmVector3f *src, size_t count) {
+	for(size_t i = 0; i < count; ++i)
+		dst.x[i] = src[i][0], dst.y[i] = src[i][1], dst.z[i] = src[i][2];
+}
+
+void dcmStream3fToVectors(DCmVector3f *dst, DCmStream3f src, size_t count) {
+	for(size_t i = 0; i < count; ++i)
+		dst[i][0] = src.x[i], dst[i][1] = src.y[i], dst[i][2] = src.z[i];
+}
@@ -0,0 +1,43 @@
+#ifndef DCORE_MATH_BATCH_H
+#define DCORE_MATH_BATCH_H
+#include <dcore/math/common.h>
+#include <dcore/math/vector.h>
+#include <dcore/math/matrix.h>
+
+/**
+ * functions working on whole arrays of DCmVector3f, using the kernel of the level returned by dcmGetSimdLevel.
+ * the AVX2 kernels do eight vectors per iteration, any count works. dst may be one of the sources.
+ * there are versions for arrays of vectors (AoS) and for streams of components (SoA), streams are faster
+ * as they don't need to be transposed.
+ **/
+
+/** x[i], y[i] and z[i] form the vector i. */
+typedef struct DCmStream3f {
+	float *x, *y, *z;
+} DCmStream3f;
+
+typedef struct DCmStream4f {
+	float *x, *y, *z, *w;
+} DCmStream4f;
+
+/** dst[i] = m * (src[i], 1), the w component isn't divided out. */
+void dcmVector3fTransformPoints(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count);
+/** dst[i] = m * (src[i], 0) */
+void dcmVector3fTransformDirections(DCmVector3f *dst, DCmMatrix4x4f m, const DCmVector3f *src, size_t count);
+/** zero vectors stay zero. */
+void dcmVector3fNormalize(DCmVector3f *dst, const DCmVector3f *src, size_t count);
+void dcmVector3fDot(float *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count);
+/** dst[i] = a[i] x b[i] */
+void dcmVector3fCross(DCmVector3f *dst, const DCmVector3f *a, const DCmVector3f *b, size_t count);
+
+void dcmStream3fTransformPoints(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count);
+void dcmStream3fTransformDirections(DCmStream3f dst, DCmMatrix4x4f m, DCmStream3f src, size_t count);
+void dcmStream3fNormalize(DCmStream3f dst, DCmStream3f src, size_t count);
+void dcmStream3fDot(float *dst, DCmStream3f a, DCmStream3f b, size_t count);
+void dcmStream3fCross(DCmStream3f dst, DCmStream3f a, DCmStream3f b, size_t count);
+
+/** converts between arrays of vectors and streams. */
+void dcmStream3fFromVectors(DCmStream3f dst, const DCmVector3f *src, size_t count);
+void dcmStream3fToVectors(DCmVector3f *dst, DCmStream3f src, size_t count);
+
+#endif
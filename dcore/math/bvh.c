@@ -0,0 +1,368 @@
+#include <dcore/math/bvh.h>
+#include <dcore/math/simd.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BIN_COUNT 16
+/** past this depth nodes are split in half, which bounds the depth of the tree and the traversal stacks. */
+#define MAX_SAH_DEPTH 40
+#define STACK_SIZE 96
+/** subtrees with fewer primitives are not worth a thread. */
+#define PARALLEL_THRESHOLD 4096
+
+typedef struct Builder {
+	const DCmAabb *boxes;
+	DCmVector3f *centroids;
+	DCmBvhNode *nodes;
+	uint32_t *indices;
+	atomic_uint nodeCount;
+} Builder;
+
+typedef struct BuildTask {
+	Builder *builder;
+	uint32_t node, first, count, depth, threadCount;
+} BuildTask;
+
+static inline void emptyBounds(float *min, float *max) {
+	for(int a = 0; a < 3; ++a)
+		min[a] = INFINITY, max[a] = -INFINITY;
+}
+
+static inline void growBounds(float *min, float *max, const float *boxMin, const float *boxMax) {
+	for(int a = 0; a < 3; ++a) {
+		min[a] = fminf(min[a], boxMin[a]);
+		max[a] = fmaxf(max[a], boxMax[a]);
+	}
+}
+
+/** half the surface area, enough to compare costs. */
+static inline float halfArea(const float *min, const float *max) {
+	float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+	return x * y + y * z + z * x;
+}
+
+typedef struct Split {
+	int axis, bin;
+	float cost;
+} Split;
+
+static Split findSplit(Builder *builder, uint32_t first, uint32_t count, const float *centroidMin, const float *centroidMax) {
+	Split best = { -1, 0, INFINITY };
+	for(int axis = 0; axis < 3; ++axis) {
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if(extent <= 0.0f) continue;
+
+		float scale = BIN_COUNT / extent;
+		uint32_t binCounts[BIN_COUNT] = { 0 };
+		DCmVector3f binMins[BIN_COUNT], binMaxs[BIN_COUNT];
+		for(int b = 0; b < BIN_COUNT; ++b)
+			emptyBounds(binMins[b], binMaxs[b]);
+		for(uint32_t i = first; i < first + count; ++i) {
+			uint32_t primitive = builder->indices[i];
+			int bin = (int)((builder->centroids[primitive][axis] - centroidMin[axis]) * scale);
+			bin = bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+			binCounts[bin]++;
+			growBounds(binMins[bin], binMaxs[bin], builder->boxes[primitive].min, builder->boxes[primitive].max);
+		}
+
+		// sweep from the left, then from the right, the cost of splitting after bin b is area * count of both sides.
+		float leftCosts[BIN_COUNT - 1];
+		DCmVector3f min, max;
+		emptyBounds(min, max);
+		uint32_t sideCount = 0;
+		for(int b = 0; b < BIN_COUNT - 1; ++b) {
+			sideCount += binCounts[b];
+			if(binCounts[b] != 0) growBounds(min, max, binMins[b], binMaxs[b]);
+			leftCosts[b] = sideCount != 0 ? halfArea(min, max) * sideCount : 0.0f;
+		}
+		emptyBounds(min, max);
+		sideCount = 0;
+		for(int b = BIN_COUNT - 1; b > 0; --b) {
+			sideCount += binCounts[b];
+			if(binCounts[b] != 0) growBounds(min, max, binMins[b], binMaxs[b]);
+			float cost = leftCosts[b - 1] + (sideCount != 0 ? halfArea(min, max) * sideCount : 0.0f);
+			if(sideCount != 0 && sideCount != count && cost < best.cost) best = (Split){ axis, b, cost };
+		}
+	}
+	return best;
+}
+
+static void buildNode(Builder *builder, uint32_t node, uint32_t first, uint32_t count, uint32_t depth, uint32_t threadCount);
+
+static void *buildTask(void *data) {
+	BuildTask *task = data;
+	buildNode(task->builder, task->node, task->first, task->count, task->depth, task->threadCount);
+	return NULL;
+}
+
+static void buildNode(Builder *builder, uint32_t node, uint32_t first, uint32_t count, uint32_t depth, uint32_t threadCount) {
+	DCmBvhNode *n = builder->nodes + node;
+	DCmVector3f centroidMin, centroidMax;
+	emptyBounds(n->min, n->max);
+	emptyBounds(centroidMin, centroidMax);
+	for(uint32_t i = first; i < first + count; ++i) {
+		uint32_t primitive = builder->indices[i];
+		growBounds(n->min, n->max, builder->boxes[primitive].min, builder->boxes[primitive].max);
+		growBounds(centroidMin, centroidMax, builder->centroids[primitive], builder->centroids[primitive]);
+	}
+
+	if(count <= DCM_BVH_MAX_LEAF_SIZE) {
+		n->first = first;
+		n->count = count;
+		return;
+	}
+
+	uint32_t leftCount = count / 2;
+	Split split = { -1, 0, INFINITY };
+	if(depth < MAX_SAH_DEPTH) split = findSplit(builder, first, count, centroidMin, centroidMax);
+	if(split.axis >= 0) {
+		// same binning as findSplit, so both sides get at least one primitive.
+		int axis = split.axis;
+		float scale = BIN_COUNT / (centroidMax[axis] - centroidMin[axis]);
+		uint32_t *indices = builder->indices + first;
+		uint32_t left = 0, right = count;
+		while(left < right) {
+			int bin = (int)((builder->centroids[indices[left]][axis] - centroidMin[axis]) * scale);
+			if((bin < BIN_COUNT ? bin : BIN_COUNT - 1) < split.bin) {
+				++left;
+			} else {
+				uint32_t swap = indices[left];
+				indices[left] = indices[--right];
+				indices[right] = swap;
+			}
+		}
+		leftCount = left;
+	}
+
+	uint32_t children = atomic_fetch_add_explicit(&builder->nodeCount, 2, memory_order_relaxed);
+	n->first = children;
+	n->count = 0;
+
+	uint32_t rightCount = count - leftCount;
+	if(threadCount > 1 && count >= PARALLEL_THRESHOLD) {
+		BuildTask task = { builder, children, first, leftCount, depth + 1, threadCount / 2 };
+		pthread_t thread;
+		if(pthread_create(&thread, NULL, buildTask, &task) == 0) {
+			buildNode(builder, children + 1, first + leftCount, rightCount, depth + 1, threadCount - threadCount / 2);
+			pthread_join(thread, NULL);
+			return;
+		}
+	}
+	buildNode(builder, children, first, leftCount, depth + 1, 1);
+	buildNode(builder, children + 1, first + leftCount, rightCount, depth + 1, 1);
+}
+
+void dcmBuildBvh(DCmBvh *bvh, const DCmAabb *boxes, uint32_t count, uint32_t threadCount) {
+	*bvh = (DCmBvh){ .primitiveCount = count };
+	if(count == 0) return;
+
+	// 2 * count - 1 nodes and nodes[1], which keeps the sibling pairs at even indices.
+	bvh->nodeAllocation = dcmemAllocate(sizeof(DCmBvhNode) * 2 * (size_t)count + DCMEM_CACHE_LINE_SIZE - 1);
+	bvh->indices = dcmemAllocate(sizeof(uint32_t) * count);
+	DCmVector3f *centroids = dcmemAllocate(sizeof(DCmVector3f) * count);
+	bool allocated = bvh->nodeAllocation != NULL && bvh->indices != NULL && centroids != NULL;
+	if(!allocated) {
+		if(centroids != NULL) dcmemDeallocate(centroids);
+		dcmFreeBvh(bvh);
+	}
+	DC_RASSERT(allocated, "Failed to allocate a bounding volume hierarchy.");
+	bvh->nodes = (DCmBvhNode *)(((uintptr_t)bvh->nodeAllocation + DCMEM_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(DCMEM_CACHE_LINE_SIZE - 1));
+	bvh->nodes[1] = (DCmBvhNode){ 0 };
+	for(uint32_t i = 0; i < count; ++i) {
+		bvh->indices[i] = i;
+		for(int a = 0; a < 3; ++a)
+			centroids[i][a] = (boxes[i].min[a] + boxes[i].max[a]) * 0.5f;
+	}
+
+	Builder builder = { .boxes = boxes, .centroids = centroids, .nodes = bvh->nodes, .indices = bvh->indices };
+	atomic_init(&builder.nodeCount, 2);
+	buildNode(&builder, 0, 0, count, 0, threadCount);
+	bvh->nodeCount = atomic_load(&builder.nodeCount);
+	dcmemDeallocate(centroids);
+}
+
+void dcmFreeBvh(DCmBvh *bvh) {
+	if(bvh->nodeAllocation != NULL) dcmemDeallocate(bvh->nodeAllocation);
+	if(bvh->indices != NULL) dcmemDeallocate(bvh->indices);
+	*bvh = (DCmBvh){ 0 };
+}
+
+static void refitNode(DCmBvh *bvh, const DCmAabb *boxes, uint32_t node) {
+	DCmBvhNode *n = bvh->nodes + node;
+	emptyBounds(n->min, n->max);
+	if(n->count != 0) {
+		for(uint32_t i = n->first; i < n->first + n->count; ++i)
+			growBounds(n->min, n->max, boxes[bvh->indices[i]].min, boxes[bvh->indices[i]].max);
+	} else {
+		growBounds(n->min, n->max, bvh->nodes[n->first].min, bvh->nodes[n->first].max);
+		growBounds(n->min, n->max, bvh->nodes[n->first + 1].min, bvh->nodes[n->first + 1].max);
+	}
+}
+
+void dcmBvhRefit(DCmBvh *bvh, const DCmAabb *boxes) {
+	if(bvh->nodeCount == 0) return;
+	// children come after their parent, so going backwards every child is done before its parent. nodes[1] is skipped.
+	for(uint32_t node = bvh->nodeCount; node-- > 2;)
+		refitNode(bvh, boxes, node);
+	refitNode(bvh, boxes, 0);
+}
+
+typedef struct StackEntry {
+	uint32_t node;
+	float distance; // where the ray enters the node.
+} StackEntry;
+
+typedef struct RayData {
+	float origin[4], inverse[4];
+} RayData;
+
+/** distance where the ray enters the box, INFINITY if it misses it or enters past far. */
+static inline float intersectBox(const float *min, const float *max, const RayData *ray, float far) {
+	float near = 0.0f;
+	for(int a = 0; a < 3; ++a) {
+		float t1 = (min[a] - ray->origin[a]) * ray->inverse[a], t2 = (max[a] - ray->origin[a]) * ray->inverse[a];
+		near = fmaxf(near, fminf(t1, t2));
+		far = fminf(far, fmaxf(t1, t2));
+	}
+	return near <= far ? near : INFINITY;
+}
+
+/** intersects the ray with both children of a node. */
+typedef void (*IntersectChildren)(const DCmBvhNode *children, const RayData *ray, float far, float distances[2]);
+
+static void intersectChildrenScalar(const DCmBvhNode *children, const RayData *ray, float far, float distances[2]) {
+	distances[0] = intersectBox(children[0].min, children[0].max, ray, far);
+	distances[1] = intersectBox(children[1].min, children[1].max, ray, far);
+}
+
+#if defined(DCM_X86)
+/** the fourth lane of min and max loads first and count, it is replaced by the ray interval. */
+DCM_TARGET("sse4.1") static inline float intersectBoxSse(const DCmBvhNode *node, __m128 origin, __m128 inverse, __m128 near, __m128 far) {
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->min), origin), inverse);
+	__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->max), origin), inverse);
+	__m128 entry = _mm_blend_ps(_mm_min_ps(t1, t2), near, 0x8), exit = _mm_blend_ps(_mm_max_ps(t1, t2), far, 0x8);
+	entry = _mm_max_ps(entry, _mm_shuffle_ps(entry, entry, _MM_SHUFFLE(2, 3, 0, 1)));
+	entry = _mm_max_ps(entry, _mm_shuffle_ps(entry, entry, _MM_SHUFFLE(1, 0, 3, 2)));
+	exit = _mm_min_ps(exit, _mm_shuffle_ps(exit, exit, _MM_SHUFFLE(2, 3, 0, 1)));
+	exit = _mm_min_ps(exit, _mm_shuffle_ps(exit, exit, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_comile_ss(entry, exit) ? _mm_cvtss_f32(entry) : INFINITY;
+}
+
+DCM_TARGET("sse4.1") static void intersectChildrenSse4(const DCmBvhNode *children, const RayData *ray, float far, float distances[2]) {
+	__m128 origin = _mm_loadu_ps(ray->origin), inverse = _mm_loadu_ps(ray->inverse);
+	__m128 nearLanes = _mm_setzero_ps(), farLanes = _mm_set1_ps(far);
+	distances[0] = intersectBoxSse(children, origin, inverse, nearLanes, farLanes);
+	distances[1] = intersectBoxSse(children + 1, origin, inverse, nearLanes, farLanes);
+}
+
+/** both children at once, one per 128 bit lane. */
+DCM_TARGET("avx2,fma") static void intersectChildrenAvx2(const DCmBvhNode *children, const RayData *ray, float far, float distances[2]) {
+	__m256 origin = _mm256_broadcast_ps((const __m128 *)ray->origin), inverse = _mm256_broadcast_ps((const __m128 *)ray->inverse);
+	__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu2_m128(children[1].min, children[0].min), origin), inverse);
+	__m256 t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu2_m128(children[1].max, children[0].max), origin), inverse);
+	__m256 entry = _mm256_blend_ps(_mm256_min_ps(t1, t2), _mm256_setzero_ps(), 0x88);
+	__m256 exit = _mm256_blend_ps(_mm256_max_ps(t1, t2), _mm256_set1_ps(far), 0x88);
+	entry = _mm256_max_ps(entry, _mm256_permute_ps(entry, _MM_SHUFFLE(2, 3, 0, 1)));
+	entry = _mm256_max_ps(entry, _mm256_permute_ps(entry, _MM_SHUFFLE(1, 0, 3, 2)));
+	exit = _mm256_min_ps(exit, _mm256_permute_ps(exit, _MM_SHUFFLE(2, 3, 0, 1)));
+	exit = _mm256_min_ps(exit, _mm256_permute_ps(exit, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m256 hit = _mm256_cmp_ps(entry, exit, _CMP_LE_OQ);
+	__m256 result = _mm256_blendv_ps(_mm256_set1_ps(INFINITY), entry, hit);
+	distances[0] = _mm256_cvtss_f32(result);
+	distances[1] = _mm_cvtss_f32(_mm256_extractf128_ps(result, 1));
+}
+#endif
+
+uint32_t dcmBvhRaycast(
+  const DCmBvh *bvh, const DCmAabb *boxes, const DCmRay *ray, float maxDistance, DCmBvhRayTest test, void *user, float *distance
+) {
+	RayData data = { 0 };
+	for(int a = 0; a < 3; ++a) {
+		data.origin[a] = ray->origin[a];
+		data.inverse[a] = 1.0f / ray->direction[a];
+	}
+	if(bvh->nodeCount == 0 || intersectBox(bvh->nodes[0].min, bvh->nodes[0].max, &data, maxDistance) == INFINITY) return DCM_BVH_NO_HIT;
+
+	IntersectChildren intersectChildren = intersectChildrenScalar;
+#if defined(DCM_X86)
+	DCmSimdLevel level = dcmGetSimdLevel();
+	if(level >= DCM_SIMD_LEVEL_AVX2) intersectChildren = intersectChildrenAvx2;
+	else if(level >= DCM_SIMD_LEVEL_SSE4) intersectChildren = intersectChildrenSse4;
+#endif
+
+	StackEntry stack[STACK_SIZE];
+	uint32_t stackSize = 0, node = 0, hit = DCM_BVH_NO_HIT;
+	float closest = maxDistance;
+	for(;;) {
+		const DCmBvhNode *n = bvh->nodes + node;
+		if(n->count != 0) {
+			for(uint32_t i = n->first; i < n->first + n->count; ++i) {
+				uint32_t primitive = bvh->indices[i];
+				float t = test != NULL ? test(user, primitive, ray) : intersectBox(boxes[primitive].min, boxes[primitive].max, &data, closest);
+				if(t >= 0.0f && t < closest) closest = t, hit = primitive;
+			}
+		} else {
+			float distances[2];
+			intersectChildren(bvh->nodes + n->first, &data, closest, distances);
+			// visit the nearer child first, the other one is skipped later if something closer was found.
+			int nearer = distances[1] < distances[0];
+			if(distances[nearer] != INFINITY) {
+				if(distances[!nearer] != INFINITY) stack[stackSize++] = (StackEntry){ n->first + !nearer, distances[!nearer] };
+				node = n->first + nearer;
+				continue;
+			}
+		}
+
+		while(stackSize > 0 && stack[stackSize - 1].distance > closest)
+			--stackSize;
+		if(stackSize == 0) break;
+		node = stack[--stackSize].node;
+	}
+
+	if(distance != NULL && hit != DCM_BVH_NO_HIT) *distance = closest;
+	return hit;
+}
+
+static inline bool overlaps(const float *minA, const float *maxA, const float *minB, const float *maxB) {
+	return minA[0] <= maxB[0] && minB[0] <= maxA[0] && minA[1] <= maxB[1] && minB[1] <= maxA[1] && minA[2] <= maxB[2] && minB[2] <= maxA[2];
+}
+
+size_t dcmBvhOverlap(const DCmBvh *bvh, const DCmAabb *boxes, const DCmAabb *box, uint32_t *results, size_t maxResults) {
+	if(bvh->nodeCount == 0 || !overlaps(bvh->nodes[0].min, bvh->nodes[0].max, box->min, box->max)) return 0;
+
+	uint32_t stack[STACK_SIZE], stackSize = 0, node = 0;
+	size_t resultCount = 0;
+	for(;;) {
+		const DCmBvhNode *n = bvh->nodes + node;
+		if(n->count != 0) {
+			for(uint32_t i = n->first; i < n->first + n->count; ++i) {
+				uint32_t primitive = bvh->indices[i];
+				if(!overlaps(boxes[primitive].min, boxes[primitive].max, box->min, box->max)) continue;
+				if(resultCount < maxResults) results[resultCount] = primitive;
+				++resultCount;
+			}
+		} else {
+			// children are checked before they are pushed, so only overlapping nodes are visited.
+			for(uint32_t child = n->first; child < n->first + 2; ++child)
+				if(overlaps(bvh->nodes[child].min, bvh->nodes[child].max, box->min, box->max)) stack[stackSize++] = child;
+		}
+
+		if(stackSize == 0) break;
+		node = stack[--stackSize];
+	}
+	return resultCount;
+}
+
+void dcmRayFromScreen(DCmRay *ray, DCmMatrix4x4f inverseViewProjection, float x, float y) {
+	DCmVector4f near, far;
+	DCmMatrix4x4fMulVector(near, inverseViewProjection, (DCmVector4f){ x, y, 0.0f, 1.0f });
+	DCmMatrix4x4fMulVector(far, inverseViewProjection, (DCmVector4f){ x, y, 1.0f, 1.0f });
+	for(int a = 0; a < 3; ++a) {
+		ray->origin[a] = near[a] / near[3];
+		ray->direction[a] = far[a] / far[3] - ray->origin[a];
+	}
+	float length = sqrtf(DCmVector3fDot(ray->direction, ray->direction));
+	for(int a = 0; a < 3; ++a)
+		ray->direction[a] /= length;
+}
@@ -0,0 +1,85 @@
+#ifndef DCORE_MATH_BVH_H
+#define DCORE_MATH_BVH_H
+#include <dcore/math/common.h>
+#include <dcore/math/vector.h>
+#include <dcore/math/matrix.h>
+
+#define DCM_BVH_NO_HIT UINT32_MAX
+/** leaves hold at most this many primitives. */
+#define DCM_BVH_MAX_LEAF_SIZE 4
+
+/** axis aligned bounding box. */
+typedef struct DCmAabb {
+	DCmVector3f min, max;
+} DCmAabb;
+
+typedef struct DCmRay {
+	DCmVector3f origin, direction;
+} DCmRay;
+
+/**
+ * a node is 32 bytes and siblings start at even indices of a cache line aligned array, so two siblings share a cache
+ * line. the children of an inner node are nodes first and first + 1, a leaf owns the primitives indices[first] to
+ * indices[first + count - 1].
+ **/
+typedef struct DCmBvhNode {
+	DCmVector3f min;
+	uint32_t first;
+	DCmVector3f max;
+	uint32_t count; // 0 for inner nodes.
+} DCmBvhNode;
+
+/**
+ * bounding volume hierarchy over an array of boxes, for ray queries (picking) and overlap queries (broad phase).
+ * the boxes are not copied, queries and refits take the same array the tree was built from.
+ **/
+typedef struct DCmBvh {
+	uint32_t nodeCount, primitiveCount;
+	DCmBvhNode *nodes; // nodes[0] is the root, nodes[1] is unused, children always come after their parent.
+	uint32_t *indices;
+	void *nodeAllocation; // nodes is aligned inside it.
+} DCmBvh;
+
+/**
+ * builds the tree with the surface area heuristic, binning the centroids of every node.
+ * @param threadCount number of threads building subtrees, 0 or 1 builds on the calling thread.
+ **/
+void dcmBuildBvh(DCmBvh *bvh, const DCmAabb *boxes, uint32_t count, uint32_t threadCount);
+void dcmFreeBvh(DCmBvh *bvh);
+
+/**
+ * recomputes the node bounds after boxes moved, keeping the topology. much cheaper than a build, but the tree gets
+ * worse the further boxes move from where they were, so rebuild from time to time.
+ **/
+void dcmBvhRefit(DCmBvh *bvh, const DCmAabb *boxes);
+
+/**
+ * exact intersection of a ray with a primitive whose box was hit.
+ * @return the distance along the ray, INFINITY if the primitive is missed.
+ **/
+typedef float (*DCmBvhRayTest)(void *user, uint32_t primitive, const DCmRay *ray);
+
+/**
+ * finds the closest primitive hit by the ray, the direction doesn't need to be normalized (distances are in its units).
+ * @param test NULL to use the boxes themselves as primitives.
+ * @param distance set to the distance of the hit if not NULL.
+ * @return the primitive or DCM_BVH_NO_HIT.
+ **/
+uint32_t dcmBvhRaycast(
+  const DCmBvh *bvh, const DCmAabb *boxes, const DCmRay *ray, float maxDistance, DCmBvhRayTest test, void *user, float *distance
+);
+
+/**
+ * finds the primitives whose boxes overlap box.
+ * @param results receives up to maxResults primitives.
+ * @return the number of overlapping primitives, can be more than maxResults.
+ **/
+size_t dcmBvhOverlap(const DCmBvh *bvh, const DCmAabb *boxes, const DCmAabb *box, uint32_t *results, size_t maxResults);
+
+/**
+ * the ray through a point of the screen, starting on the near plane.
+ * @param x,y normalized device coordinates, -1 to 1 from the top left to the bottom right corner.
+ **/
+void dcmRayFromScreen(DCmRay *ray, DCmMatrix4x4f inverseViewProjection, float x, float y);
+
+#endif
@@ -14,4 +14,27 @@
 	O(f, float, ##__VA_ARGS__) SEP \
 	O(d, double, ##__VA_ARGS__)
 
+/** like DCM__T_FOR, but only for the floating point types. */
+#define DCM__FP_FOR(O, SEP, ...) O(f, float, ##__VA_ARGS__) SEP O(d, double, ##__VA_ARGS__)
+
+/** instruction sets the math kernels can use, every level includes the ones before it. */
+typedef enum DCmSimdLevel {
+	DCM_SIMD_LEVEL_SCALAR,
+	DCM_SIMD_LEVEL_SSE4, // SSE4.1
+	DCM_SIMD_LEVEL_AVX2, // AVX2, FMA and F16C
+	DCM_SIMD_LEVEL_COUNT
+} DCmSimdLevel;
+
+/** returns the level the math kernels use, detected with cpuid on first use. */
+DCmSimdLevel dcmGetSimdLevel();
+
+/**
+ * forces the level the math kernels use, clamped to the levels the cpu supports.
+ * @return the level that is used now.
+ **/
+DCmSimdLevel dcmSetSimdLevel(DCmSimdLevel level);
+
+/** returns the highest level the cpu supports. */
+DCmSimdLevel dcmGetSupportedSimdLevel();
+
 #endif
@@ -0,0 +1,75 @@
+#include <dcore/math/common.h>
+#include <dcore/math/simd.h>
+#include <stdatomic.h>
+
+#if defined(DCM_X86)
+#	if defined(_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+static _Atomic int simdLevel = -1;
+
+#if defined(DCM_X86)
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4]) {
+#	if defined(_MSC_VER)
+	__cpuidex((int *)registers, (int)leaf, (int)subleaf);
+#	else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#	endif
+}
+
+/** returns the register state the os saves on context switches (XCR0). */
+static uint64_t getSavedState() {
+#	if defined(_MSC_VER)
+	return _xgetbv(0);
+#	else
+	unsigned int low, high;
+	__asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((uint64_t)high << 32) | low;
+#	endif
+}
+#endif
+
+DCmSimdLevel dcmGetSupportedSimdLevel() {
+#if defined(DCM_X86)
+	unsigned int registers[4];
+	cpuid(0, 0, registers);
+	unsigned int maxLeaf = registers[0];
+	if(maxLeaf < 1) return DCM_SIMD_LEVEL_SCALAR;
+
+	cpuid(1, 0, registers);
+	bool sse41 = registers[2] & (1u << 19);
+	bool fma = registers[2] & (1u << 12);
+	bool f16c = registers[2] & (1u << 29);
+	bool osxsave = registers[2] & (1u << 27);
+	bool avx = registers[2] & (1u << 28);
+	if(!sse41) return DCM_SIMD_LEVEL_SCALAR;
+
+	// AVX registers are only usable if the os saves them (XMM and YMM state).
+	if(!fma || !f16c || !osxsave || !avx || (getSavedState() & 0x6) != 0x6 || maxLeaf < 7) return DCM_SIMD_LEVEL_SSE4;
+	cpuid(7, 0, registers);
+	return (registers[1] & (1u << 5)) ? DCM_SIMD_LEVEL_AVX2 : DCM_SIMD_LEVEL_SSE4;
+#else
+	return DCM_SIMD_LEVEL_SCALAR;
+#endif
+}
+
+DCmSimdLevel dcmGetSimdLevel() {
+	int level = atomic_load_explicit(&simdLevel, memory_order_relaxed);
+	if(level >= 0) return (DCmSimdLevel)level;
+
+	// detecting twice on a race is harmless, both threads store the same level.
+	level = dcmGetSupportedSimdLevel();
+	atomic_store_explicit(&simdLevel, level, memory_order_relaxed);
+	return (DCmSimdLevel)level;
+}
+
+DCmSimdLevel dcmSetSimdLevel(DCmSimdLevel level) {
+	DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+	if(level > supported) level = supported;
+	atomic_store_explicit(&simdLevel, (int)level, memory_order_relaxed);
+	return level;
+}
@@ -0,0 +1,156 @@
+#include <dcore/math/frustum.h>
+#include <dcore/math/simd.h>
+#include <math.h>
+#include <pthread.h>
+
+void dcmFrustumFromMatrix(DCmFrustum *frustum, DCmMatrix4x4f viewProjection) {
+	// clip space is -w <= x, y <= w and 0 <= z <= w, every inequality is a combination of rows of the matrix.
+	float rows[4][4];
+	for(int r = 0; r < 4; ++r)
+		for(int c = 0; c < 4; ++c)
+			rows[r][c] = viewProjection[c][r];
+
+	for(int i = 0; i < 4; ++i) {
+		frustum->planes[DCM_FRUSTUM_PLANE_LEFT][i] = rows[3][i] + rows[0][i];
+		frustum->planes[DCM_FRUSTUM_PLANE_RIGHT][i] = rows[3][i] - rows[0][i];
+		frustum->planes[DCM_FRUSTUM_PLANE_BOTTOM][i] = rows[3][i] + rows[1][i];
+		frustum->planes[DCM_FRUSTUM_PLANE_TOP][i] = rows[3][i] - rows[1][i];
+		frustum->planes[DCM_FRUSTUM_PLANE_NEAR][i] = rows[2][i];
+		frustum->planes[DCM_FRUSTUM_PLANE_FAR][i] = rows[3][i] - rows[2][i];
+	}
+
+	for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+		float length = sqrtf(DCmVector3fDot(frustum->planes[p], frustum->planes[p]));
+		if(length > 0.0f)
+			for(int i = 0; i < 4; ++i)
+				frustum->planes[p][i] /= length;
+	}
+}
+
+static inline float planeDistance(const DCmVector4f plane, float x, float y, float z) {
+	return plane[0] * x + plane[1] * y + plane[2] * z + plane[3];
+}
+
+static size_t cullSpheresScalar(const DCmFrustum *frustum, DCmStream3f centers, const float *radii, size_t begin, size_t count, uint32_t *visible) {
+	size_t visibleCount = 0;
+	for(size_t i = begin; i < count; ++i) {
+		bool inside = true;
+		for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p)
+			inside &= planeDistance(frustum->planes[p], centers.x[i], centers.y[i], centers.z[i]) >= -radii[i];
+		visible[visibleCount] = (uint32_t)i;
+		visibleCount += inside;
+	}
+	return visibleCount;
+}
+
+static size_t cullBoxesScalar(const DCmFrustum *frustum, DCmStream3f centers, DCmStream3f extents, size_t begin, size_t count, uint32_t *visible) {
+	size_t visibleCount = 0;
+	for(size_t i = begin; i < count; ++i) {
+		bool inside = true;
+		for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+			// the box reaches furthest towards the plane along |normal|.
+			const float *plane = frustum->planes[p];
+			float radius = fabsf(plane[0]) * extents.x[i] + fabsf(plane[1]) * extents.y[i] + fabsf(plane[2]) * extents.z[i];
+			inside &= planeDistance(plane, centers.x[i], centers.y[i], centers.z[i]) >= -radius;
+		}
+		visible[visibleCount] = (uint32_t)i;
+		visibleCount += inside;
+	}
+	return visibleCount;
+}
+
+#if defined(DCM_X86)
+/** lanes of every 8 bit visibility mask, packed to the front. */
+static uint8_t compactTable[256][8];
+static pthread_once_t compactTableOnce = PTHREAD_ONCE_INIT;
+
+static void initCompactTable() {
+	for(int mask = 0; mask < 256; ++mask) {
+		int n = 0;
+		for(int lane = 0; lane < 8; ++lane)
+			if(mask & (1 << lane)) compactTable[mask][n++] = (uint8_t)lane;
+	}
+}
+
+typedef struct Planes8 {
+	__m256 a[DCM_FRUSTUM_PLANE_COUNT], b[DCM_FRUSTUM_PLANE_COUNT], c[DCM_FRUSTUM_PLANE_COUNT], d[DCM_FRUSTUM_PLANE_COUNT];
+} Planes8;
+
+DCM_TARGET("avx2,fma") static inline Planes8 broadcastPlanes(const DCmFrustum *frustum) {
+	Planes8 planes;
+	for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+		planes.a[p] = _mm256_set1_ps(frustum->planes[p][0]);
+		planes.b[p] = _mm256_set1_ps(frustum->planes[p][1]);
+		planes.c[p] = _mm256_set1_ps(frustum->planes[p][2]);
+		planes.d[p] = _mm256_set1_ps(frustum->planes[p][3]);
+	}
+	return planes;
+}
+
+/** appends the indices of the lanes set in mask, writes eight indices, so there must be space for them. */
+DCM_TARGET("avx2,fma") static inline size_t compact(uint32_t *visible, size_t visibleCount, size_t base, int mask) {
+	__m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)compactTable[mask]));
+	__m256i indices = _mm256_add_epi32(_mm256_set1_epi32((int)base), lanes);
+	_mm256_storeu_si256((__m256i *)(visible + visibleCount), indices);
+	return visibleCount + (size_t)__builtin_popcount((unsigned int)mask);
+}
+
+DCM_TARGET("avx2,fma")
+static size_t cullSpheresAvx2(const DCmFrustum *frustum, DCmStream3f centers, const float *radii, size_t count, uint32_t *visible) {
+	pthread_once(&compactTableOnce, initCompactTable);
+	Planes8 planes = broadcastPlanes(frustum);
+	size_t i = 0, visibleCount = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(centers.x + i), y = _mm256_loadu_ps(centers.y + i), z = _mm256_loadu_ps(centers.z + i);
+		__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radii + i));
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+			__m256 distance = _mm256_fmadd_ps(planes.a[p], x, _mm256_fmadd_ps(planes.b[p], y, _mm256_fmadd_ps(planes.c[p], z, planes.d[p])));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+		// visibleCount <= i, so the eight indices written fit.
+		visibleCount = compact(visible, visibleCount, i, _mm256_movemask_ps(inside));
+	}
+	return visibleCount + cullSpheresScalar(frustum, centers, radii, i, count, visible + visibleCount);
+}
+
+DCM_TARGET("avx2,fma")
+static size_t cullBoxesAvx2(const DCmFrustum *frustum, DCmStream3f centers, DCmStream3f extents, size_t count, uint32_t *visible) {
+	pthread_once(&compactTableOnce, initCompactTable);
+	Planes8 planes = broadcastPlanes(frustum), absolute;
+	__m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+		absolute.a[p] = _mm256_and_ps(planes.a[p], signMask);
+		absolute.b[p] = _mm256_and_ps(planes.b[p], signMask);
+		absolute.c[p] = _mm256_and_ps(planes.c[p], signMask);
+	}
+
+	size_t i = 0, visibleCount = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(centers.x + i), y = _mm256_loadu_ps(centers.y + i), z = _mm256_loadu_ps(centers.z + i);
+		__m256 ex = _mm256_loadu_ps(extents.x + i), ey = _mm256_loadu_ps(extents.y + i), ez = _mm256_loadu_ps(extents.z + i);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+			__m256 distance = _mm256_fmadd_ps(planes.a[p], x, _mm256_fmadd_ps(planes.b[p], y, _mm256_fmadd_ps(planes.c[p], z, planes.d[p])));
+			__m256 radius = _mm256_fmadd_ps(absolute.a[p], ex, _mm256_fmadd_ps(absolute.b[p], ey, _mm256_mul_ps(absolute.c[p], ez)));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+		}
+		visibleCount = compact(visible, visibleCount, i, _mm256_movemask_ps(inside));
+	}
+	return visibleCount + cullBoxesScalar(frustum, centers, extents, i, count, visible + visibleCount);
+}
+#endif
+
+size_t dcmFrustumCullSpheres(const DCmFrustum *frustum, DCmStream3f centers, const float *radii, size_t count, uint32_t *visible) {
+#if defined(DCM_X86)
+	if(dcmGetSimdLevel() >= DCM_SIMD_LEVEL_AVX2) return cullSpheresAvx2(frustum, centers, radii, count, visible);
+#endif
+	return cullSpheresScalar(frustum, centers, radii, 0, count, visible);
+}
+
+size_t dcmFrustumCullBoxes(const DCmFrustum *frustum, DCmStream3f centers, DCmStream3f extents, size_t count, uint32_t *visible) {
+#if defined(DCM_X86)
+	if(dcmGetSimdLevel() >= DCM_SIMD_LEVEL_AVX2) return cullBoxesAvx2(frustum, centers, extents, count, visible);
+#endif
+	return cullBoxesScalar(frustum, centers, extents, 0, count, visible);
+}
@@ -0,0 +1,35 @@
+#ifndef DCORE_MATH_FRUSTUM_H
+#define DCORE_MATH_FRUSTUM_H
+#include <dcore/math/common.h>
+#include <dcore/math/matrix.h>
+#include <dcore/math/batch.h>
+
+typedef enum DCmFrustumPlane {
+	DCM_FRUSTUM_PLANE_LEFT,
+	DCM_FRUSTUM_PLANE_RIGHT,
+	DCM_FRUSTUM_PLANE_BOTTOM,
+	DCM_FRUSTUM_PLANE_TOP,
+	DCM_FRUSTUM_PLANE_NEAR,
+	DCM_FRUSTUM_PLANE_FAR,
+	DCM_FRUSTUM_PLANE_COUNT
+} DCmFrustumPlane;
+
+/** planes (a, b, c, d) with normalized normals pointing inside, a point p is inside if a p.x + b p.y + c p.z + d >= 0. */
+typedef struct DCmFrustum {
+	DCmVector4f planes[DCM_FRUSTUM_PLANE_COUNT];
+} DCmFrustum;
+
+/** extracts the planes of a view projection matrix with vulkan clip space (depth 0..1). */
+void dcmFrustumFromMatrix(DCmFrustum *frustum, DCmMatrix4x4f viewProjection);
+
+/**
+ * the cull functions write the indices of objects that intersect the frustum to visible, in ascending order, and
+ * return how many there are. visible needs space for count indices. the AVX2 kernels test eight objects at once.
+ * objects are only culled when they are completely outside one plane, objects near corners may be kept.
+ **/
+size_t dcmFrustumCullSpheres(const DCmFrustum *frustum, DCmStream3f centers, const float *radii, size_t count, uint32_t *visible);
+
+/** boxes are given by their center and half size (extent) on every axis. */
+size_t dcmFrustumCullBoxes(const DCmFrustum *frustum, DCmStream3f centers, DCmStream3f extents, size_t count, uint32_t *visible);
+
+#endif
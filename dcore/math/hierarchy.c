@@ -0,0 +1,199 @@
+#include <dcore/math/hierarchy.h>
+#include <dcore/math/simd.h>
+#include <string.h>
+
+#define BLOCK 8
+
+/** grows an array, the array stays as it was when the allocation fails. */
+static bool resize(void **array, size_t size) {
+	void *resized = *array == NULL ? dcmemAllocate(size) : dcmemReallocate(*array, size);
+	DC_RVASSERT(resized != NULL, "Failed to grow a transform hierarchy.", false);
+	*array = resized;
+	return true;
+}
+
+/** the capacity is only raised once every array has grown, the arrays that did grow keep their extra space. */
+static bool setCapacity(DCmHierarchy *hierarchy, uint32_t capacity) {
+	void **arrays[] = {
+		(void **)&hierarchy->translations.x, (void **)&hierarchy->translations.y, (void **)&hierarchy->translations.z,
+		(void **)&hierarchy->rotations.x,    (void **)&hierarchy->rotations.y,    (void **)&hierarchy->rotations.z,
+		(void **)&hierarchy->rotations.w,    (void **)&hierarchy->scales.x,       (void **)&hierarchy->scales.y,
+		(void **)&hierarchy->scales.z,
+	};
+	for(size_t i = 0; i < ARRAYSIZE(arrays); ++i)
+		if(!resize(arrays[i], capacity * sizeof(float))) return false;
+	if(!resize((void **)&hierarchy->parents, capacity * sizeof(uint32_t)) || !resize((void **)&hierarchy->dirty, capacity)) return false;
+	if(!resize((void **)&hierarchy->worlds, capacity * sizeof(DCmMatrix4x4f))) return false;
+	hierarchy->capacity = capacity;
+	return true;
+}
+
+void dcmInitHierarchy(DCmHierarchy *hierarchy, uint32_t capacity) {
+	*hierarchy = (DCmHierarchy){ 0 };
+	setCapacity(hierarchy, capacity != 0 ? capacity : 64);
+}
+
+void dcmFreeHierarchy(DCmHierarchy *hierarchy) {
+	// arrays are NULL if the hierarchy couldn't grow in dcmInitHierarchy.
+	void *arrays[] = {
+		hierarchy->translations.x, hierarchy->translations.y, hierarchy->translations.z, hierarchy->rotations.x, hierarchy->rotations.y,
+		hierarchy->rotations.z,    hierarchy->rotations.w,    hierarchy->scales.x,       hierarchy->scales.y,    hierarchy->scales.z,
+		hierarchy->parents,        hierarchy->dirty,          hierarchy->worlds,
+	};
+	for(size_t i = 0; i < ARRAYSIZE(arrays); ++i)
+		if(arrays[i] != NULL) dcmemDeallocate(arrays[i]);
+	*hierarchy = (DCmHierarchy){ 0 };
+}
+
+uint32_t dcmHierarchyAdd(DCmHierarchy *hierarchy, uint32_t parent, const DCmTransformf *local) {
+	DC_RVASSERT(
+	  parent == DCM_HIERARCHY_NO_PARENT || parent < hierarchy->count, "Parents have to be added before their children.", DCM_HIERARCHY_NO_PARENT
+	);
+	if(hierarchy->count == hierarchy->capacity && !setCapacity(hierarchy, hierarchy->capacity != 0 ? hierarchy->capacity * 2 : 64))
+		return DCM_HIERARCHY_NO_PARENT;
+
+	uint32_t node = hierarchy->count++;
+	hierarchy->parents[node] = parent;
+	dcmHierarchySetLocal(hierarchy, node, local);
+	return node;
+}
+
+void dcmHierarchySetLocal(DCmHierarchy *hierarchy, uint32_t node, const DCmTransformf *local) {
+	hierarchy->translations.x[node] = local->translation[0];
+	hierarchy->translations.y[node] = local->translation[1];
+	hierarchy->translations.z[node] = local->translation[2];
+	hierarchy->rotations.x[node] = local->rotation[0];
+	hierarchy->rotations.y[node] = local->rotation[1];
+	hierarchy->rotations.z[node] = local->rotation[2];
+	hierarchy->rotations.w[node] = local->rotation[3];
+	hierarchy->scales.x[node] = local->scale[0];
+	hierarchy->scales.y[node] = local->scale[1];
+	hierarchy->scales.z[node] = local->scale[2];
+	hierarchy->dirty[node] = 1;
+}
+
+void dcmHierarchyGetLocal(DCmHierarchy *hierarchy, uint32_t node, DCmTransformf *local) {
+	local->translation[0] = hierarchy->translations.x[node];
+	local->translation[1] = hierarchy->translations.y[node];
+	local->translation[2] = hierarchy->translations.z[node];
+	local->rotation[0] = hierarchy->rotations.x[node];
+	local->rotation[1] = hierarchy->rotations.y[node];
+	local->rotation[2] = hierarchy->rotations.z[node];
+	local->rotation[3] = hierarchy->rotations.w[node];
+	local->scale[0] = hierarchy->scales.x[node];
+	local->scale[1] = hierarchy->scales.y[node];
+	local->scale[2] = hierarchy->scales.z[node];
+}
+
+static void localMatricesScalar(DCmHierarchy *hierarchy, uint32_t begin, uint32_t count, DCmMatrix4x4f *locals) {
+	for(uint32_t i = 0; i < count; ++i) {
+		DCmTransformf local;
+		dcmHierarchyGetLocal(hierarchy, begin + i, &local);
+		DCmTransformfToMatrix(locals[i], &local);
+	}
+}
+
+#if defined(DCM_X86)
+/** computes the local matrices of up to eight nodes at once, one node per lane. */
+DCM_TARGET("avx2,fma") static void localMatricesAvx2(DCmHierarchy *hierarchy, uint32_t begin, uint32_t count, DCmMatrix4x4f *locals) {
+	__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32((int)count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+#	define LOAD(STREAM) _mm256_maskload_ps(hierarchy->STREAM + begin, mask)
+	__m256 x = LOAD(rotations.x), y = LOAD(rotations.y), z = LOAD(rotations.z), w = LOAD(rotations.w);
+	__m256 sx = LOAD(scales.x), sy = LOAD(scales.y), sz = LOAD(scales.z);
+	__m256 columns[4][3] = {
+		[3] = { LOAD(translations.x), LOAD(translations.y), LOAD(translations.z) }
+	};
+#	undef LOAD
+
+	__m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+	__m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+	__m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+	__m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+	columns[0][0] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx);
+	columns[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+	columns[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+	columns[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+	columns[1][1] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy);
+	columns[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+	columns[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+	columns[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+	columns[2][2] = _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz);
+
+	float lanes[4][3][BLOCK];
+	for(int c = 0; c < 4; ++c)
+		for(int r = 0; r < 3; ++r)
+			_mm256_storeu_ps(lanes[c][r], columns[c][r]);
+	for(uint32_t i = 0; i < count; ++i) {
+		for(int c = 0; c < 4; ++c) {
+			for(int r = 0; r < 3; ++r)
+				locals[i][c][r] = lanes[c][r][i];
+			locals[i][c][3] = c == 3 ? 1.0f : 0.0f;
+		}
+	}
+}
+#endif
+
+void dcmHierarchyUpdateRange(DCmHierarchy *hierarchy, uint32_t begin, uint32_t end) {
+	uint32_t *parents = hierarchy->parents;
+	uint8_t *dirty = hierarchy->dirty;
+
+	// parents come first, so one pass marks all descendants of dirty nodes.
+	for(uint32_t i = begin; i < end; ++i)
+		if(parents[i] != DCM_HIERARCHY_NO_PARENT) dirty[i] |= dirty[parents[i]];
+
+	void (*localMatrices)(DCmHierarchy *, uint32_t, uint32_t, DCmMatrix4x4f *) = localMatricesScalar;
+#if defined(DCM_X86)
+	if(dcmGetSimdLevel() >= DCM_SIMD_LEVEL_AVX2) localMatrices = localMatricesAvx2;
+#endif
+
+	for(uint32_t block = begin; block < end; block += BLOCK) {
+		uint32_t count = end - block < BLOCK ? end - block : BLOCK;
+		bool anyDirty = false;
+		for(uint32_t i = 0; i < count; ++i)
+			anyDirty |= dirty[block + i];
+		if(!anyDirty) continue;
+
+		DCmMatrix4x4f locals[BLOCK];
+		localMatrices(hierarchy, block, count, locals);
+		for(uint32_t i = 0; i < count; ++i) {
+			uint32_t node = block + i;
+			if(!dirty[node]) continue;
+			if(parents[node] == DCM_HIERARCHY_NO_PARENT) memcpy(hierarchy->worlds[node], locals[i], sizeof(DCmMatrix4x4f));
+			else dcmMatrix4x4fMul(hierarchy->worlds[node], hierarchy->worlds[parents[node]], locals[i]);
+		}
+	}
+
+	memset(dirty + begin, 0, end - begin);
+}
+
+void dcmHierarchyUpdate(DCmHierarchy *hierarchy) { dcmHierarchyUpdateRange(hierarchy, 0, hierarchy->count); }
+
+uint32_t dcmHierarchySplit(DCmHierarchy *hierarchy, uint32_t maxRanges, uint32_t *ends) {
+	uint32_t count = hierarchy->count;
+	if(count == 0 || maxRanges == 0) return 0;
+
+	// a range can start at node b if no node from b on has its parent before b, so keep the smallest parent index
+	// of every suffix (roots don't count).
+	uint32_t *minParents = dcmemAllocate(count * sizeof(uint32_t));
+	// the whole hierarchy is always a valid range.
+	bool allocated = minParents != NULL;
+	if(!allocated) ends[0] = count;
+	DC_RVASSERT(allocated, "Failed to split a transform hierarchy, it's updated as one range.", 1);
+	uint32_t minParent = UINT32_MAX;
+	for(uint32_t i = count; i-- > 0;) {
+		if(hierarchy->parents[i] < minParent) minParent = hierarchy->parents[i];
+		minParents[i] = minParent;
+	}
+
+	uint32_t rangeCount = 0, step = (count + maxRanges - 1) / maxRanges, next = step;
+	for(uint32_t b = 1; b < count && rangeCount + 1 < maxRanges; ++b) {
+		if(b >= next && minParents[b] >= b) {
+			ends[rangeCount++] = b;
+			next = b + step;
+		}
+	}
+	ends[rangeCount++] = count;
+
+	dcmemDeallocate(minParents);
+	return rangeCount;
+}
@@ -0,0 +1,53 @@
+#ifndef DCORE_MATH_HIERARCHY_H
+#define DCORE_MATH_HIERARCHY_H
+#include <dcore/math/common.h>
+#include <dcore/math/transform.h>
+#include <dcore/math/batch.h>
+
+#define DCM_HIERARCHY_NO_PARENT UINT32_MAX
+
+/**
+ * a transform hierarchy stored in flat arrays. nodes are always after their parent, so world matrices are computed
+ * in one linear pass without walking a tree. local transforms are stored as streams (SoA) so eight of them are
+ * turned into matrices at once. the world matrices are column major and can be copied into
+ * DCgBasicRendererTransformUniformBuffer::world as they are.
+ **/
+typedef struct DCmHierarchy {
+	uint32_t count, capacity;
+	uint32_t *parents; // DCM_HIERARCHY_NO_PARENT for roots.
+	DCmStream3f translations;
+	DCmStream4f rotations;
+	DCmStream3f scales;
+	uint8_t *dirty; // the local transform changed, world matrices of the node and its descendants are outdated.
+	DCmMatrix4x4f *worlds;
+} DCmHierarchy;
+
+void dcmInitHierarchy(DCmHierarchy *hierarchy, uint32_t capacity);
+void dcmFreeHierarchy(DCmHierarchy *hierarchy);
+
+/**
+ * adds a node, its world matrix is computed in the next update.
+ * @param parent a node that was already added or DCM_HIERARCHY_NO_PARENT.
+ * @return the index of the node or DCM_HIERARCHY_NO_PARENT if the hierarchy couldn't grow.
+ **/
+uint32_t dcmHierarchyAdd(DCmHierarchy *hierarchy, uint32_t parent, const DCmTransformf *local);
+
+void dcmHierarchySetLocal(DCmHierarchy *hierarchy, uint32_t node, const DCmTransformf *local);
+void dcmHierarchyGetLocal(DCmHierarchy *hierarchy, uint32_t node, DCmTransformf *local);
+
+/** recomputes the world matrices of dirty nodes and their descendants. */
+void dcmHierarchyUpdate(DCmHierarchy *hierarchy);
+
+/**
+ * splits the nodes into at most maxRanges ranges of about the same size, where no node has its parent in another
+ * range. the ranges can then be updated in parallel with dcmHierarchyUpdateRange.
+ * @param ends set to the end of every range, the first one starts at 0 and the others at the end of the previous one.
+ * @return the number of ranges, less than maxRanges if the hierarchy can't be split that often (1 if the scratch
+ *         array can't be allocated).
+ **/
+uint32_t dcmHierarchySplit(DCmHierarchy *hierarchy, uint32_t maxRanges, uint32_t *ends);
+
+/** updates the nodes [begin, end), the range must come from dcmHierarchySplit or be the whole hierarchy. */
+void dcmHierarchyUpdateRange(DCmHierarchy *hierarchy, uint32_t begin, uint32_t end);
+
+#endif
@@ -0,0 +1,195 @@
+#include <dcore/math/matrix.h>
+#include <dcore/math/simd.h>
+#include <string.h>
+
+typedef struct Kernels {
+	void (*mul)(DCmMatrix4x4f dst, DCmMatrix4x4f a, DCmMatrix4x4f b);
+	bool (*inverse)(DCmMatrix4x4f dst, DCmMatrix4x4f src);
+	void (*transpose)(DCmMatrix4x4f dst, DCmMatrix4x4f src);
+	void (*mulArray)(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count);
+	void (*mulVectors)(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count);
+} Kernels;
+
+static void mulArrayScalar(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count) {
+	DCmMatrix4x4f copy; // a may be one of the destinations.
+	memcpy(copy, a, sizeof(copy));
+	for(size_t i = 0; i < count; ++i)
+		DCmMatrix4x4fMul(dst[i], copy, b[i]);
+}
+
+static void mulVectorsScalar(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count) {
+	for(size_t i = 0; i < count; ++i)
+		DCmMatrix4x4fMulVector(dst[i], m, vectors[i]);
+}
+
+#if defined(DCM_X86)
+/** result column c = sum over k of a column k * b[c][k]. */
+DCM_TARGET("sse4.1") static inline void mulSse4(float *dst, const float *a, const float *b) {
+	__m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+	__m128 columns[4];
+	for(int c = 0; c < 4; ++c) {
+		__m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[c * 4 + 0]));
+		column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[c * 4 + 1])));
+		column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[c * 4 + 2])));
+		columns[c] = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[c * 4 + 3])));
+	}
+	for(int c = 0; c < 4; ++c)
+		_mm_storeu_ps(dst + c * 4, columns[c]);
+}
+
+DCM_TARGET("sse4.1") static void mulMatrixSse4(DCmMatrix4x4f dst, DCmMatrix4x4f a, DCmMatrix4x4f b) { mulSse4(&dst[0][0], &a[0][0], &b[0][0]); }
+
+DCM_TARGET("sse4.1") static void mulArraySse4(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count) {
+	DCmMatrix4x4f copy;
+	memcpy(copy, a, sizeof(copy));
+	for(size_t i = 0; i < count; ++i)
+		mulSse4(&dst[i][0][0], &copy[0][0], &b[i][0][0]);
+}
+
+DCM_TARGET("sse4.1") static void transposeSse4(DCmMatrix4x4f dst, DCmMatrix4x4f src) {
+	__m128 c0 = _mm_loadu_ps(src[0]), c1 = _mm_loadu_ps(src[1]), c2 = _mm_loadu_ps(src[2]), c3 = _mm_loadu_ps(src[3]);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	_mm_storeu_ps(dst[0], c0);
+	_mm_storeu_ps(dst[1], c1);
+	_mm_storeu_ps(dst[2], c2);
+	_mm_storeu_ps(dst[3], c3);
+}
+
+DCM_TARGET("sse4.1") static void mulVectorsSse4(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count) {
+	__m128 m0 = _mm_loadu_ps(m[0]), m1 = _mm_loadu_ps(m[1]), m2 = _mm_loadu_ps(m[2]), m3 = _mm_loadu_ps(m[3]);
+	for(size_t i = 0; i < count; ++i) {
+		__m128 v = _mm_loadu_ps(vectors[i]);
+		__m128 result = _mm_mul_ps(m0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		result = _mm_add_ps(result, _mm_mul_ps(m1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+		result = _mm_add_ps(result, _mm_mul_ps(m2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+		result = _mm_add_ps(result, _mm_mul_ps(m3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+		_mm_storeu_ps(dst[i], result);
+	}
+}
+
+// 2x2 matrices are stored in one register as (m00, m01, m10, m11).
+#	define SWIZZLE(V, X, Y, Z, W) _mm_shuffle_ps((V), (V), _MM_SHUFFLE((W), (Z), (Y), (X)))
+#	define SHUFFLE(A, B, X, Y, Z, W) _mm_shuffle_ps((A), (B), _MM_SHUFFLE((W), (Z), (Y), (X)))
+
+/** a * b */
+DCM_TARGET("sse4.1") static inline __m128 mul2x2(__m128 a, __m128 b) {
+	return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/** adjugate(a) * b */
+DCM_TARGET("sse4.1") static inline __m128 adjMul2x2(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+/** a * adjugate(b) */
+DCM_TARGET("sse4.1") static inline __m128 mulAdj2x2(__m128 a, __m128 b) {
+	return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/**
+ * blockwise inverse: the matrix is split into the 2x2 blocks A B / C D and the blocks of the inverse are built from
+ * their adjugates and determinants. transposing doesn't change the algebra, so it works on the columns as they are.
+ **/
+DCM_TARGET("sse4.1") static bool inverseSse4(DCmMatrix4x4f dst, DCmMatrix4x4f src) {
+	__m128 c0 = _mm_loadu_ps(src[0]), c1 = _mm_loadu_ps(src[1]), c2 = _mm_loadu_ps(src[2]), c3 = _mm_loadu_ps(src[3]);
+	__m128 a = _mm_movelh_ps(c0, c1), b = _mm_movehl_ps(c1, c0);
+	__m128 c = _mm_movelh_ps(c2, c3), d = _mm_movehl_ps(c3, c2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128 determinants = _mm_sub_ps(
+	  _mm_mul_ps(SHUFFLE(c0, c2, 0, 2, 0, 2), SHUFFLE(c1, c3, 1, 3, 1, 3)), _mm_mul_ps(SHUFFLE(c0, c2, 1, 3, 1, 3), SHUFFLE(c1, c3, 0, 2, 0, 2))
+	);
+	__m128 detA = SWIZZLE(determinants, 0, 0, 0, 0), detB = SWIZZLE(determinants, 1, 1, 1, 1);
+	__m128 detC = SWIZZLE(determinants, 2, 2, 2, 2), detD = SWIZZLE(determinants, 3, 3, 3, 3);
+
+	__m128 adjDC = adjMul2x2(d, c), adjAB = adjMul2x2(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mul2x2(b, adjDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mul2x2(c, adjAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mulAdj2x2(d, adjAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mulAdj2x2(a, adjDC));
+
+	// |M| = |A| |D| + |B| |C| - tr(adj(A) B adj(D) C)
+	__m128 trace = _mm_mul_ps(adjAB, SWIZZLE(adjDC, 0, 2, 1, 3));
+	trace = _mm_hadd_ps(trace, trace);
+	trace = _mm_hadd_ps(trace, trace);
+	__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+	if(_mm_cvtss_f32(det) == 0.0f) return false;
+
+	__m128 inverseDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, inverseDet);
+	y = _mm_mul_ps(y, inverseDet);
+	z = _mm_mul_ps(z, inverseDet);
+	w = _mm_mul_ps(w, inverseDet);
+
+	// the adjugate of every block is applied while storing.
+	_mm_storeu_ps(dst[0], SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(dst[1], SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(dst[2], SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(dst[3], SHUFFLE(z, w, 2, 0, 2, 0));
+	return true;
+}
+
+/** two result columns per register, each 128 bit lane broadcasts its own column of b. */
+DCM_TARGET("avx2,fma") static inline void mulAvx2(float *dst, const float *a, const float *b) {
+	__m256 a0 = _mm256_broadcast_ps((const __m128 *)a), a1 = _mm256_broadcast_ps((const __m128 *)(a + 4));
+	__m256 a2 = _mm256_broadcast_ps((const __m128 *)(a + 8)), a3 = _mm256_broadcast_ps((const __m128 *)(a + 12));
+	__m256 b01 = _mm256_loadu_ps(b), b23 = _mm256_loadu_ps(b + 8);
+
+	__m256 c01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0)));
+	__m256 c23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0)));
+	c01 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1)), c01);
+	c23 = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1)), c23);
+	c01 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2)), c01);
+	c23 = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2)), c23);
+	c01 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3)), c01);
+	c23 = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3)), c23);
+	_mm256_storeu_ps(dst, c01);
+	_mm256_storeu_ps(dst + 8, c23);
+}
+
+DCM_TARGET("avx2,fma") static void mulMatrixAvx2(DCmMatrix4x4f dst, DCmMatrix4x4f a, DCmMatrix4x4f b) { mulAvx2(&dst[0][0], &a[0][0], &b[0][0]); }
+
+DCM_TARGET("avx2,fma") static void mulArrayAvx2(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count) {
+	DCmMatrix4x4f copy;
+	memcpy(copy, a, sizeof(copy));
+	for(size_t i = 0; i < count; ++i)
+		mulAvx2(&dst[i][0][0], &copy[0][0], &b[i][0][0]);
+}
+
+/** two vectors per iteration, one per 128 bit lane. */
+DCM_TARGET("avx2,fma") static void mulVectorsAvx2(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count) {
+	__m256 m0 = _mm256_broadcast_ps((const __m128 *)m[0]), m1 = _mm256_broadcast_ps((const __m128 *)m[1]);
+	__m256 m2 = _mm256_broadcast_ps((const __m128 *)m[2]), m3 = _mm256_broadcast_ps((const __m128 *)m[3]);
+	size_t i = 0;
+	for(; i + 2 <= count; i += 2) {
+		__m256 v = _mm256_loadu_ps(vectors[i]);
+		__m256 result = _mm256_mul_ps(m0, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+		result = _mm256_fmadd_ps(m1, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), result);
+		result = _mm256_fmadd_ps(m2, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), result);
+		result = _mm256_fmadd_ps(m3, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), result);
+		_mm256_storeu_ps(dst[i], result);
+	}
+	if(i < count) mulVectorsSse4(dst + i, m, vectors + i, count - i);
+}
+#endif
+
+// inverse and transpose are shuffle bound, AVX2 doesn't help them.
+static const Kernels kernels[DCM_SIMD_LEVEL_COUNT] = {
+	[DCM_SIMD_LEVEL_SCALAR] = { DCmMatrix4x4fMul, DCmMatrix4x4fInverse, DCmMatrix4x4fTranspose, mulArrayScalar, mulVectorsScalar },
+#if defined(DCM_X86)
+	[DCM_SIMD_LEVEL_SSE4] = { mulMatrixSse4, inverseSse4, transposeSse4, mulArraySse4, mulVectorsSse4 },
+	[DCM_SIMD_LEVEL_AVX2] = { mulMatrixAvx2, inverseSse4, transposeSse4, mulArrayAvx2, mulVectorsAvx2 },
+#endif
+};
+
+void dcmMatrix4x4fMul(DCmMatrix4x4f dst, DCmMatrix4x4f a, DCmMatrix4x4f b) { kernels[dcmGetSimdLevel()].mul(dst, a, b); }
+bool dcmMatrix4x4fInverse(DCmMatrix4x4f dst, DCmMatrix4x4f src) { return kernels[dcmGetSimdLevel()].inverse(dst, src); }
+void dcmMatrix4x4fTranspose(DCmMatrix4x4f dst, DCmMatrix4x4f src) { kernels[dcmGetSimdLevel()].transpose(dst, src); }
+
+void dcmMatrix4x4fMulArray(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count) {
+	kernels[dcmGetSimdLevel()].mulArray(dst, a, b, count);
+}
+
+void dcmMatrix4x4fMulVectors(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count) {
+	kernels[dcmGetSimdLevel()].mulVectors(dst, m, vectors, count);
+}
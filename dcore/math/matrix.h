@@ -1,7 +1,13 @@
 #ifndef DCORE_MATH_MATRIX_H
 #define DCORE_MATH_MATRIX_H
 #include <dcore/math/common.h>
+#include <dcore/math/vector.h>
+#include <math.h>
 
+/**
+ * matrices are column major like in glsl, `matrix[column][row]`, and vectors are multiplied from the right.
+ * parameters aren't const, as C doesn't convert `T (*)[K]` to `const T (*)[K]` implicitly.
+ **/
 #define DCM__M22_DEF(N, T) typedef T DCmMatrix2x2##N[2][2]
 #define DCM__M33_DEF(N, T) typedef T DCmMatrix3x3##N[3][3]
 #define DCM__M44_DEF(N, T) typedef T DCmMatrix4x4##N[4][4]
@@ -14,4 +20,196 @@ typedef DCmMatrix2x2f DCmMatrix2x2;
 typedef DCmMatrix3x3f DCmMatrix3x3;
 typedef DCmMatrix4x4f DCmMatrix4x4;
 
+/**
+ * scalar functions, for every type and size. dst may be one of the sources.
+ * DCmMatrixKxK<type>Identity(dst), Mul(dst, a, b) (dst = a * b), MulVector(dst, m, v) (dst = m * v), Transpose(dst, src).
+ **/
+#define DCM__M_IDENTITY_F(S, T, K) \
+	static inline void DCmMatrix##K##x##K##S##Identity(DCmMatrix##K##x##K##S dst) { \
+		for(int c = 0; c < K; ++c) \
+			for(int r = 0; r < K; ++r) \
+				dst[c][r] = (T)(c == r); \
+	}
+#define DCM__M_MUL_F(S, T, K) \
+	static inline void DCmMatrix##K##x##K##S##Mul(DCmMatrix##K##x##K##S dst, DCmMatrix##K##x##K##S a, DCmMatrix##K##x##K##S b) { \
+		T result[K][K]; \
+		for(int c = 0; c < K; ++c) \
+			for(int r = 0; r < K; ++r) { \
+				T sum = 0; \
+				for(int k = 0; k < K; ++k) \
+					sum += a[k][r] * b[c][k]; \
+				result[c][r] = sum; \
+			} \
+		for(int c = 0; c < K; ++c) \
+			for(int r = 0; r < K; ++r) \
+				dst[c][r] = result[c][r]; \
+	}
+#define DCM__M_MUL_VECTOR_F(S, T, K) \
+	static inline void DCmMatrix##K##x##K##S##MulVector(DCmVector##K##S dst, DCmMatrix##K##x##K##S m, const DCmVector##K##S v) { \
+		T result[K]; \
+		for(int r = 0; r < K; ++r) { \
+			T sum = 0; \
+			for(int c = 0; c < K; ++c) \
+				sum += m[c][r] * v[c]; \
+			result[r] = sum; \
+		} \
+		for(int r = 0; r < K; ++r) \
+			dst[r] = result[r]; \
+	}
+#define DCM__M_TRANSPOSE_F(S, T, K) \
+	static inline void DCmMatrix##K##x##K##S##Transpose(DCmMatrix##K##x##K##S dst, DCmMatrix##K##x##K##S src) { \
+		T result[K][K]; \
+		for(int c = 0; c < K; ++c) \
+			for(int r = 0; r < K; ++r) \
+				result[r][c] = src[c][r]; \
+		for(int c = 0; c < K; ++c) \
+			for(int r = 0; r < K; ++r) \
+				dst[c][r] = result[c][r]; \
+	}
+
+DCM__T_FOR(DCM__M_IDENTITY_F, , 2)
+DCM__T_FOR(DCM__M_IDENTITY_F, , 3)
+DCM__T_FOR(DCM__M_IDENTITY_F, , 4)
+DCM__T_FOR(DCM__M_MUL_F, , 2)
+DCM__T_FOR(DCM__M_MUL_F, , 3)
+DCM__T_FOR(DCM__M_MUL_F, , 4)
+DCM__T_FOR(DCM__M_MUL_VECTOR_F, , 2)
+DCM__T_FOR(DCM__M_MUL_VECTOR_F, , 3)
+DCM__T_FOR(DCM__M_MUL_VECTOR_F, , 4)
+DCM__T_FOR(DCM__M_TRANSPOSE_F, , 2)
+DCM__T_FOR(DCM__M_TRANSPOSE_F, , 3)
+DCM__T_FOR(DCM__M_TRANSPOSE_F, , 4)
+
+/**
+ * floating point only: Inverse(dst, src) returns false and leaves dst untouched if src is singular.
+ * the 4x4 version works on the 2x2 sub-determinants, in the same way as the SIMD kernels.
+ **/
+#define DCM__M33_INVERSE_F(S, T) \
+	static inline bool DCmMatrix3x3##S##Inverse(DCmMatrix3x3##S dst, DCmMatrix3x3##S m) { \
+		T c0 = m[1][1] * m[2][2] - m[2][1] * m[1][2], c1 = m[2][1] * m[0][2] - m[0][1] * m[2][2]; \
+		T c2 = m[0][1] * m[1][2] - m[1][1] * m[0][2]; \
+		T det = m[0][0] * c0 + m[1][0] * c1 + m[2][0] * c2; \
+		if(det == 0) return false; \
+		T inv = 1 / det, result[3][3] = { \
+			{ c0 * inv, c1 * inv, c2 * inv }, \
+			{ (m[2][0] * m[1][2] - m[1][0] * m[2][2]) * inv, (m[0][0] * m[2][2] - m[2][0] * m[0][2]) * inv, \
+			  (m[1][0] * m[0][2] - m[0][0] * m[1][2]) * inv }, \
+			{ (m[1][0] * m[2][1] - m[2][0] * m[1][1]) * inv, (m[2][0] * m[0][1] - m[0][0] * m[2][1]) * inv, \
+			  (m[0][0] * m[1][1] - m[1][0] * m[0][1]) * inv }, \
+		}; \
+		for(int c = 0; c < 3; ++c) \
+			for(int r = 0; r < 3; ++r) \
+				dst[c][r] = result[c][r]; \
+		return true; \
+	}
+#define DCM__M44_INVERSE_F(S, T) \
+	static inline bool DCmMatrix4x4##S##Inverse(DCmMatrix4x4##S dst, DCmMatrix4x4##S m) { \
+		T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1], s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2]; \
+		T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3], s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2]; \
+		T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3], s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3]; \
+		T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3], c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3]; \
+		T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2], c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3]; \
+		T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2], c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1]; \
+		T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0; \
+		if(det == 0) return false; \
+		T inv = 1 / det, result[4][4] = { \
+			{ (m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * inv, (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * inv, \
+			  (m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * inv, (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * inv }, \
+			{ (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * inv, (m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * inv, \
+			  (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * inv, (m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * inv }, \
+			{ (m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * inv, (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * inv, \
+			  (m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * inv, (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * inv }, \
+			{ (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * inv, (m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * inv, \
+			  (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * inv, (m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * inv }, \
+		}; \
+		for(int c = 0; c < 4; ++c) \
+			for(int r = 0; r < 4; ++r) \
+				dst[c][r] = result[c][r]; \
+		return true; \
+	}
+
+DCM__FP_FOR(DCM__M33_INVERSE_F, )
+DCM__FP_FOR(DCM__M44_INVERSE_F, )
+
+/**
+ * floating point only, transforms for vulkan clip space (y down, depth 0..1, right handed view space looking down -z).
+ * Translation(dst, v), Scale(dst, v), Perspective(dst, fovY (radians), aspect, zNear, zFar),
+ * Orthographic(dst, left, right, bottom, top, zNear, zFar), LookAt(dst, eye, center, up).
+ **/
+#define DCM__M44_TRANSFORM_F(S, T) \
+	static inline void DCmMatrix4x4##S##Translation(DCmMatrix4x4##S dst, const DCmVector3##S v) { \
+		DCmMatrix4x4##S##Identity(dst); \
+		dst[3][0] = v[0]; \
+		dst[3][1] = v[1]; \
+		dst[3][2] = v[2]; \
+	} \
+	static inline void DCmMatrix4x4##S##Scale(DCmMatrix4x4##S dst, const DCmVector3##S v) { \
+		DCmMatrix4x4##S##Identity(dst); \
+		dst[0][0] = v[0]; \
+		dst[1][1] = v[1]; \
+		dst[2][2] = v[2]; \
+	} \
+	static inline void DCmMatrix4x4##S##Perspective(DCmMatrix4x4##S dst, T fovY, T aspect, T zNear, T zFar) { \
+		T f = (T)(1 / tan((double)fovY / 2)); \
+		for(int c = 0; c < 4; ++c) \
+			for(int r = 0; r < 4; ++r) \
+				dst[c][r] = 0; \
+		dst[0][0] = f / aspect; \
+		dst[1][1] = -f; \
+		dst[2][2] = zFar / (zNear - zFar); \
+		dst[2][3] = -1; \
+		dst[3][2] = zNear * zFar / (zNear - zFar); \
+	} \
+	static inline void DCmMatrix4x4##S##Orthographic(DCmMatrix4x4##S dst, T left, T right, T bottom, T top, T zNear, T zFar) { \
+		DCmMatrix4x4##S##Identity(dst); \
+		dst[0][0] = 2 / (right - left); \
+		dst[1][1] = -2 / (top - bottom); \
+		dst[2][2] = 1 / (zNear - zFar); \
+		dst[3][0] = -(right + left) / (right - left); \
+		dst[3][1] = (top + bottom) / (top - bottom); \
+		dst[3][2] = zNear / (zNear - zFar); \
+	} \
+	static inline void DCmMatrix4x4##S##LookAt(DCmMatrix4x4##S dst, const DCmVector3##S eye, const DCmVector3##S center, const DCmVector3##S up) { \
+		T forward[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] }; \
+		T length = (T)sqrt((double)DCmVector3##S##Dot(forward, forward)); \
+		forward[0] /= length, forward[1] /= length, forward[2] /= length; \
+		T side[3] = { forward[1] * up[2] - forward[2] * up[1], forward[2] * up[0] - forward[0] * up[2], forward[0] * up[1] - forward[1] * up[0] }; \
+		length = (T)sqrt((double)DCmVector3##S##Dot(side, side)); \
+		side[0] /= length, side[1] /= length, side[2] /= length; \
+		T realUp[3] = { side[1] * forward[2] - side[2] * forward[1], side[2] * forward[0] - side[0] * forward[2], \
+			            side[0] * forward[1] - side[1] * forward[0] }; \
+		for(int c = 0; c < 3; ++c) { \
+			dst[c][0] = side[c]; \
+			dst[c][1] = realUp[c]; \
+			dst[c][2] = -forward[c]; \
+			dst[c][3] = 0; \
+		} \
+		dst[3][0] = -DCmVector3##S##Dot(side, eye); \
+		dst[3][1] = -DCmVector3##S##Dot(realUp, eye); \
+		dst[3][2] = DCmVector3##S##Dot(forward, eye); \
+		dst[3][3] = 1; \
+	}
+
+DCM__FP_FOR(DCM__M44_TRANSFORM_F, )
+
+/**
+ * results of the SIMD kernels differ from the scalar functions by at most this much relative to the largest
+ * magnitude involved, as FMA and the order of the inverse's operations round differently.
+ **/
+#define DCM_MATRIX_TOLERANCE 1e-5f
+
+/**
+ * DCmMatrix4x4f functions that use the kernel of the level returned by dcmGetSimdLevel.
+ * they give the same results as the scalar functions within DCM_MATRIX_TOLERANCE, dst may be one of the sources.
+ **/
+void dcmMatrix4x4fMul(DCmMatrix4x4f dst, DCmMatrix4x4f a, DCmMatrix4x4f b);
+bool dcmMatrix4x4fInverse(DCmMatrix4x4f dst, DCmMatrix4x4f src);
+void dcmMatrix4x4fTranspose(DCmMatrix4x4f dst, DCmMatrix4x4f src);
+
+/** dst[i] = a * b[i], for transforming many objects by the same view projection matrix. dst may be b. */
+void dcmMatrix4x4fMulArray(DCmMatrix4x4f *dst, DCmMatrix4x4f a, DCmMatrix4x4f *b, size_t count);
+
+/** dst[i] = m * vectors[i]. dst may be vectors. */
+void dcmMatrix4x4fMulVectors(DCmVector4f *dst, DCmMatrix4x4f m, const DCmVector4f *vectors, size_t count);
+
 #endif
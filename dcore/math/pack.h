@@ -0,0 +1,73 @@
+#ifndef DCORE_MATH_PACK_H
+#define DCORE_MATH_PACK_H
+#include <dcore/math/common.h>
+#include <dcore/math/vector.h>
+#include <math.h>
+#include <string.h>
+
+/**
+ * compact encodings for vertex data. halfs round to nearest even like F16C, so the scalar and SIMD encoders of
+ * a mesh give identical bytes.
+ **/
+
+/** IEEE 754 half precision, values too large become infinity. */
+static inline uint16_t DCmFloatToHalf(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000, exponent = (bits >> 23) & 0xff, mantissa = bits & 0x7fffff;
+	if(exponent == 0xff) return (uint16_t)(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+
+	int halfExponent = (int)exponent - 127 + 15;
+	if(halfExponent >= 31) return (uint16_t)(sign | 0x7c00);
+	if(halfExponent <= 0) {
+		// subnormal, the implicit bit becomes explicit.
+		if(halfExponent < -10) return (uint16_t)sign;
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - halfExponent), half = mantissa >> shift, rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+		if(rest > halfway || (rest == halfway && (half & 1))) ++half;
+		return (uint16_t)(sign | half);
+	}
+
+	// rounding up can carry into the exponent, which is still correct (up to infinity).
+	uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13), rest = mantissa & 0x1fff;
+	if(rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+	return (uint16_t)(sign | half);
+}
+
+static inline float DCmHalfToFloat(uint16_t half) {
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16, exponent = (half >> 10) & 0x1f, mantissa = half & 0x3ff, bits;
+	if(exponent == 0x1f) bits = sign | 0x7f800000 | (mantissa << 13);
+	else if(exponent != 0) bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else return (sign ? -1.0f : 1.0f) * (float)mantissa * (1.0f / 16777216.0f);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+/**
+ * octahedral encoding of a normalized vector as two snorm16 values, the decoded vector is within 0.0001 radians.
+ * zero vectors become (0, 0, 1).
+ **/
+static inline void DCmVector3fToOctahedral(int16_t dst[2], const DCmVector3f v) {
+	float length = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+	float inverse = length > 0.0f ? 1.0f / length : 0.0f, x = v[0] * inverse, y = v[1] * inverse;
+	if(v[2] < 0.0f) {
+		// fold the lower half over the diagonals.
+		float foldedX = (1.0f - fabsf(y)) * copysignf(1.0f, x);
+		y = (1.0f - fabsf(x)) * copysignf(1.0f, y);
+		x = foldedX;
+	}
+	dst[0] = (int16_t)lrintf(x * 32767.0f);
+	dst[1] = (int16_t)lrintf(y * 32767.0f);
+}
+
+static inline void DCmVector3fFromOctahedral(DCmVector3f dst, const int16_t src[2]) {
+	float x = fmaxf(src[0] / 32767.0f, -1.0f), y = fmaxf(src[1] / 32767.0f, -1.0f), z = 1.0f - fabsf(x) - fabsf(y);
+	float unfold = fmaxf(-z, 0.0f);
+	x -= copysignf(unfold, x);
+	y -= copysignf(unfold, y);
+	float inverse = 1.0f / sqrtf(x * x + y * y + z * z);
+	dst[0] = x * inverse, dst[1] = y * inverse, dst[2] = z * inverse;
+}
+
+#endif
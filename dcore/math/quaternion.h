@@ -0,0 +1,85 @@
+#ifndef DCORE_MATH_QUATERNION_H
+#define DCORE_MATH_QUATERNION_H
+#include <dcore/math/common.h>
+#include <dcore/math/vector.h>
+#include <dcore/math/matrix.h>
+#include <math.h>
+
+/** rotation quaternions (x, y, z, w), only for floating point types. */
+#define DCM__Q_DEF(N, T) typedef T DCmQuaternion##N[4]
+
+DCM__FP_FOR(DCM__Q_DEF, ;);
+
+typedef DCmQuaternionf DCmQuaternion;
+
+/**
+ * DCmQuaternion<type>Identity(q), FromAxisAngle(q, axis (normalized), angle (radians)), Mul(dst, a, b) (rotates by b,
+ * then by a), Conjugate(q), Normalize(q), Rotate(dst, q, v), Slerp(dst, a, b, t), ToMatrix(dst, q).
+ * dst may be one of the sources.
+ **/
+#define DCM__Q_F(S, T) \
+	static inline void DCmQuaternion##S##Identity(DCmQuaternion##S q) { \
+		q[0] = q[1] = q[2] = 0; \
+		q[3] = 1; \
+	} \
+	static inline void DCmQuaternion##S##FromAxisAngle(DCmQuaternion##S q, const DCmVector3##S axis, T angle) { \
+		T s = (T)sin((double)angle / 2); \
+		q[0] = axis[0] * s; \
+		q[1] = axis[1] * s; \
+		q[2] = axis[2] * s; \
+		q[3] = (T)cos((double)angle / 2); \
+	} \
+	static inline void DCmQuaternion##S##Mul(DCmQuaternion##S dst, const DCmQuaternion##S a, const DCmQuaternion##S b) { \
+		T x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1]; \
+		T y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0]; \
+		T z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3]; \
+		T w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2]; \
+		dst[0] = x, dst[1] = y, dst[2] = z, dst[3] = w; \
+	} \
+	static inline void DCmQuaternion##S##Conjugate(DCmQuaternion##S q) { \
+		q[0] = -q[0]; \
+		q[1] = -q[1]; \
+		q[2] = -q[2]; \
+	} \
+	static inline void DCmQuaternion##S##Normalize(DCmQuaternion##S q) { \
+		T length = (T)sqrt((double)(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3])); \
+		if(length == 0) { \
+			DCmQuaternion##S##Identity(q); \
+			return; \
+		} \
+		for(int i = 0; i < 4; ++i) \
+			q[i] /= length; \
+	} \
+	static inline void DCmQuaternion##S##Rotate(DCmVector3##S dst, const DCmQuaternion##S q, const DCmVector3##S v) { \
+		/* v + 2w (q x v) + 2 q x (q x v) */ \
+		T tx = 2 * (q[1] * v[2] - q[2] * v[1]), ty = 2 * (q[2] * v[0] - q[0] * v[2]), tz = 2 * (q[0] * v[1] - q[1] * v[0]); \
+		T x = v[0] + q[3] * tx + q[1] * tz - q[2] * ty; \
+		T y = v[1] + q[3] * ty + q[2] * tx - q[0] * tz; \
+		T z = v[2] + q[3] * tz + q[0] * ty - q[1] * tx; \
+		dst[0] = x, dst[1] = y, dst[2] = z; \
+	} \
+	static inline void DCmQuaternion##S##Slerp(DCmQuaternion##S dst, const DCmQuaternion##S a, const DCmQuaternion##S b, T t) { \
+		T cosine = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3], sign = 1; \
+		if(cosine < 0) cosine = -cosine, sign = -1; /* take the shorter way */ \
+		T wa = 1 - t, wb = t; \
+		if(cosine < (T)0.9995) { \
+			T angle = (T)acos((double)cosine), s = (T)sin((double)angle); \
+			wa = (T)sin((double)(wa * angle)) / s; \
+			wb = (T)sin((double)(wb * angle)) / s; \
+		} \
+		for(int i = 0; i < 4; ++i) \
+			dst[i] = wa * a[i] + sign * wb * b[i]; \
+		DCmQuaternion##S##Normalize(dst); \
+	} \
+	static inline void DCmQuaternion##S##ToMatrix(DCmMatrix4x4##S dst, const DCmQuaternion##S q) { \
+		T xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2], xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2]; \
+		T wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2]; \
+		DCmMatrix4x4##S##Identity(dst); \
+		dst[0][0] = 1 - 2 * (yy + zz), dst[0][1] = 2 * (xy + wz), dst[0][2] = 2 * (xz - wy); \
+		dst[1][0] = 2 * (xy - wz), dst[1][1] = 1 - 2 * (xx + zz), dst[1][2] = 2 * (yz + wx); \
+		dst[2][0] = 2 * (xz + wy), dst[2][1] = 2 * (yz - wx), dst[2][2] = 1 - 2 * (xx + yy); \
+	}
+
+DCM__FP_FOR(DCM__Q_F, )
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef DCORE_MATH_SIMD_H
+#define DCORE_MATH_SIMD_H
+#include <dcore/math/common.h>
+
+/* platform macros of the SIMD kernels, for DCm and for kernels of other modules that dispatch on dcmGetSimdLevel.
+   DCM_X86 is defined where the x86 intrinsics are available. */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#	define DCM_X86
+#	include <immintrin.h>
+/** compiles a function for an instruction set that isn't enabled for the whole file. */
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		define DCM_TARGET(ISA)
+#	else
+#		define DCM_TARGET(ISA) __attribute__((target(ISA)))
+#	endif
+#endif
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef DCORE_MATH_TRANSFORM_H
+#define DCORE_MATH_TRANSFORM_H
+#include <dcore/math/common.h>
+#include <dcore/math/quaternion.h>
+
+/** translation, rotation and scale, applied as scale first and translation last. */
+#define DCM__TRS_DEF(N, T) \
+	typedef struct DCmTransform##N { \
+		DCmVector3##N translation; \
+		DCmQuaternion##N rotation; \
+		DCmVector3##N scale; \
+	} DCmTransform##N
+
+DCM__FP_FOR(DCM__TRS_DEF, ;);
+
+typedef DCmTransformf DCmTransform;
+
+/** DCmTransform<type>Identity(transform), ToMatrix(dst, transform) (dst = T * R * S). */
+#define DCM__TRS_F(S, T) \
+	static inline void DCmTransform##S##Identity(DCmTransform##S *transform) { \
+		transform->translation[0] = transform->translation[1] = transform->translation[2] = 0; \
+		DCmQuaternion##S##Identity(transform->rotation); \
+		transform->scale[0] = transform->scale[1] = transform->scale[2] = 1; \
+	} \
+	static inline void DCmTransform##S##ToMatrix(DCmMatrix4x4##S dst, const DCmTransform##S *transform) { \
+		DCmQuaternion##S##ToMatrix(dst, transform->rotation); \
+		for(int c = 0; c < 3; ++c) \
+			for(int r = 0; r < 3; ++r) \
+				dst[c][r] *= transform->scale[c]; \
+		dst[3][0] = transform->translation[0]; \
+		dst[3][1] = transform->translation[1]; \
+		dst[3][2] = transform->translation[2]; \
+	}
+
+DCM__FP_FOR(DCM__TRS_F, )
+
+#endif
@@ -58,8 +58,17 @@ DCM__T_FOR(DCM__VS_F, , Subs, 3, DCM__V3_OP_FOR(DCM__VS_OP, ;, -=);)
 DCM__T_FOR(DCM__VS_F, , Muls, 3, DCM__V3_OP_FOR(DCM__VS_OP, ;, *=);)
 DCM__T_FOR(DCM__VS_F, , Divs, 3, DCM__V3_OP_FOR(DCM__VS_OP, ;, /=);)
 DCM__T_FOR(DCM__SVV_F, , Dot, 3, return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];)
-DCM__T_FOR(DCM__VV_F, , Cross, 3, dst[0] = dst[1] * src[2] - dst[2] * src[1]; dst[1] = dst[2] * src[0] - dst[0] * src[2];
-           dst[2] = dst[0] * src[1] - dst[1] * src[0];)
+
+/** dst = dst x src */
+#define DCM__V3_CROSS_F(S, T) \
+	static inline void DCmVector3##S##Cross(DCmVector3##S dst, const DCmVector3##S src) { \
+		T x = dst[1] * src[2] - dst[2] * src[1], y = dst[2] * src[0] - dst[0] * src[2]; \
+		dst[2] = dst[0] * src[1] - dst[1] * src[0]; \
+		dst[0] = x; \
+		dst[1] = y; \
+	}
+
+DCM__T_FOR(DCM__V3_CROSS_F, )
 
 /* void test() {
     DCmVector2i16 a = { 12, -48 };
@@ -1,23 +1,306 @@
 #ifndef DCORE_MEMORY_H
 #define DCORE_MEMORY_H
 #include <stddef.h>
+#include <stdint.h>
+#include <stdalign.h>
+#include <stdbool.h>
 
+/** default alignment of arena pushes, enough for any scalar type. */
+#define DCMEM_DEFAULT_ALIGNMENT alignof(max_align_t)
+/** size of the first arena block if `step` is zero. */
+#define DCMEM_ARENA_DEFAULT_STEP 4096
+
+/** default size of the virtual arena commit steps. */
+#define DCMEM_VIRTUAL_ARENA_DEFAULT_STEP (64 * 1024)
+/** size of a huge page, virtual arenas using huge pages are aligned to it. */
+#define DCMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef struct DCmemArenaBlock DCmemArenaBlock;
+
+typedef enum DCmemArenaType {
+	/** linked list of blocks, the default for zero-initialized arenas. */
+	DCMEM_ARENA_TYPE_CHUNKED,
+	/** one reserved address range, pages are committed as the arena grows. @see dcmemInitVirtualArena */
+	DCMEM_ARENA_TYPE_VIRTUAL,
+} DCmemArenaType;
+
+typedef enum DCmemArenaFlags {
+	/** asks the OS to back the virtual arena with huge pages (MADV_HUGEPAGE). */
+	DCMEM_ARENA_FLAG_HUGE_PAGES = 0x01,
+} DCmemArenaFlags;
+
+/**
+ * An arena, pushes are bump allocations.
+ * Pointers returned by pushes stay valid until the memory is popped or the arena is reset.
+ *
+ * Chunked arenas are a linked list of memory blocks. Zero-initialize and optionally set
+ * `step` (size of the first block) before use, each new block is twice as big as the last one.
+ *
+ * Virtual arenas are one contiguous range of reserved address space. @see dcmemInitVirtualArena
+ **/
 typedef struct DCmemArena {
-	size_t size;
-	size_t top;
-	size_t step;
-	void *memory;
+	size_t size; // total size of all blocks, or committed bytes for virtual arenas.
+	size_t top;  // total number of pushed bytes (including alignment padding).
+	size_t step; // first block size, or commit granularity for virtual arenas.
+	DCmemArenaType type;
+	DCmemArenaBlock *first, *current;
+
+	// virtual arenas only
+	unsigned int flags;
+	size_t reserved, highWaterMark;
+	uint8_t *base;
 } DCmemArena;
 
+/** a saved arena position. @see dcmemGetArenaMarker */
+typedef struct DCmemArenaMarker {
+	DCmemArenaBlock *block;
+	size_t blockTop, top;
+} DCmemArenaMarker;
+
+#define DCMEM__ALLOC_STATS_FOR(O) \
+	O(allocCount) O(deallocCount) O(reallocCount) O(allocatedBytes) O(deallocatedBytes) O(arenaPushCount) O(arenaPopCount) O(arenaBlockCount) \
+	O(poolAllocCount) O(poolDeallocCount) O(poolSlabCount) O(poolCapacity)
+
+#define DCMEM__ALLOC_STATS_FIELD(NAME) size_t NAME;
+
+/**
+ * Allocation statistics, counted per thread and summed up by dcmemGetAllocStats.
+ * @note byte counts are only known when allocations are tracked (DC_DEBUG or DCMEM_PROFILE).
+ **/
 typedef struct DCmemAllocStats {
-	size_t allocCount, deallocCount, reallocCount;
-	size_t arenaPushCount, arenaPopCount;
+	DCMEM__ALLOC_STATS_FOR(DCMEM__ALLOC_STATS_FIELD)
+	size_t residentBytes;
+	/**
+	 * sum of the per-thread peaks, threads that exited count as one. exact for a single thread, an upper bound of the
+	 * process peak otherwise, as threads can peak at different times.
+	 **/
+	size_t peakResidentBytes;
 } DCmemAllocStats;
 
+/** returns a snapshot of the allocation statistics of all threads. */
+DCmemAllocStats dcmemGetAllocStats();
+
+/** returns `after - before`, the resident and peak bytes are the ones of `after`. */
+DCmemAllocStats dcmemDiffAllocStats(const DCmemAllocStats *before, const DCmemAllocStats *after);
+
+/**
+ * sets the peak resident bytes of every thread to its current resident bytes (for example at the start of a frame),
+ * the peak of the threads that exited too.
+ **/
+void dcmemResetPeakResidentBytes();
+
+/** pushes `size` bytes aligned to DCMEM_DEFAULT_ALIGNMENT. */
 void *dcmemPush(DCmemArena *arena, size_t size);
+/** pushes `size` bytes aligned to `alignment` (must be a power of two). */
+void *dcmemPushAligned(DCmemArena *arena, size_t size, size_t alignment);
+/** pops `size` bytes. @note alignment padding isn't popped, use markers to restore exact positions. */
 void dcmemPop(DCmemArena *arena, size_t size);
 
-#if defined(DC_DEBUG)
+/** returns the current position of the arena. */
+DCmemArenaMarker dcmemGetArenaMarker(DCmemArena *arena);
+/** pops everything pushed after the marker was taken. */
+void dcmemRestoreArenaMarker(DCmemArena *arena, DCmemArenaMarker marker);
+/** pops everything, the blocks are kept for reuse. */
+void dcmemResetArena(DCmemArena *arena);
+/** frees all blocks of the arena. */
+void dcmemFreeArena(DCmemArena *arena);
+
+/**
+ * Initializes a virtual arena.
+ * @param reserve number of bytes of address space to reserve, the arena can't grow past it.
+ * @param highWaterMark committed bytes past this are decommitted when the arena is reset.
+ * @param flags DCmemArenaFlags.
+ **/
+void dcmemInitVirtualArena(DCmemArena *arena, size_t reserve, size_t highWaterMark, unsigned int flags);
+
+/** maximum number of frames in flight a frame allocator can handle. */
+#define DCMEM_MAX_FRAMES_IN_FLIGHT 4
+
+/**
+ * Per-frame scratch memory, one arena per frame in flight.
+ * Memory pushed during a frame is valid until the same frame slot is started again
+ * (after its fence has signaled), so it can be used for data the GPU reads as well.
+ **/
+typedef struct DCmemFrameAllocator {
+	size_t frameCount, frame;
+	DCmemArena arenas[DCMEM_MAX_FRAMES_IN_FLIGHT];
+} DCmemFrameAllocator;
+
+/**
+ * Initializes a frame allocator.
+ * @param frameCount number of frames in flight (at most DCMEM_MAX_FRAMES_IN_FLIGHT).
+ * @param step size of the first block of each frame arena.
+ **/
+void dcmemInitFrameAllocator(DCmemFrameAllocator *allocator, size_t frameCount, size_t step);
+
+/** makes `frame` the current frame and resets its arena. @warning only call once the frame isn't in flight anymore. */
+void dcmemBeginFrame(DCmemFrameAllocator *allocator, size_t frame);
+
+/** returns the arena of the current frame. */
+DCmemArena *dcmemGetFrameArena(DCmemFrameAllocator *allocator);
+
+/** pushes into the arena of the current frame. */
+void *dcmemFramePush(DCmemFrameAllocator *allocator, size_t size, size_t alignment);
+
+/** frees the arenas of all frames. */
+void dcmemFreeFrameAllocator(DCmemFrameAllocator *allocator);
+
+#define DCMEM_FRAME_PUSH(ALLOCATOR, TYPE, COUNT) ((TYPE *)dcmemFramePush((ALLOCATOR), sizeof(TYPE) * (COUNT), alignof(TYPE)))
+
+/** pool slabs are aligned to this. */
+#define DCMEM_CACHE_LINE_SIZE 64
+
+typedef struct DCmemPoolSlab DCmemPoolSlab;
+
+/**
+ * Allocator for objects of one size. Objects live in cache line aligned slabs,
+ * free objects are linked together in an intrusive free list.
+ **/
+typedef struct DCmemPool {
+	size_t objectSize, objectsPerSlab;
+	size_t slabCount, liveCount;
+	void *freeList;
+	DCmemPoolSlab *slabs;
+} DCmemPool;
+
+/**
+ * Initializes a pool, no memory is allocated until the first object is.
+ * @param objectSize size of a single object.
+ * @param objectsPerSlab number of objects allocated at once.
+ **/
+void dcmemInitPool(DCmemPool *pool, size_t objectSize, size_t objectsPerSlab);
+
+/** allocates an object from the pool. */
+void *dcmemPoolAllocate(DCmemPool *pool);
+
+/** returns an object to the pool. */
+void dcmemPoolDeallocate(DCmemPool *pool, void *object);
+
+/** frees all slabs, every object allocated from the pool becomes invalid. */
+void dcmemFreePool(DCmemPool *pool);
+
+#define DCMEM_POOL_ALLOCATE(POOL, TYPE) ((TYPE *)dcmemPoolAllocate((POOL)))
+
+/**
+ * Handle to an object in a DCmemRegistry, the low bits are the slot index and the high bits the slot generation.
+ * 0 is never a valid handle.
+ **/
+typedef uint32_t DCmemHandle;
+
+#define DCMEM_HANDLE_INDEX_BITS 20
+#define DCMEM_HANDLE_GENERATION_BITS (32 - DCMEM_HANDLE_INDEX_BITS)
+#define DCMEM_INVALID_HANDLE ((DCmemHandle)0)
+
+/**
+ * Objects of one size referred to by generational handles. Objects are stored densely (`objects[0..count)`,
+ * removing moves the last object into the hole) and handles go through a slot table, so lookups take constant
+ * time and handles of removed objects are detected because their slot's generation changed.
+ **/
+typedef struct DCmemRegistry {
+	size_t objectSize;
+	uint32_t count, capacity;
+	uint8_t *objects;
+	uint32_t *denseSlots; // slot of every dense object.
+
+	uint32_t slotCount, slotCapacity;
+	uint32_t *slots;       // dense index of used slots, next free slot of free slots.
+	uint16_t *generations; // generation of every slot, bumped when its object is removed.
+	uint32_t freeSlot;     // first free slot, UINT32_MAX if there's none.
+} DCmemRegistry;
+
+/** initializes an empty registry. */
+void dcmemInitRegistry(DCmemRegistry *registry, size_t objectSize);
+
+/**
+ * adds an object to the registry.
+ * @param object set to the (uninitialized) memory of the object, valid until the next add or remove.
+ * @return handle of the object, DCMEM_INVALID_HANDLE if the registry is full.
+ **/
+DCmemHandle dcmemRegistryAdd(DCmemRegistry *registry, void **object);
+
+/** returns the object of a handle, NULL if the handle is invalid or its object was removed. */
+void *dcmemRegistryGet(DCmemRegistry *registry, DCmemHandle handle);
+
+/** removes an object, returns false if the handle is invalid or its object was already removed. */
+bool dcmemRegistryRemove(DCmemRegistry *registry, DCmemHandle handle);
+
+/** frees the registry, every handle becomes invalid. */
+void dcmemFreeRegistry(DCmemRegistry *registry);
+
+#define DCMEM_REGISTRY_GET(REGISTRY, HANDLE, TYPE) ((TYPE *)dcmemRegistryGet((REGISTRY), (HANDLE)))
+#define DCMEM_REGISTRY_AT(REGISTRY, INDEX, TYPE) ((TYPE *)((REGISTRY)->objects + (REGISTRY)->objectSize * (INDEX)))
+
+/** size and alignment of the memory pools a TLSF heap takes from the OS. */
+#define DCMEM_TLSF_POOL_SIZE (4 * 1024 * 1024)
+/** allocations bigger than this bypass the TLSF heap and are mapped directly. */
+#define DCMEM_TLSF_LARGE_SIZE (1024 * 1024)
+
+typedef struct DCmemTlsf DCmemTlsf;
+
+/**
+ * Creates a TLSF (two-level segregated fit) heap. Allocating and deallocating take constant time,
+ * the heap grows by DCMEM_TLSF_POOL_SIZE pools that are only returned to the OS when the heap is freed.
+ * Allocations are aligned to DCMEM_DEFAULT_ALIGNMENT.
+ **/
+DCmemTlsf *dcmemNewTlsf();
+
+/** frees the heap and all of its pools, every allocation made from it becomes invalid. */
+void dcmemFreeTlsf(DCmemTlsf *heap);
+
+/** allocates from a heap. */
+void *dcmemTlsfAllocate(DCmemTlsf *heap, size_t size);
+
+/** returns memory to the heap it was allocated from, can be called from any thread. */
+void dcmemTlsfDeallocate(void *pointer);
+
+/** resizes an allocation in place if possible, otherwise moves it into `heap`. */
+void *dcmemTlsfReallocate(DCmemTlsf *heap, void *pointer, size_t size);
+
+typedef struct DCmemTlsfStats {
+	size_t usedBytes;  // bytes in live allocations (excluding headers).
+	size_t poolBytes;  // bytes taken from the OS for pools.
+	size_t largeBytes; // bytes in live allocations bigger than DCMEM_TLSF_LARGE_SIZE, for all heaps.
+} DCmemTlsfStats;
+
+DCmemTlsfStats dcmemGetTlsfStats(DCmemTlsf *heap);
+
+/**
+ * Sets the heap release builds allocate from on the calling thread, threads that only allocate
+ * from their own heap never contend on a lock. NULL selects the shared default heap.
+ **/
+void dcmemSetThreadHeap(DCmemTlsf *heap);
+
+/** returns the heap release builds allocate from on the calling thread. */
+DCmemTlsf *dcmemGetThreadHeap();
+
+/** number of allocation size histogram buckets, bucket `i` counts sizes in [2^(i+3), 2^(i+4)). */
+#define DCMEM_HISTOGRAM_BUCKETS 16
+
+/** allocation statistics of a single dcmemAllocate/dcmemReallocate call site. */
+typedef struct DCmemCallsiteStats {
+	const char *file, *func;
+	int line;
+	size_t allocCount, deallocCount, reallocCount;
+	size_t liveCount, liveBytes, peakBytes, totalBytes;
+	size_t histogram[DCMEM_HISTOGRAM_BUCKETS];
+} DCmemCallsiteStats;
+
+/**
+ * Returns a snapshot of the tracked call sites, sorted by the number of allocations (hottest first).
+ * @param sites array to fill, NULL to only get the count.
+ * @param count maximum number of call sites to return.
+ * @returns the number of call sites returned (or tracked if `sites` is NULL).
+ * @note call sites are only tracked with DC_DEBUG or DCMEM_PROFILE defined.
+ **/
+size_t dcmemGetCallsiteStats(DCmemCallsiteStats *sites, size_t count);
+
+/** prints the `count` hottest allocation call sites. */
+void dcmemPrintCallsiteStats(size_t count);
+
+/** prints every call site that still has live allocations. @returns the number of leaked bytes. */
+size_t dcmemPrintLeaks();
+
+#if defined(DC_DEBUG) || defined(DCMEM_PROFILE)
 
 void *dcmemAllocate_(size_t size, const char *f, const char *u, int l);
 void dcmemDeallocate_(void *pointer, const char *f, const char *u, int l);
@@ -26,14 +309,20 @@ void *dcmemReallocate_(void *pointer, size_t size, const char *f, const char *u,
 #	define dcmemDeallocate(pointer) dcmemDeallocate_((pointer), __FILE__, __func__, __LINE__)
 #	define dcmemReallocate(pointer, size) dcmemReallocate_((pointer), (size), __FILE__, __func__, __LINE__)
 
-#else
+#elif defined(DCMEM_USE_MALLOC)
 #	include <stdlib.h>
 #	define dcmemAllocate(size) malloc(size)
 #	define dcmemDeallocate(pointer) free(pointer)
-#	define dcmemReallocate(pointer, size) reallocate(pointer, size)
+#	define dcmemReallocate(pointer, size) realloc(pointer, size)
+
+#else
+#	define dcmemAllocate(size) dcmemTlsfAllocate(dcmemGetThreadHeap(), (size))
+#	define dcmemDeallocate(pointer) dcmemTlsfDeallocate((pointer))
+#	define dcmemReallocate(pointer, size) dcmemTlsfReallocate(dcmemGetThreadHeap(), (pointer), (size))
 #endif
 
-#define DCMEM_PUSH(ARENA, TYPE) (((TYPE) *)dcmemPush((ARENA), sizeof(TYPE)))
+#define DCMEM_PUSH(ARENA, TYPE) ((TYPE *)dcmemPushAligned((ARENA), sizeof(TYPE), alignof(TYPE)))
+#define DCMEM_PUSH_ARRAY(ARENA, TYPE, COUNT) ((TYPE *)dcmemPushAligned((ARENA), sizeof(TYPE) * (COUNT), alignof(TYPE)))
 #define DCMEM_POP(ARENA, TYPE) dcmemPop((ARENA), sizeof(TYPE))
 
 void printAllocationStats();
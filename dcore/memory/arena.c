@@ -1,29 +1,148 @@
 #include <dcore/memory.h>
+#include <dcore/memory/internal.h>
 #include <dcore/common.h>
 
-extern DCmemAllocStats allocStats; // defined in dcore/memory/memory.c
+struct DCmemArenaBlock {
+	DCmemArenaBlock *next, *prev;
+	size_t size, top;
+};
 
-void *dcmemPush(DCmemArena *arena, size_t size) {
-	if(arena->size == 0) {
-		arena->top = size;
-		arena->memory = dcmemAllocate(arena->size = arena->step);
-	} else {
-		arena->top += size;
-		arena->memory = dcmemReallocate(arena->memory, arena->size += arena->step);
+// block data starts right after the header, header size keeps the data aligned to DCMEM_DEFAULT_ALIGNMENT.
+#define BLOCK_HEADER_SIZE ((sizeof(DCmemArenaBlock) + DCMEM_DEFAULT_ALIGNMENT - 1) & ~(DCMEM_DEFAULT_ALIGNMENT - 1))
+#define BLOCK_DATA(BLOCK) ((uint8_t *)(BLOCK) + BLOCK_HEADER_SIZE)
+
+static size_t alignmentPadding(uintptr_t address, size_t alignment) { return (alignment - (address & (alignment - 1))) & (alignment - 1); }
+
+/** tries to push into the block, returns NULL if there isn't enough space. */
+static void *pushIntoBlock(DCmemArena *arena, DCmemArenaBlock *block, size_t size, size_t alignment) {
+	size_t padding = alignmentPadding((uintptr_t)(BLOCK_DATA(block) + block->top), alignment);
+	if(block->size - block->top < size + padding) return NULL;
+
+	void *pointer = BLOCK_DATA(block) + block->top + padding;
+	block->top += padding + size;
+	arena->top += padding + size;
+	return pointer;
+}
+
+static DCmemArenaBlock *newBlock(DCmemArena *arena, size_t minimumSize) {
+	size_t size = arena->step != 0 ? arena->step : DCMEM_ARENA_DEFAULT_STEP;
+	DCmemArenaBlock *last = arena->first;
+	while(last != NULL && last->next != NULL)
+		last = last->next;
+
+	if(last != NULL) size = last->size * 2; // geometric growth.
+	while(size < minimumSize)
+		size *= 2;
+
+	DCmemArenaBlock *block = dcmemAllocate(BLOCK_HEADER_SIZE + size);
+	DC_RVASSERT(block != NULL, "Failed to allocate an arena block", NULL);
+	block->next = NULL;
+	block->prev = last;
+	block->size = size;
+	block->top = 0;
+
+	if(last != NULL)
+		last->next = block;
+	else
+		arena->first = block;
+
+	arena->size += size;
+	DCMEMI_ADD_STAT(arenaBlockCount, 1);
+	return block;
+}
+
+void *dcmemPush(DCmemArena *arena, size_t size) { return dcmemPushAligned(arena, size, DCMEM_DEFAULT_ALIGNMENT); }
+
+void *dcmemPushAligned(DCmemArena *arena, size_t size, size_t alignment) {
+	DC_RVASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0, "Arena push alignment must be a power of two", NULL);
+	DCMEMI_ADD_STAT(arenaPushCount, 1);
+	if(arena->type == DCMEM_ARENA_TYPE_VIRTUAL) return dcmemiPushVirtual(arena, size, alignment);
+
+	void *pointer;
+	if(arena->current != NULL && (pointer = pushIntoBlock(arena, arena->current, size, alignment)) != NULL) return pointer;
+
+	// the current block is full, reuse the following blocks (kept after a reset) before allocating new ones.
+	DCmemArenaBlock *block = arena->current != NULL ? arena->current->next : arena->first;
+	for(; block != NULL; block = block->next) {
+		block->top = 0;
+		if((pointer = pushIntoBlock(arena, block, size, alignment)) != NULL) {
+			arena->current = block;
+			return pointer;
+		}
 	}
 
-	return (uint8_t *)arena->memory + arena->top;
+	block = newBlock(arena, size + alignment);
+	if(block == NULL) return NULL;
+	arena->current = block;
+	return pushIntoBlock(arena, block, size, alignment);
 }
 
 void dcmemPop(DCmemArena *arena, size_t size) {
+	DCMEMI_ADD_STAT(arenaPopCount, 1);
 	if(arena->top < size) {
 		DCD_FATAL("Tried to pop %zu bytes from an arena with only %zu bytes left.", size, arena->top);
-		arena->top = 0;
+		dcmemResetArena(arena);
 		return;
 	}
 
+	if(size == 0) return;
 	arena->top -= size;
-	if(arena->size - arena->top >= arena->step * 2) {
-		arena->memory = dcmemReallocate(arena->memory, arena->size -= arena->step);
+	if(arena->type == DCMEM_ARENA_TYPE_VIRTUAL) return;
+	while(size > arena->current->top) {
+		size -= arena->current->top;
+		arena->current->top = 0;
+		arena->current = arena->current->prev;
+	}
+	arena->current->top -= size;
+}
+
+DCmemArenaMarker dcmemGetArenaMarker(DCmemArena *arena) {
+	return (DCmemArenaMarker){ .block = arena->current, .blockTop = arena->current != NULL ? arena->current->top : 0, .top = arena->top };
+}
+
+void dcmemRestoreArenaMarker(DCmemArena *arena, DCmemArenaMarker marker) {
+	if(arena->type == DCMEM_ARENA_TYPE_VIRTUAL) {
+		DC_RASSERT(marker.top <= arena->top, "Tried to restore an arena marker that is above the arena top");
+		arena->top = marker.top;
+		return;
+	}
+
+	if(marker.block == NULL) {
+		dcmemResetArena(arena);
+		return;
 	}
+
+	DC_RASSERT(marker.top <= arena->top, "Tried to restore an arena marker that is above the arena top");
+	arena->current = marker.block;
+	arena->current->top = marker.blockTop;
+	arena->top = marker.top;
+}
+
+void dcmemResetArena(DCmemArena *arena) {
+	if(arena->type == DCMEM_ARENA_TYPE_VIRTUAL) {
+		arena->top = 0;
+		dcmemiTrimVirtual(arena);
+		return;
+	}
+
+	arena->current = arena->first;
+	if(arena->current != NULL) arena->current->top = 0;
+	arena->top = 0;
+}
+
+void dcmemFreeArena(DCmemArena *arena) {
+	if(arena->type == DCMEM_ARENA_TYPE_VIRTUAL) {
+		dcmemiFreeVirtual(arena);
+		return;
+	}
+
+	DCmemArenaBlock *block = arena->first;
+	while(block != NULL) {
+		DCmemArenaBlock *next = block->next;
+		dcmemDeallocate(block);
+		block = next;
+	}
+
+	arena->first = arena->current = NULL;
+	arena->size = arena->top = 0;
 }
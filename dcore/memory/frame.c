@@ -0,0 +1,27 @@
+#include <dcore/memory.h>
+#include <dcore/common.h>
+
+void dcmemInitFrameAllocator(DCmemFrameAllocator *allocator, size_t frameCount, size_t step) {
+	DC_RASSERT(frameCount > 0 && frameCount <= DCMEM_MAX_FRAMES_IN_FLIGHT, "Bad frame allocator frame count");
+	allocator->frameCount = frameCount;
+	allocator->frame = 0;
+	for(size_t i = 0; i < DCMEM_MAX_FRAMES_IN_FLIGHT; ++i)
+		allocator->arenas[i] = (DCmemArena){ .step = step };
+}
+
+void dcmemBeginFrame(DCmemFrameAllocator *allocator, size_t frame) {
+	DC_RASSERT(frame < allocator->frameCount, "Frame index out of bounds");
+	allocator->frame = frame;
+	dcmemResetArena(&allocator->arenas[frame]);
+}
+
+DCmemArena *dcmemGetFrameArena(DCmemFrameAllocator *allocator) { return &allocator->arenas[allocator->frame]; }
+
+void *dcmemFramePush(DCmemFrameAllocator *allocator, size_t size, size_t alignment) {
+	return dcmemPushAligned(&allocator->arenas[allocator->frame], size, alignment);
+}
+
+void dcmemFreeFrameAllocator(DCmemFrameAllocator *allocator) {
+	for(size_t i = 0; i < allocator->frameCount; ++i)
+		dcmemFreeArena(&allocator->arenas[i]);
+}
@@ -0,0 +1,37 @@
+#ifndef DCORE_MEMORY_INTERNAL_H
+#define DCORE_MEMORY_INTERNAL_H
+#include <dcore/memory.h>
+#include <stdatomic.h>
+
+#define DCMEMI__ATOMIC_STATS_FIELD(NAME) _Atomic size_t NAME;
+
+/** allocation statistics of a single thread, only written by their thread. */
+typedef struct DCmemiThreadStats {
+	DCMEM__ALLOC_STATS_FOR(DCMEMI__ATOMIC_STATS_FIELD)
+	_Atomic size_t peakResidentBytes;
+	struct DCmemiThreadStats *next;
+} DCmemiThreadStats;
+
+/** returns the statistics block of the calling thread, registers it on first use. */
+DCmemiThreadStats *dcmemiGetThreadStats();
+
+/** adds to a counter of the calling thread, a relaxed load and store since no other thread writes to it. */
+static inline void dcmemiAddStat(_Atomic size_t *counter, size_t value) {
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+#define DCMEMI_ADD_STAT(FIELD, VALUE) dcmemiAddStat(&dcmemiGetThreadStats()->FIELD, (size_t)(VALUE))
+
+/** pushes into a virtual arena, commits pages if needed. */
+void *dcmemiPushVirtual(DCmemArena *arena, size_t size, size_t alignment);
+/** decommits the pages past the arena high water mark. */
+void dcmemiTrimVirtual(DCmemArena *arena);
+/** releases the reserved address range. */
+void dcmemiFreeVirtual(DCmemArena *arena);
+
+/** maps committed pages straight from the OS, size is rounded up to the page size. */
+void *dcmemiMapPages(size_t size, size_t alignment);
+/** unmaps pages mapped by dcmemiMapPages. */
+void dcmemiUnmapPages(void *pages, size_t size);
+
+#endif
@@ -1,28 +1,319 @@
 #include <dcore/memory.h>
+#include <dcore/memory/internal.h>
 #include <dcore/common.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
 
-DCmemAllocStats allocStats;
+/* allocation statistics are counted in one block per thread, so that counting
+   doesn't need atomic read-modify-write operations. dcmemGetAllocStats sums up
+   the blocks of all live threads and the stats of the threads that exited. */
+static pthread_mutex_t threadStatsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t threadStatsKey;
+static pthread_once_t threadStatsKeyOnce = PTHREAD_ONCE_INIT;
+static DCmemiThreadStats *threadStatsList;
+static DCmemAllocStats exitedThreadStats;
+static _Thread_local DCmemiThreadStats *threadStats;
 
-#if defined(DC_DEBUG)
+static void addThreadStats(DCmemAllocStats *stats, DCmemiThreadStats *thread) {
+#define ADD_FIELD(NAME) stats->NAME += atomic_load_explicit(&thread->NAME, memory_order_relaxed);
+	DCMEM__ALLOC_STATS_FOR(ADD_FIELD)
+#undef ADD_FIELD
+	stats->peakResidentBytes += atomic_load_explicit(&thread->peakResidentBytes, memory_order_relaxed);
+}
+
+static void exitThread(void *stats) {
+	pthread_mutex_lock(&threadStatsMutex);
+	addThreadStats(&exitedThreadStats, stats);
+	for(DCmemiThreadStats **link = &threadStatsList; *link != NULL; link = &(*link)->next) {
+		if(*link == stats) {
+			*link = (*link)->next;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&threadStatsMutex);
+	if(stats == threadStats) threadStats = NULL;
+	free(stats);
+}
+
+static void createThreadStatsKey() { pthread_key_create(&threadStatsKey, &exitThread); }
+
+DCmemiThreadStats *dcmemiGetThreadStats() {
+	if(threadStats != NULL) return threadStats;
+
+	pthread_once(&threadStatsKeyOnce, &createThreadStatsKey);
+	threadStats = calloc(1, sizeof(DCmemiThreadStats));
+	pthread_setspecific(threadStatsKey, threadStats);
+
+	pthread_mutex_lock(&threadStatsMutex);
+	threadStats->next = threadStatsList;
+	threadStatsList = threadStats;
+	pthread_mutex_unlock(&threadStatsMutex);
+	return threadStats;
+}
+
+DCmemAllocStats dcmemGetAllocStats() {
+	pthread_mutex_lock(&threadStatsMutex);
+	DCmemAllocStats stats = exitedThreadStats;
+	for(DCmemiThreadStats *thread = threadStatsList; thread != NULL; thread = thread->next)
+		addThreadStats(&stats, thread);
+	pthread_mutex_unlock(&threadStatsMutex);
+
+	stats.residentBytes = stats.allocatedBytes - stats.deallocatedBytes;
+	return stats;
+}
+
+DCmemAllocStats dcmemDiffAllocStats(const DCmemAllocStats *before, const DCmemAllocStats *after) {
+	DCmemAllocStats diff;
+#define DIFF_FIELD(NAME) diff.NAME = after->NAME - before->NAME;
+	DCMEM__ALLOC_STATS_FOR(DIFF_FIELD)
+#undef DIFF_FIELD
+	diff.residentBytes = after->residentBytes;
+	diff.peakResidentBytes = after->peakResidentBytes;
+	return diff;
+}
+
+void dcmemResetPeakResidentBytes() {
+	pthread_mutex_lock(&threadStatsMutex);
+	for(DCmemiThreadStats *thread = threadStatsList; thread != NULL; thread = thread->next) {
+		size_t resident = atomic_load_explicit(&thread->allocatedBytes, memory_order_relaxed)
+		  - atomic_load_explicit(&thread->deallocatedBytes, memory_order_relaxed);
+		atomic_store_explicit(&thread->peakResidentBytes, (ptrdiff_t)resident > 0 ? resident : 0, memory_order_relaxed);
+	}
+	size_t exitedResident = exitedThreadStats.allocatedBytes - exitedThreadStats.deallocatedBytes;
+	exitedThreadStats.peakResidentBytes = (ptrdiff_t)exitedResident > 0 ? exitedResident : 0;
+	pthread_mutex_unlock(&threadStatsMutex);
+}
+
+// must be a power of two.
+#define MAX_CALLSITES 1024
+
+/** call site table entry, the key (file, func, line) is written once before `ready` is set. */
+typedef struct Callsite {
+	const char *file, *func;
+	int line;
+	atomic_bool ready;
+	_Atomic size_t allocCount, deallocCount, reallocCount;
+	_Atomic size_t liveCount, liveBytes, peakBytes, totalBytes;
+	_Atomic size_t histogram[DCMEM_HISTOGRAM_BUCKETS];
+} Callsite;
+
+static Callsite callsites[MAX_CALLSITES];
+static Callsite overflowCallsite = { "<too many call sites>", "", 0, true };
+static _Atomic size_t callsiteCount;
+
+#if defined(DC_DEBUG) || defined(DCMEM_PROFILE)
+
+static pthread_mutex_t callsiteMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* every tracked allocation is prefixed with a header, so that deallocations
+   can be attributed to the call site that allocated the memory. */
+typedef struct AllocationHeader {
+	size_t size;
+	Callsite *site;
+} AllocationHeader;
+
+#	define HEADER_SIZE ((sizeof(AllocationHeader) + DCMEM_DEFAULT_ALIGNMENT - 1) & ~(DCMEM_DEFAULT_ALIGNMENT - 1))
+#	define HEADER(POINTER) ((AllocationHeader *)((uint8_t *)(POINTER)-HEADER_SIZE))
+
+#	define RELAXED_ADD(COUNTER, VALUE) atomic_fetch_add_explicit(&(COUNTER), (VALUE), memory_order_relaxed)
+#	define RELAXED_SUB(COUNTER, VALUE) atomic_fetch_sub_explicit(&(COUNTER), (VALUE), memory_order_relaxed)
+
+/**
+ * finds or adds the call site (open addressing on the file pointer and line).
+ * lookups are lock-free, adding a call site takes a lock and probes again.
+ **/
+static Callsite *getCallsite(const char *file, const char *func, int line, bool locked) {
+	size_t hash = ((uintptr_t)file >> 3) * 31 + (size_t)line * 2654435761u;
+	for(size_t i = 0; i < MAX_CALLSITES; ++i) {
+		Callsite *site = &callsites[(hash + i) & (MAX_CALLSITES - 1)];
+		if(atomic_load_explicit(&site->ready, memory_order_acquire)) {
+			if(site->file == file && site->line == line) return site;
+			continue;
+		}
+
+		if(!locked) {
+			pthread_mutex_lock(&callsiteMutex);
+			site = getCallsite(file, func, line, true);
+			pthread_mutex_unlock(&callsiteMutex);
+			return site;
+		}
+
+		site->file = file;
+		site->func = func;
+		site->line = line;
+		atomic_store_explicit(&site->ready, true, memory_order_release);
+		RELAXED_ADD(callsiteCount, 1);
+		return site;
+	}
+
+	return &overflowCallsite;
+}
+
+static size_t histogramBucket(size_t size) {
+	if(size < 16) return 0;
+	size_t bucket = (size_t)(63 - __builtin_clzll((unsigned long long)size)) - 3;
+	return bucket < DCMEM_HISTOGRAM_BUCKETS ? bucket : DCMEM_HISTOGRAM_BUCKETS - 1;
+}
+
+static void *track(AllocationHeader *header, size_t size, Callsite *site) {
+	header->size = size;
+	header->site = site;
+	RELAXED_ADD(site->liveCount, 1);
+	size_t live = RELAXED_ADD(site->liveBytes, size) + size;
+	RELAXED_ADD(site->totalBytes, size);
+	RELAXED_ADD(site->histogram[histogramBucket(size)], 1);
+
+	size_t peak = atomic_load_explicit(&site->peakBytes, memory_order_relaxed);
+	while(live > peak && !atomic_compare_exchange_weak_explicit(&site->peakBytes, &peak, live, memory_order_relaxed, memory_order_relaxed)) { }
+
+	DCmemiThreadStats *stats = dcmemiGetThreadStats();
+	dcmemiAddStat(&stats->allocatedBytes, size);
+	size_t resident = atomic_load_explicit(&stats->allocatedBytes, memory_order_relaxed) - atomic_load_explicit(&stats->deallocatedBytes, memory_order_relaxed);
+	if((ptrdiff_t)resident > (ptrdiff_t)atomic_load_explicit(&stats->peakResidentBytes, memory_order_relaxed))
+		atomic_store_explicit(&stats->peakResidentBytes, resident, memory_order_relaxed);
+	return (uint8_t *)header + HEADER_SIZE;
+}
+
+static void untrack(AllocationHeader *header) {
+	RELAXED_SUB(header->site->liveCount, 1);
+	RELAXED_SUB(header->site->liveBytes, header->size);
+	DCMEMI_ADD_STAT(deallocatedBytes, header->size);
+}
 
 void *dcmemAllocate_(size_t size, const char *f, const char *u, int l) {
 	if(size == 0) DCD_WARNING("Tried to allocate zero bytes. %s:%d @%s", f, l, u);
-	allocStats.allocCount += 1;
-	return malloc(size);
+	DCMEMI_ADD_STAT(allocCount, 1);
+
+	AllocationHeader *header = malloc(HEADER_SIZE + size);
+	if(header == NULL) return NULL;
+	Callsite *site = getCallsite(f, u, l, false);
+	RELAXED_ADD(site->allocCount, 1);
+	return track(header, size, site);
 }
 
 void dcmemDeallocate_(void *pointer, const char *f, const char *u, int l) {
-	if(pointer == NULL) DCD_WARNING("Tried to deallocate a NULL pointer. %s:%d @%s", f, l, u);
-	allocStats.deallocCount += 1;
-	free(pointer);
+	if(pointer == NULL) {
+		DCD_WARNING("Tried to deallocate a NULL pointer. %s:%d @%s", f, l, u);
+		return;
+	}
+	DCMEMI_ADD_STAT(deallocCount, 1);
+
+	AllocationHeader *header = HEADER(pointer);
+	untrack(header);
+	RELAXED_ADD(header->site->deallocCount, 1);
+	free(header);
 }
 
 void *dcmemReallocate_(void *pointer, size_t size, const char *f, const char *u, int l) {
 	if(pointer == NULL) DCD_WARNING("Tried to reallocate a NULL pointer. %s:%d @%s", f, l, u);
 	if(size == 0) DCD_WARNING("Tried to reallocate to zero bytes. %s:%d @%s", f, l, u);
-	allocStats.reallocCount += 1;
-	return realloc(pointer, size);
+	DCMEMI_ADD_STAT(reallocCount, 1);
+
+	AllocationHeader *header = pointer != NULL ? HEADER(pointer) : NULL;
+	AllocationHeader oldHeader = header != NULL ? *header : (AllocationHeader){ 0 };
+
+	AllocationHeader *newHeader = realloc(header, HEADER_SIZE + size);
+	if(newHeader == NULL) return NULL;
+
+	// the memory now belongs to the reallocating call site.
+	if(header != NULL) untrack(&oldHeader);
+	Callsite *site = getCallsite(f, u, l, false);
+	RELAXED_ADD(site->reallocCount, 1);
+	return track(newHeader, size, site);
 }
 
 #endif
+
+static DCmemCallsiteStats loadCallsite(Callsite *site) {
+	DCmemCallsiteStats stats = { site->file, site->func, site->line };
+	stats.allocCount = atomic_load_explicit(&site->allocCount, memory_order_relaxed);
+	stats.deallocCount = atomic_load_explicit(&site->deallocCount, memory_order_relaxed);
+	stats.reallocCount = atomic_load_explicit(&site->reallocCount, memory_order_relaxed);
+	stats.liveCount = atomic_load_explicit(&site->liveCount, memory_order_relaxed);
+	stats.liveBytes = atomic_load_explicit(&site->liveBytes, memory_order_relaxed);
+	stats.peakBytes = atomic_load_explicit(&site->peakBytes, memory_order_relaxed);
+	stats.totalBytes = atomic_load_explicit(&site->totalBytes, memory_order_relaxed);
+	for(size_t i = 0; i < DCMEM_HISTOGRAM_BUCKETS; ++i)
+		stats.histogram[i] = atomic_load_explicit(&site->histogram[i], memory_order_relaxed);
+	return stats;
+}
+
+static int compareCallsites(const void *a, const void *b) {
+	const DCmemCallsiteStats *siteA = a, *siteB = b;
+	size_t callsA = siteA->allocCount + siteA->reallocCount, callsB = siteB->allocCount + siteB->reallocCount;
+	return callsA < callsB ? 1 : callsA > callsB ? -1 : 0;
+}
+
+size_t dcmemGetCallsiteStats(DCmemCallsiteStats *sites, size_t count) {
+	if(sites == NULL) return atomic_load(&callsiteCount);
+
+	DCmemCallsiteStats *sorted = malloc(sizeof(DCmemCallsiteStats) * (MAX_CALLSITES + 1));
+	if(sorted == NULL) return 0;
+
+	size_t sortedCount = 0;
+	for(size_t i = 0; i < MAX_CALLSITES; ++i)
+		if(atomic_load_explicit(&callsites[i].ready, memory_order_acquire)) sorted[sortedCount++] = loadCallsite(&callsites[i]);
+	sorted[sortedCount] = loadCallsite(&overflowCallsite);
+	if(sorted[sortedCount].allocCount + sorted[sortedCount].reallocCount != 0) sortedCount += 1;
+
+	qsort(sorted, sortedCount, sizeof(*sorted), &compareCallsites);
+	if(count > sortedCount) count = sortedCount;
+	for(size_t i = 0; i < count; ++i)
+		sites[i] = sorted[i];
+	free(sorted);
+	return count;
+}
+
+void dcmemPrintCallsiteStats(size_t count) {
+	DCmemCallsiteStats *sites = malloc(sizeof(DCmemCallsiteStats) * count);
+	if(sites == NULL) return;
+	count = dcmemGetCallsiteStats(sites, count);
+
+	DCD_INFO("%zu hottest allocation call sites (of %zu):", count, atomic_load(&callsiteCount));
+	for(size_t i = 0; i < count; ++i) {
+		char histogram[DCMEM_HISTOGRAM_BUCKETS * 8] = { 0 };
+		size_t length = 0;
+		for(size_t j = 0; j < DCMEM_HISTOGRAM_BUCKETS && length < sizeof(histogram); ++j)
+			length += snprintf(histogram + length, sizeof(histogram) - length, "%zu ", sites[i].histogram[j]);
+
+		DCD_INFO(
+		  "%s:%d @%s: %zu allocs, %zu reallocs, %zu deallocs, %zu live bytes, %zu peak bytes, %zu total bytes", sites[i].file, sites[i].line,
+		  sites[i].func, sites[i].allocCount, sites[i].reallocCount, sites[i].deallocCount, sites[i].liveBytes, sites[i].peakBytes, sites[i].totalBytes
+		);
+		DCD_INFO("  `- size histogram (<16, <32, ...): %s", histogram);
+	}
+
+	free(sites);
+}
+
+size_t dcmemPrintLeaks() {
+	size_t leakedBytes = 0;
+	for(size_t i = 0; i < MAX_CALLSITES; ++i) {
+		if(!atomic_load_explicit(&callsites[i].ready, memory_order_acquire)) continue;
+		DCmemCallsiteStats site = loadCallsite(&callsites[i]);
+		if(site.liveCount == 0) continue;
+
+		DCD_WARNING("Leaked %zu bytes (%zu allocations) from %s:%d @%s", site.liveBytes, site.liveCount, site.file, site.line, site.func);
+		leakedBytes += site.liveBytes;
+	}
+
+	if(leakedBytes == 0) DCD_INFO("No leaks.");
+	return leakedBytes;
+}
+
+void printAllocationStats() {
+	DCmemAllocStats stats = dcmemGetAllocStats();
+	DCD_INFO("Allocations: %zu, deallocations: %zu, reallocations: %zu", stats.allocCount, stats.deallocCount, stats.reallocCount);
+	DCD_INFO(
+	  "Allocated bytes: %zu, deallocated bytes: %zu, resident bytes: %zu, peak resident bytes: %zu", stats.allocatedBytes, stats.deallocatedBytes,
+	  stats.residentBytes, stats.peakResidentBytes
+	);
+	DCD_INFO("Arena pushes: %zu, pops: %zu, blocks: %zu", stats.arenaPushCount, stats.arenaPopCount, stats.arenaBlockCount);
+	size_t livePoolObjects = stats.poolAllocCount - stats.poolDeallocCount;
+	DCD_INFO(
+	  "Pool objects: %zu/%zu (%zu%% occupancy), slabs: %zu", livePoolObjects, stats.poolCapacity,
+	  stats.poolCapacity ? livePoolObjects * 100 / stats.poolCapacity : 0, stats.poolSlabCount
+	);
+	dcmemPrintCallsiteStats(16);
+}
@@ -0,0 +1,86 @@
+#include <dcore/memory.h>
+#include <dcore/memory/internal.h>
+#include <dcore/common.h>
+
+struct DCmemPoolSlab {
+	DCmemPoolSlab *next;
+	void *allocation; // unaligned pointer returned by dcmemAllocate.
+};
+
+// objects start one cache line after the slab header.
+#define SLAB_HEADER_SIZE ((sizeof(DCmemPoolSlab) + DCMEM_CACHE_LINE_SIZE - 1) & ~(size_t)(DCMEM_CACHE_LINE_SIZE - 1))
+
+void dcmemInitPool(DCmemPool *pool, size_t objectSize, size_t objectsPerSlab) {
+	DC_RASSERT(objectsPerSlab > 0, "Pool slabs must hold at least one object");
+	// each object must be able to hold the free list link and keep the next object aligned.
+	if(objectSize < sizeof(void *)) objectSize = sizeof(void *);
+	pool->objectSize = (objectSize + DCMEM_DEFAULT_ALIGNMENT - 1) & ~(DCMEM_DEFAULT_ALIGNMENT - 1);
+	pool->objectsPerSlab = objectsPerSlab;
+	pool->slabCount = 0;
+	pool->liveCount = 0;
+	pool->freeList = NULL;
+	pool->slabs = NULL;
+}
+
+static bool addSlab(DCmemPool *pool) {
+	size_t size = SLAB_HEADER_SIZE + pool->objectSize * pool->objectsPerSlab;
+	void *allocation = dcmemAllocate(size + DCMEM_CACHE_LINE_SIZE - 1);
+	DC_RVASSERT(allocation != NULL, "Failed to allocate a pool slab", false);
+
+	DCmemPoolSlab *slab = (DCmemPoolSlab *)(((uintptr_t)allocation + DCMEM_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(DCMEM_CACHE_LINE_SIZE - 1));
+	slab->allocation = allocation;
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->slabCount += 1;
+
+	// link objects in address order so that consecutive allocations are adjacent.
+	uint8_t *objects = (uint8_t *)slab + SLAB_HEADER_SIZE;
+	for(size_t i = pool->objectsPerSlab; i-- > 0;) {
+		*(void **)(objects + i * pool->objectSize) = pool->freeList;
+		pool->freeList = objects + i * pool->objectSize;
+	}
+
+	DCMEMI_ADD_STAT(poolSlabCount, 1);
+	DCMEMI_ADD_STAT(poolCapacity, pool->objectsPerSlab);
+	return true;
+}
+
+void *dcmemPoolAllocate(DCmemPool *pool) {
+	if(pool->freeList == NULL && !addSlab(pool)) return NULL;
+
+	void *object = pool->freeList;
+	pool->freeList = *(void **)object;
+	pool->liveCount += 1;
+	DCMEMI_ADD_STAT(poolAllocCount, 1);
+	return object;
+}
+
+void dcmemPoolDeallocate(DCmemPool *pool, void *object) {
+	DEBUGIF(object == NULL) {
+		DCD_WARNING("Tried to return a NULL pointer to a pool.");
+		return;
+	}
+
+	*(void **)object = pool->freeList;
+	pool->freeList = object;
+	pool->liveCount -= 1;
+	DCMEMI_ADD_STAT(poolDeallocCount, 1);
+}
+
+void dcmemFreePool(DCmemPool *pool) {
+	if(pool->liveCount != 0) DCD_WARNING("Freeing a pool with %zu live objects.", pool->liveCount);
+
+	DCmemPoolSlab *slab = pool->slabs;
+	while(slab != NULL) {
+		DCmemPoolSlab *next = slab->next;
+		dcmemDeallocate(slab->allocation);
+		slab = next;
+	}
+
+	DCMEMI_ADD_STAT(poolSlabCount, -pool->slabCount);
+	DCMEMI_ADD_STAT(poolCapacity, -(pool->slabCount * pool->objectsPerSlab));
+	pool->slabs = NULL;
+	pool->freeList = NULL;
+	pool->slabCount = 0;
+	pool->liveCount = 0;
+}
@@ -0,0 +1,93 @@
+#include <dcore/memory.h>
+#include <dcore/common.h>
+#include <string.h>
+
+#define MAX_SLOTS ((uint32_t)1 << DCMEM_HANDLE_INDEX_BITS)
+#define GENERATION_MASK ((1u << DCMEM_HANDLE_GENERATION_BITS) - 1)
+#define NO_SLOT UINT32_MAX
+
+#define HANDLE_INDEX(HANDLE) ((HANDLE) & (MAX_SLOTS - 1))
+#define HANDLE_GENERATION(HANDLE) ((HANDLE) >> DCMEM_HANDLE_INDEX_BITS)
+
+void dcmemInitRegistry(DCmemRegistry *registry, size_t objectSize) {
+	*registry = (DCmemRegistry){ .objectSize = objectSize, .freeSlot = NO_SLOT };
+}
+
+static bool grow(void **array, uint32_t *capacity, size_t elementSize) {
+	uint32_t newCapacity = *capacity != 0 ? *capacity * 2 : 16;
+	void *grown = *array == NULL ? dcmemAllocate(elementSize * newCapacity) : dcmemReallocate(*array, elementSize * newCapacity);
+	if(grown == NULL) return false;
+	*array = grown;
+	*capacity = newCapacity;
+	return true;
+}
+
+DCmemHandle dcmemRegistryAdd(DCmemRegistry *registry, void **object) {
+	uint32_t slot = registry->freeSlot;
+	if(slot != NO_SLOT) {
+		registry->freeSlot = registry->slots[slot];
+	} else {
+		DC_RVASSERT(registry->slotCount < MAX_SLOTS, "Registry is full", DCMEM_INVALID_HANDLE);
+		if(registry->slotCount == registry->slotCapacity) {
+			uint32_t capacity = registry->slotCapacity;
+			if(!grow((void **)&registry->slots, &capacity, sizeof(uint32_t))) return DCMEM_INVALID_HANDLE;
+			if(!grow((void **)&registry->generations, &registry->slotCapacity, sizeof(uint16_t))) return DCMEM_INVALID_HANDLE;
+		}
+		slot = registry->slotCount++;
+		registry->generations[slot] = 1;
+	}
+
+	// objects and their slots grow together, the capacity is only updated after both grew.
+	if(registry->count == registry->capacity) {
+		uint32_t capacity = registry->capacity;
+		if(!grow((void **)&registry->denseSlots, &capacity, sizeof(uint32_t))) return DCMEM_INVALID_HANDLE;
+		if(!grow((void **)&registry->objects, &registry->capacity, registry->objectSize)) return DCMEM_INVALID_HANDLE;
+	}
+
+	uint32_t index = registry->count++;
+	registry->denseSlots[index] = slot;
+	registry->slots[slot] = index;
+	if(object != NULL) *object = registry->objects + registry->objectSize * index;
+	return ((DCmemHandle)registry->generations[slot] << DCMEM_HANDLE_INDEX_BITS) | slot;
+}
+
+/** returns the slot of a handle, NO_SLOT if it's stale. */
+static uint32_t getSlot(DCmemRegistry *registry, DCmemHandle handle) {
+	uint32_t slot = HANDLE_INDEX(handle);
+	if(handle == DCMEM_INVALID_HANDLE || slot >= registry->slotCount || registry->generations[slot] != HANDLE_GENERATION(handle)) return NO_SLOT;
+	return slot;
+}
+
+void *dcmemRegistryGet(DCmemRegistry *registry, DCmemHandle handle) {
+	uint32_t slot = getSlot(registry, handle);
+	if(slot == NO_SLOT) return NULL;
+	return registry->objects + registry->objectSize * registry->slots[slot];
+}
+
+bool dcmemRegistryRemove(DCmemRegistry *registry, DCmemHandle handle) {
+	uint32_t slot = getSlot(registry, handle);
+	if(slot == NO_SLOT) return false;
+
+	// keep the objects dense by moving the last one into the hole.
+	uint32_t index = registry->slots[slot], last = --registry->count;
+	if(index != last) {
+		memcpy(registry->objects + registry->objectSize * index, registry->objects + registry->objectSize * last, registry->objectSize);
+		registry->denseSlots[index] = registry->denseSlots[last];
+		registry->slots[registry->denseSlots[index]] = index;
+	}
+
+	// generation 0 is skipped, so that handles are never 0.
+	registry->generations[slot] = (registry->generations[slot] + 1) & GENERATION_MASK;
+	if(registry->generations[slot] == 0) registry->generations[slot] = 1;
+	registry->slots[slot] = registry->freeSlot;
+	registry->freeSlot = slot;
+	return true;
+}
+
+void dcmemFreeRegistry(DCmemRegistry *registry) {
+	if(registry->objects != NULL) dcmemDeallocate(registry->objects);
+	if(registry->denseSlots != NULL) dcmemDeallocate(registry->denseSlots);
+	if(registry->slots != NULL) dcmemDeallocate(registry->slots);
+	if(registry->generations != NULL) dcmemDeallocate(registry->generations);
+	dcmemInitRegistry(registry, registry->objectSize);
+}
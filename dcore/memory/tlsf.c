@@ -0,0 +1,309 @@
+#include <dcore/memory.h>
+#include <dcore/memory/internal.h>
+#include <dcore/common.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+/* two-level segregated fit: free blocks are kept in lists indexed by the log2 of their size (first level)
+   and a linear subdivision of that power of two (second level). bitmaps of the non-empty lists make finding
+   a fitting block a couple of bit scans, so allocating and deallocating take constant time. */
+
+#define ALIGN_LOG2 4
+#define ALIGN_SIZE (1 << ALIGN_LOG2)
+#define SL_COUNT_LOG2 5
+#define SL_COUNT (1 << SL_COUNT_LOG2)
+#define FL_SHIFT (SL_COUNT_LOG2 + ALIGN_LOG2)
+#define FL_MAX 22 // log2 of DCMEM_TLSF_POOL_SIZE.
+#define FL_COUNT (FL_MAX - FL_SHIFT + 1)
+#define SMALL_BLOCK_SIZE (1 << FL_SHIFT)
+
+static_assert(DCMEM_DEFAULT_ALIGNMENT <= ALIGN_SIZE, "TLSF allocations must be aligned to DCMEM_DEFAULT_ALIGNMENT");
+static_assert((1 << FL_MAX) == DCMEM_TLSF_POOL_SIZE, "FL_MAX must match DCMEM_TLSF_POOL_SIZE");
+
+/* a block header is right before the memory of the block, the next block starts right after the memory.
+   prevPhys is always valid, nextFree and prevFree overlap the memory and are only valid for free blocks. */
+typedef struct Block {
+	struct Block *prevPhys;
+	size_t size; // size of the memory, low bits are flags.
+	struct Block *nextFree, *prevFree;
+} Block;
+
+#define BLOCK_HEADER_SIZE (offsetof(Block, size) + sizeof(size_t))
+#define BLOCK_MIN_SIZE (sizeof(Block) - BLOCK_HEADER_SIZE)
+#define FLAG_FREE ((size_t)0x1)
+#define FLAG_LARGE ((size_t)0x2)
+#define FLAG_MASK ((size_t)ALIGN_SIZE - 1)
+
+#define BLOCK_MEMORY(BLOCK) ((uint8_t *)(BLOCK) + BLOCK_HEADER_SIZE)
+#define MEMORY_BLOCK(POINTER) ((Block *)((uint8_t *)(POINTER)-BLOCK_HEADER_SIZE))
+#define BLOCK_SIZE(BLOCK) ((BLOCK)->size & ~FLAG_MASK)
+#define NEXT_PHYS(BLOCK) ((Block *)(BLOCK_MEMORY(BLOCK) + BLOCK_SIZE(BLOCK)))
+
+/* pools are aligned to their size, so the pool (and heap) of a block is found by masking its address. */
+typedef struct Pool {
+	DCmemTlsf *heap;
+	struct Pool *next;
+} Pool;
+
+#define POOL_HEADER_SIZE ((sizeof(Pool) + ALIGN_SIZE - 1) & ~(size_t)(ALIGN_SIZE - 1))
+#define POOL_OF(POINTER) ((Pool *)((uintptr_t)(POINTER) & ~(uintptr_t)(DCMEM_TLSF_POOL_SIZE - 1)))
+
+struct DCmemTlsf {
+	pthread_mutex_t mutex;
+	uint32_t flBitmap;
+	uint32_t slBitmaps[FL_COUNT];
+	Block *freeLists[FL_COUNT][SL_COUNT];
+	Pool *pools;
+	size_t usedBytes, poolBytes;
+};
+
+static _Atomic size_t largeBytes;
+
+static int findLastSet(size_t value) { return 63 - __builtin_clzll((unsigned long long)value); }
+static int findFirstSet(uint32_t value) { return __builtin_ctz(value); }
+
+static void mappingInsert(size_t size, int *fl, int *sl) {
+	if(size < SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = (int)(size / (SMALL_BLOCK_SIZE / SL_COUNT));
+	} else {
+		int last = findLastSet(size);
+		*sl = (int)(size >> (last - SL_COUNT_LOG2)) ^ SL_COUNT;
+		*fl = last - (FL_SHIFT - 1);
+	}
+}
+
+/** rounds the size up to the next list, so that every block in the found list fits. */
+static void mappingSearch(size_t size, int *fl, int *sl) {
+	if(size >= SMALL_BLOCK_SIZE) size += ((size_t)1 << (findLastSet(size) - SL_COUNT_LOG2)) - 1;
+	mappingInsert(size, fl, sl);
+}
+
+static void insertFree(DCmemTlsf *heap, Block *block) {
+	int fl, sl;
+	mappingInsert(BLOCK_SIZE(block), &fl, &sl);
+	block->size |= FLAG_FREE;
+	block->prevFree = NULL;
+	block->nextFree = heap->freeLists[fl][sl];
+	if(block->nextFree != NULL) block->nextFree->prevFree = block;
+	heap->freeLists[fl][sl] = block;
+	heap->flBitmap |= 1u << fl;
+	heap->slBitmaps[fl] |= 1u << sl;
+}
+
+static void removeFree(DCmemTlsf *heap, Block *block) {
+	int fl, sl;
+	mappingInsert(BLOCK_SIZE(block), &fl, &sl);
+	if(block->prevFree != NULL)
+		block->prevFree->nextFree = block->nextFree;
+	else
+		heap->freeLists[fl][sl] = block->nextFree;
+	if(block->nextFree != NULL) block->nextFree->prevFree = block->prevFree;
+
+	if(heap->freeLists[fl][sl] == NULL) {
+		heap->slBitmaps[fl] &= ~(1u << sl);
+		if(heap->slBitmaps[fl] == 0) heap->flBitmap &= ~(1u << fl);
+	}
+	block->size &= ~FLAG_FREE;
+}
+
+static Block *findFree(DCmemTlsf *heap, size_t size) {
+	int fl, sl;
+	mappingSearch(size, &fl, &sl);
+	if(fl >= FL_COUNT) return NULL;
+
+	uint32_t slMap = heap->slBitmaps[fl] & (~0u << sl);
+	if(slMap == 0) {
+		uint32_t flMap = fl + 1 < 32 ? heap->flBitmap & (~0u << (fl + 1)) : 0;
+		if(flMap == 0) return NULL;
+		fl = findFirstSet(flMap);
+		slMap = heap->slBitmaps[fl];
+	}
+	return heap->freeLists[fl][findFirstSet(slMap)];
+}
+
+/** splits the end of a used block off into a free block if it's big enough. */
+static void trimBlock(DCmemTlsf *heap, Block *block, size_t size) {
+	size_t blockSize = BLOCK_SIZE(block);
+	if(blockSize < size + BLOCK_HEADER_SIZE + BLOCK_MIN_SIZE) return;
+
+	Block *rest = (Block *)(BLOCK_MEMORY(block) + size);
+	rest->prevPhys = block;
+	rest->size = blockSize - size - BLOCK_HEADER_SIZE;
+	block->size = size | (block->size & FLAG_MASK);
+	NEXT_PHYS(rest)->prevPhys = rest;
+
+	// the block after the rest might be free, blocks are always merged so free blocks are never next to each other.
+	Block *next = NEXT_PHYS(rest);
+	if(next->size & FLAG_FREE) {
+		removeFree(heap, next);
+		rest->size += BLOCK_HEADER_SIZE + BLOCK_SIZE(next);
+		NEXT_PHYS(rest)->prevPhys = rest;
+	}
+	insertFree(heap, rest);
+}
+
+static bool addPool(DCmemTlsf *heap) {
+	Pool *pool = dcmemiMapPages(DCMEM_TLSF_POOL_SIZE, DCMEM_TLSF_POOL_SIZE);
+	if(pool == NULL) return false;
+	pool->heap = heap;
+	pool->next = heap->pools;
+	heap->pools = pool;
+	heap->poolBytes += DCMEM_TLSF_POOL_SIZE;
+
+	// one free block spanning the pool, followed by an empty used block that stops merging at the end.
+	Block *block = (Block *)((uint8_t *)pool + POOL_HEADER_SIZE);
+	block->prevPhys = NULL;
+	block->size = DCMEM_TLSF_POOL_SIZE - POOL_HEADER_SIZE - 2 * BLOCK_HEADER_SIZE;
+	Block *sentinel = NEXT_PHYS(block);
+	sentinel->prevPhys = block;
+	sentinel->size = 0;
+	insertFree(heap, block);
+	return true;
+}
+
+static size_t adjustSize(size_t size) {
+	size = (size + ALIGN_SIZE - 1) & ~(size_t)(ALIGN_SIZE - 1);
+	return size < BLOCK_MIN_SIZE ? BLOCK_MIN_SIZE : size;
+}
+
+static void *allocateLarge(size_t size) {
+	Block *block = dcmemiMapPages(BLOCK_HEADER_SIZE + size, ALIGN_SIZE);
+	if(block == NULL) return NULL;
+	block->size = adjustSize(size) | FLAG_LARGE;
+	largeBytes += BLOCK_SIZE(block);
+	return BLOCK_MEMORY(block);
+}
+
+static void deallocateLarge(Block *block) {
+	largeBytes -= BLOCK_SIZE(block);
+	dcmemiUnmapPages(block, BLOCK_HEADER_SIZE + BLOCK_SIZE(block));
+}
+
+DCmemTlsf *dcmemNewTlsf() {
+	DCmemTlsf *heap = calloc(1, sizeof(DCmemTlsf));
+	DC_RVASSERT(heap != NULL, "Failed to allocate a TLSF heap", NULL);
+	pthread_mutex_init(&heap->mutex, NULL);
+	return heap;
+}
+
+void dcmemFreeTlsf(DCmemTlsf *heap) {
+	Pool *pool = heap->pools;
+	while(pool != NULL) {
+		Pool *next = pool->next;
+		dcmemiUnmapPages(pool, DCMEM_TLSF_POOL_SIZE);
+		pool = next;
+	}
+
+	pthread_mutex_destroy(&heap->mutex);
+	free(heap);
+}
+
+void *dcmemTlsfAllocate(DCmemTlsf *heap, size_t size) {
+	size = adjustSize(size);
+	if(size > DCMEM_TLSF_LARGE_SIZE) return allocateLarge(size);
+
+	pthread_mutex_lock(&heap->mutex);
+	Block *block = findFree(heap, size);
+	if(block == NULL && addPool(heap)) block = findFree(heap, size);
+	if(block == NULL) {
+		pthread_mutex_unlock(&heap->mutex);
+		return NULL;
+	}
+
+	removeFree(heap, block);
+	trimBlock(heap, block, size);
+	heap->usedBytes += BLOCK_SIZE(block);
+	pthread_mutex_unlock(&heap->mutex);
+	return BLOCK_MEMORY(block);
+}
+
+void dcmemTlsfDeallocate(void *pointer) {
+	if(pointer == NULL) return;
+	Block *block = MEMORY_BLOCK(pointer);
+	if(block->size & FLAG_LARGE) {
+		deallocateLarge(block);
+		return;
+	}
+
+	DCmemTlsf *heap = POOL_OF(block)->heap;
+	pthread_mutex_lock(&heap->mutex);
+	heap->usedBytes -= BLOCK_SIZE(block);
+
+	if(block->prevPhys != NULL && (block->prevPhys->size & FLAG_FREE)) {
+		Block *prev = block->prevPhys;
+		removeFree(heap, prev);
+		prev->size += BLOCK_HEADER_SIZE + BLOCK_SIZE(block);
+		block = prev;
+	}
+
+	Block *next = NEXT_PHYS(block);
+	if(next->size & FLAG_FREE) {
+		removeFree(heap, next);
+		block->size += BLOCK_HEADER_SIZE + BLOCK_SIZE(next);
+	}
+
+	NEXT_PHYS(block)->prevPhys = block;
+	insertFree(heap, block);
+	pthread_mutex_unlock(&heap->mutex);
+}
+
+void *dcmemTlsfReallocate(DCmemTlsf *heap, void *pointer, size_t size) {
+	if(pointer == NULL) return dcmemTlsfAllocate(heap, size);
+	if(size == 0) {
+		dcmemTlsfDeallocate(pointer);
+		return NULL;
+	}
+
+	Block *block = MEMORY_BLOCK(pointer);
+	size_t oldSize = BLOCK_SIZE(block);
+	size_t adjusted = adjustSize(size);
+	if(!(block->size & FLAG_LARGE) && adjusted <= DCMEM_TLSF_LARGE_SIZE) {
+		// grow into the next block if it's free, shrink by splitting the end off.
+		DCmemTlsf *owner = POOL_OF(block)->heap;
+		pthread_mutex_lock(&owner->mutex);
+		Block *next = NEXT_PHYS(block);
+		if(adjusted > oldSize && (next->size & FLAG_FREE) && oldSize + BLOCK_HEADER_SIZE + BLOCK_SIZE(next) >= adjusted) {
+			removeFree(owner, next);
+			block->size += BLOCK_HEADER_SIZE + BLOCK_SIZE(next);
+			NEXT_PHYS(block)->prevPhys = block;
+		}
+
+		if(adjusted <= BLOCK_SIZE(block)) {
+			trimBlock(owner, block, adjusted);
+			owner->usedBytes += BLOCK_SIZE(block) - oldSize;
+			pthread_mutex_unlock(&owner->mutex);
+			return pointer;
+		}
+		pthread_mutex_unlock(&owner->mutex);
+	}
+
+	void *moved = dcmemTlsfAllocate(heap, size);
+	if(moved == NULL) return NULL;
+	memcpy(moved, pointer, oldSize < adjusted ? oldSize : adjusted);
+	dcmemTlsfDeallocate(pointer);
+	return moved;
+}
+
+DCmemTlsfStats dcmemGetTlsfStats(DCmemTlsf *heap) {
+	pthread_mutex_lock(&heap->mutex);
+	DCmemTlsfStats stats = { .usedBytes = heap->usedBytes, .poolBytes = heap->poolBytes, .largeBytes = largeBytes };
+	pthread_mutex_unlock(&heap->mutex);
+	return stats;
+}
+
+static DCmemTlsf *defaultHeap;
+static pthread_once_t defaultHeapOnce = PTHREAD_ONCE_INIT;
+static _Thread_local DCmemTlsf *threadHeap;
+
+static void createDefaultHeap() { defaultHeap = dcmemNewTlsf(); }
+
+void dcmemSetThreadHeap(DCmemTlsf *heap) { threadHeap = heap; }
+
+DCmemTlsf *dcmemGetThreadHeap() {
+	if(threadHeap != NULL) return threadHeap;
+	pthread_once(&defaultHeapOnce, &createDefaultHeap);
+	return defaultHeap;
+}
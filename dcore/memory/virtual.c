@@ -0,0 +1,154 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, madvise
+#include <dcore/memory.h>
+#include <dcore/memory/internal.h>
+#include <dcore/common.h>
+
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <unistd.h>
+#	if !defined(MAP_ANONYMOUS)
+#		define MAP_ANONYMOUS MAP_ANON
+#	endif
+#endif
+
+static size_t roundUp(size_t value, size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+static size_t getPageSize() {
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+static void *reserve(size_t size, size_t alignment) {
+#if defined(_WIN32)
+	// ranges can't be partially released, reserve more to find an aligned address and reserve again there.
+	for(;;) {
+		uint8_t *mapping = VirtualAlloc(NULL, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+		if(mapping == NULL) return NULL;
+		uint8_t *aligned = (uint8_t *)roundUp((uintptr_t)mapping, alignment);
+		VirtualFree(mapping, 0, MEM_RELEASE);
+		if((mapping = VirtualAlloc(aligned, size, MEM_RESERVE, PAGE_NOACCESS)) != NULL) return mapping;
+	}
+#else
+	// reserve more and unmap the unaligned head and tail.
+	uint8_t *mapping = mmap(NULL, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(mapping == MAP_FAILED) return NULL;
+
+	uint8_t *aligned = (uint8_t *)roundUp((uintptr_t)mapping, alignment);
+	if(aligned != mapping) munmap(mapping, aligned - mapping);
+	if(alignment - (aligned - mapping) != 0) munmap(aligned + size, alignment - (aligned - mapping));
+	return aligned;
+#endif
+}
+
+static bool commit(uint8_t *address, size_t size) {
+#if defined(_WIN32)
+	return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void decommit(uint8_t *address, size_t size) {
+#if defined(_WIN32)
+	VirtualFree(address, size, MEM_DECOMMIT);
+#else
+	madvise(address, size, MADV_DONTNEED);
+	mprotect(address, size, PROT_NONE);
+#endif
+}
+
+void dcmemInitVirtualArena(DCmemArena *arena, size_t reserveSize, size_t highWaterMark, unsigned int flags) {
+	size_t pageSize = getPageSize();
+	*arena = (DCmemArena){ 0 };
+	arena->type = DCMEM_ARENA_TYPE_VIRTUAL;
+	arena->flags = flags;
+	arena->step = roundUp(DCMEM_VIRTUAL_ARENA_DEFAULT_STEP, pageSize);
+	if(flags & DCMEM_ARENA_FLAG_HUGE_PAGES) arena->step = roundUp(arena->step, DCMEM_HUGE_PAGE_SIZE);
+	arena->reserved = roundUp(reserveSize, arena->step);
+	arena->highWaterMark = roundUp(highWaterMark, arena->step);
+
+	arena->base = reserve(arena->reserved, (flags & DCMEM_ARENA_FLAG_HUGE_PAGES) ? DCMEM_HUGE_PAGE_SIZE : pageSize);
+	if(arena->base == NULL) {
+		DCD_FATAL("Failed to reserve %zu bytes of address space for a virtual arena.", arena->reserved);
+		arena->reserved = 0;
+		return;
+	}
+
+#if defined(MADV_HUGEPAGE)
+	if(flags & DCMEM_ARENA_FLAG_HUGE_PAGES) {
+		if(madvise(arena->base, arena->reserved, MADV_HUGEPAGE) != 0) DCD_WARNING("Huge pages aren't available for the virtual arena.");
+	}
+#endif
+}
+
+void *dcmemiPushVirtual(DCmemArena *arena, size_t size, size_t alignment) {
+	// the base is only page aligned, larger alignments have to be applied to the address.
+	uintptr_t address = (uintptr_t)(arena->base + arena->top);
+	size_t offset = arena->top + (size_t)(roundUp(address, alignment) - address);
+	if(offset + size > arena->reserved) {
+		DCD_FATAL("Virtual arena is out of reserved memory (%zu bytes, pushed %zu).", arena->reserved, arena->top);
+		return NULL;
+	}
+
+	if(offset + size > arena->size) {
+		size_t committed = roundUp(offset + size, arena->step);
+		if(!commit(arena->base + arena->size, committed - arena->size)) {
+			DCD_FATAL("Failed to commit %zu bytes of a virtual arena.", committed - arena->size);
+			return NULL;
+		}
+
+		arena->size = committed;
+	}
+
+	arena->top = offset + size;
+	return arena->base + offset;
+}
+
+void dcmemiTrimVirtual(DCmemArena *arena) {
+	size_t keep = roundUp(arena->top > arena->highWaterMark ? arena->top : arena->highWaterMark, arena->step);
+	if(arena->size <= keep) return;
+
+	decommit(arena->base + keep, arena->size - keep);
+	arena->size = keep;
+}
+
+void *dcmemiMapPages(size_t size, size_t alignment) {
+	size_t pageSize = getPageSize();
+	size = roundUp(size, pageSize);
+	uint8_t *pages = reserve(size, alignment > pageSize ? alignment : pageSize);
+	if(pages == NULL) return NULL;
+	if(!commit(pages, size)) {
+		dcmemiUnmapPages(pages, size);
+		return NULL;
+	}
+	return pages;
+}
+
+void dcmemiUnmapPages(void *pages, size_t size) {
+#if defined(_WIN32)
+	(void)size;
+	VirtualFree(pages, 0, MEM_RELEASE);
+#else
+	munmap(pages, roundUp(size, getPageSize()));
+#endif
+}
+
+void dcmemiFreeVirtual(DCmemArena *arena) {
+	if(arena->base != NULL) {
+#if defined(_WIN32)
+		VirtualFree(arena->base, 0, MEM_RELEASE);
+#else
+		munmap(arena->base, arena->reserved);
+#endif
+	}
+
+	arena->base = NULL;
+	arena->size = arena->top = arena->reserved = 0;
+}
@@ -1,7 +1,7 @@
 #include <dcore/graphics/internal.h>
 #include <dcore/renderers/basic.h>
 
-void dcgBasicRendererCreateInfo(DCgState *state) {
+void dcgBasicRendererCreateInfo(DCgState *state, DCgBasicRendererInfo *info) {
 	VkAttachmentDescription attachments[2] = {
 		(VkAttachmentDescription){
 		                          .format = state->surfaceFormat.format,
@@ -60,7 +60,8 @@ void dcgBasicRendererCreateInfo(DCgState *state) {
 
 	dcgiAddRenderPass(state, 2, attachments, 1, subpasses, 1, dependencies);
 
-	VkDescriptorSetLayout *setLayouts = dcgiAddDescriptorSetLayouts(state, 2);
+	VkDescriptorSetLayout *setLayouts;
+	info->descriptorSets = dcgiAddDescriptorSetLayouts(state, 2, &setLayouts);
 
 	VkDescriptorSetLayoutBinding setLayoutBindings[] = {
 		(VkDescriptorSetLayoutBinding){.binding = 0,
@@ -97,7 +98,8 @@ void dcgBasicRendererCreateInfo(DCgState *state) {
 		);
 	}
 
-	VkPushConstantRange *ranges = dcgiAddPushConstantRanges(state, DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_ENUM_MAX);
+	VkPushConstantRange *ranges;
+	info->pushConstants = dcgiAddPushConstantRanges(state, DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_ENUM_MAX, &ranges);
 	ranges[DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_BASE].offset = 0;
 	ranges[DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_BASE].size = sizeof(DCgBasicRendererUniformBuffer);
 	ranges[DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_BASE].stageFlags = VK_SHADER_STAGE_ALL;
@@ -105,7 +107,9 @@ void dcgBasicRendererCreateInfo(DCgState *state) {
 	ranges[DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_TRANSFORM].size = sizeof(DCgBasicRendererTransformUniformBuffer);
 	ranges[DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_TRANSFORM].stageFlags = VK_SHADER_STAGE_ALL;
 
-	VkVertexInputAttributeDescription *attributes = dcgiAddVertexAttributes(state, 3);
+	VkVertexInputBindingDescription *bindings;
+	VkVertexInputAttributeDescription *attributes;
+	info->vertexInput = dcgiAddVertexInput(state, 1, &bindings, 3, &attributes);
 	attributes[DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_POSITION].binding = 0;
 	attributes[DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_POSITION].format = VK_FORMAT_R32G32B32_SFLOAT;
 	attributes[DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_POSITION].location = 0;
@@ -121,7 +125,6 @@ void dcgBasicRendererCreateInfo(DCgState *state) {
 	attributes[DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_TEXCOORDS].location = 2;
 	attributes[DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_TEXCOORDS].offset = sizeof(DCmVector3f) + sizeof(DCmVector3f);
 
-	VkVertexInputBindingDescription *bindings = dcgiAddVertexBindings(state, 1);
 	bindings[0].binding = 0;
 	bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 	bindings[0].stride = sizeof(DCgBasicRendererVertex);
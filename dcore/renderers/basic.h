@@ -4,8 +4,13 @@
 #include <dcore/graphics.h>
 #include <dcore/math.h>
 
+/** handles of the layouts registered by the basic renderer, to be used in DCgMaterialOptions. */
+typedef struct DCgBasicRendererInfo {
+	DCmemHandle pushConstants, descriptorSets, vertexInput;
+} DCgBasicRendererInfo;
+
 /** creates basic rendering privitives and sets basic settings. */
-void dcgBasicRendererCreateInfo(DCgState *state);
+void dcgBasicRendererCreateInfo(DCgState *state, DCgBasicRendererInfo *info);
 
 typedef enum DCgBasicRendererVertexAttribute {
 	DCG_BASIC_RENDERER_VERTEX_ATTRIBUTE_POSITION,
@@ -19,6 +24,20 @@ typedef struct DCgBasicRendererVertex {
 	DCmVector2 texcoords;
 } DCgBasicRendererVertex;
 
+/**
+ * half the size of DCgBasicRendererVertex. positions and texcoords are halfs, so meshes should be modeled around
+ * their origin (halfs keep 11 significant bits). the normal is octahedral encoded (see DCmVector3fFromOctahedral).
+ * @note there is no vertex input for it yet, it needs a vertex shader that decodes the normal.
+ **/
+typedef struct DCgBasicRendererPackedVertex {
+	uint16_t position[4]; // w is 1.
+	int16_t normal[2];
+	uint16_t texcoords[2];
+} DCgBasicRendererPackedVertex;
+
+/** converts vertices to the packed format, eight at a time with AVX2 and F16C. */
+void dcgBasicRendererPackVertices(DCgBasicRendererPackedVertex *dst, const DCgBasicRendererVertex *src, size_t count);
+
 typedef enum DCgBasicRendererPushConstantRange {
 	DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_BASE = 0,
 	DCG_BASIC_RENDERER_PUSH_CONSTANT_RANGE_TRANSFORM,
@@ -0,0 +1,98 @@
+#include <dcore/math/simd.h>
+#include <dcore/math/pack.h>
+#include <dcore/renderers/basic.h>
+
+#define HALF_ONE 0x3c00
+
+static void packVertexScalar(DCgBasicRendererPackedVertex *dst, const DCgBasicRendererVertex *src) {
+	for(int a = 0; a < 3; ++a)
+		dst->position[a] = DCmFloatToHalf(src->position[a]);
+	dst->position[3] = HALF_ONE;
+	DCmVector3fToOctahedral(dst->normal, src->normal);
+	dst->texcoords[0] = DCmFloatToHalf(src->texcoords[0]);
+	dst->texcoords[1] = DCmFloatToHalf(src->texcoords[1]);
+}
+
+#if defined(DCM_X86)
+/** a vertex is eight floats, so eight vertices are an 8x8 matrix that is transposed into one register per component. */
+DCM_TARGET("avx2,fma,f16c") static inline void transpose8(__m256 rows[8]) {
+	__m256 a0 = _mm256_unpacklo_ps(rows[0], rows[1]), a1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+	__m256 a2 = _mm256_unpacklo_ps(rows[2], rows[3]), a3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+	__m256 a4 = _mm256_unpacklo_ps(rows[4], rows[5]), a5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+	__m256 a6 = _mm256_unpacklo_ps(rows[6], rows[7]), a7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+	__m256 b0 = _mm256_shuffle_ps(a0, a2, _MM_SHUFFLE(1, 0, 1, 0)), b1 = _mm256_shuffle_ps(a0, a2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 b2 = _mm256_shuffle_ps(a1, a3, _MM_SHUFFLE(1, 0, 1, 0)), b3 = _mm256_shuffle_ps(a1, a3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 b4 = _mm256_shuffle_ps(a4, a6, _MM_SHUFFLE(1, 0, 1, 0)), b5 = _mm256_shuffle_ps(a4, a6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 b6 = _mm256_shuffle_ps(a5, a7, _MM_SHUFFLE(1, 0, 1, 0)), b7 = _mm256_shuffle_ps(a5, a7, _MM_SHUFFLE(3, 2, 3, 2));
+	rows[0] = _mm256_permute2f128_ps(b0, b4, 0x20), rows[4] = _mm256_permute2f128_ps(b0, b4, 0x31);
+	rows[1] = _mm256_permute2f128_ps(b1, b5, 0x20), rows[5] = _mm256_permute2f128_ps(b1, b5, 0x31);
+	rows[2] = _mm256_permute2f128_ps(b2, b6, 0x20), rows[6] = _mm256_permute2f128_ps(b2, b6, 0x31);
+	rows[3] = _mm256_permute2f128_ps(b3, b7, 0x20), rows[7] = _mm256_permute2f128_ps(b3, b7, 0x31);
+}
+
+/** same steps as DCmVector3fToOctahedral, x and y become snorm16. */
+DCM_TARGET("avx2,fma,f16c") static inline void octahedral8(__m256 nx, __m256 ny, __m256 nz, __m128i *x, __m128i *y) {
+	__m256 sign = _mm256_set1_ps(-0.0f), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+	__m256 length = _mm256_add_ps(_mm256_add_ps(_mm256_andnot_ps(sign, nx), _mm256_andnot_ps(sign, ny)), _mm256_andnot_ps(sign, nz));
+	__m256 inverse = _mm256_and_ps(_mm256_div_ps(one, length), _mm256_cmp_ps(length, zero, _CMP_GT_OQ));
+	__m256 ox = _mm256_mul_ps(nx, inverse), oy = _mm256_mul_ps(ny, inverse);
+	__m256 foldedX = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, oy)), _mm256_or_ps(_mm256_and_ps(ox, sign), one));
+	__m256 foldedY = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(sign, ox)), _mm256_or_ps(_mm256_and_ps(oy, sign), one));
+	__m256 lower = _mm256_cmp_ps(nz, zero, _CMP_LT_OQ);
+	ox = _mm256_blendv_ps(ox, foldedX, lower);
+	oy = _mm256_blendv_ps(oy, foldedY, lower);
+
+	__m256 scale = _mm256_set1_ps(32767.0f);
+	__m256i ix = _mm256_cvtps_epi32(_mm256_mul_ps(ox, scale)), iy = _mm256_cvtps_epi32(_mm256_mul_ps(oy, scale));
+	*x = _mm_packs_epi32(_mm256_castsi256_si128(ix), _mm256_extracti128_si256(ix, 1));
+	*y = _mm_packs_epi32(_mm256_castsi256_si128(iy), _mm256_extracti128_si256(iy, 1));
+}
+
+DCM_TARGET("avx2,fma,f16c") static void packVerticesAvx2(DCgBasicRendererPackedVertex *dst, const DCgBasicRendererVertex *src, size_t count) {
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8) {
+		__m256 rows[8];
+		for(int v = 0; v < 8; ++v)
+			rows[v] = _mm256_loadu_ps((const float *)(src + i + v));
+		transpose8(rows);
+
+		// one register of eight 16 bit values per packed component, then transposed back to vertices.
+		__m128i columns[8];
+		for(int c = 0; c < 3; ++c)
+			columns[c] = _mm256_cvtps_ph(rows[c], _MM_FROUND_TO_NEAREST_INT);
+		columns[3] = _mm_set1_epi16(HALF_ONE);
+		octahedral8(rows[3], rows[4], rows[5], &columns[4], &columns[5]);
+		columns[6] = _mm256_cvtps_ph(rows[6], _MM_FROUND_TO_NEAREST_INT);
+		columns[7] = _mm256_cvtps_ph(rows[7], _MM_FROUND_TO_NEAREST_INT);
+
+		__m128i a[8], b[8];
+		for(int c = 0; c < 8; c += 2) {
+			a[c] = _mm_unpacklo_epi16(columns[c], columns[c + 1]);
+			a[c + 1] = _mm_unpackhi_epi16(columns[c], columns[c + 1]);
+		}
+		for(int c = 0; c < 8; c += 4) {
+			b[c] = _mm_unpacklo_epi32(a[c], a[c + 2]);
+			b[c + 1] = _mm_unpackhi_epi32(a[c], a[c + 2]);
+			b[c + 2] = _mm_unpacklo_epi32(a[c + 1], a[c + 3]);
+			b[c + 3] = _mm_unpackhi_epi32(a[c + 1], a[c + 3]);
+		}
+		for(int v = 0; v < 4; ++v) {
+			_mm_storeu_si128((__m128i *)(dst + i + v * 2), _mm_unpacklo_epi64(b[v], b[v + 4]));
+			_mm_storeu_si128((__m128i *)(dst + i + v * 2 + 1), _mm_unpackhi_epi64(b[v], b[v + 4]));
+		}
+	}
+	for(; i < count; ++i)
+		packVertexScalar(dst + i, src + i);
+}
+#endif
+
+void dcgBasicRendererPackVertices(DCgBasicRendererPackedVertex *dst, const DCgBasicRendererVertex *src, size_t count) {
+#if defined(DCM_X86)
+	if(dcmGetSimdLevel() >= DCM_SIMD_LEVEL_AVX2) {
+		packVerticesAvx2(dst, src, count);
+		return;
+	}
+#endif
+	for(size_t i = 0; i < count; ++i)
+		packVertexScalar(dst + i, src + i);
+}
@@ -0,0 +1,114 @@
+#define _DEFAULT_SOURCE // mkstemp, usleep
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define THREAD_COUNT 4
+#define MESSAGE_COUNT 2000
+
+static void *logMessages(void *data) {
+	for(int i = 0; i < MESSAGE_COUNT; ++i)
+		DCD_MSGF(INFO, "async message %d from thread %d", i, (int)(uintptr_t)data);
+	return NULL;
+}
+
+/** counts the messages written to sink, which is rewound. */
+static size_t countMessages(FILE *sink, const char *text) {
+	rewind(sink);
+	char line[1024];
+	size_t count = 0;
+	while(fgets(line, sizeof(line), sink) != NULL)
+		for(const char *found = line; (found = strstr(found, text)) != NULL; ++found)
+			++count;
+	return count;
+}
+
+static size_t logFromThreads(DCdAsyncPolicy policy, FILE *sink) {
+	dcdRemoveSink(stdout);
+	dcdAddSink(sink);
+	dcdStartAsync(64, policy);
+	pthread_t threads[THREAD_COUNT];
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_create(&threads[t], NULL, logMessages, (void *)(uintptr_t)t);
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_join(threads[t], NULL);
+	dcdFlush();
+	size_t dropped = dcdGetDroppedMessages();
+	dcdStopAsync();
+	dcdRemoveSink(sink);
+	dcdAddSink(stdout);
+	return dropped;
+}
+
+DCT_TEST(asyncLogging, "asynchronous logging keeps or counts every message") {
+	FILE *sink = tmpfile();
+	DCT_ASSERT(logFromThreads(DCD_ASYNC_POLICY_BLOCK, sink) == 0, "blocking never drops");
+	DCT_ASSERT(countMessages(sink, "async message") == THREAD_COUNT * MESSAGE_COUNT, "every message was written");
+	fclose(sink);
+
+	sink = tmpfile();
+	size_t dropped = logFromThreads(DCD_ASYNC_POLICY_DROP, sink);
+	size_t written = countMessages(sink, "async message");
+	DCD_MSGF(INFO, "%zu messages written, %zu dropped", written, dropped);
+	DCT_ASSERT(written + dropped == THREAD_COUNT * MESSAGE_COUNT, "messages are either written or dropped");
+	fclose(sink);
+	return 0;
+}
+
+DCT_TEST(asyncWakeup, "the logging thread writes a single message without a flush") {
+	char path[] = "/tmp/dcd-wakeup-XXXXXX";
+	int fd = mkstemp(path);
+	DCT_ASSERT(fd >= 0, "created the sink file");
+	FILE *sink = fdopen(fd, "w"), *reader = fopen(path, "r");
+	dcdRemoveSink(stdout);
+	dcdAddSink(sink);
+	dcdStartAsync(1024, DCD_ASYNC_POLICY_BLOCK);
+
+	// far below any threshold, the producer has to wake the sleeping thread. the file is read through its own stream.
+	DCD_MSGF(INFO, "single async message");
+	size_t written = 0;
+	for(int i = 0; i < 2000 && written == 0; ++i) {
+		usleep(1000);
+		written = countMessages(reader, "single async message");
+	}
+
+	dcdStopAsync();
+	dcdRemoveSink(sink);
+	dcdAddSink(stdout);
+	fclose(reader);
+	fclose(sink);
+	unlink(path);
+	DCT_ASSERT(written == 1, "the message was written within two seconds");
+	return 0;
+}
+
+static FILE *fatalSink;
+static size_t writtenBeforeFatal;
+
+static void countingFatalHandler() { writtenBeforeFatal = countMessages(fatalSink, "before fatal"); }
+
+DCT_TEST(asyncLoggingFatal, "fatal messages flush the asynchronous ring") {
+	fatalSink = tmpfile();
+	dcdAddSink(fatalSink);
+	dcdStartAsync(1024, DCD_ASYNC_POLICY_DROP);
+
+	// the fatal message is counted in its own context, so the test itself doesn't fail.
+	DCdFatalHandler previous = dcdGetFatalHandler();
+	dcdSetFatalHandler(countingFatalHandler);
+	DCD_PUSH_CONTEXT("fatal");
+	for(int i = 0; i < 100; ++i)
+		DCD_MSGF(DEBUG, "before fatal %d", i);
+	DCD_MSGF(FATAL, "expected fatal message");
+	DCD_POP_CONTEXT();
+	dcdSetFatalHandler(previous);
+
+	dcdStopAsync();
+	dcdRemoveSink(fatalSink);
+	fclose(fatalSink);
+	DCT_ASSERT(writtenBeforeFatal == 100, "messages before the fatal one were written when the handler ran");
+	return 0;
+}
@@ -0,0 +1,86 @@
+#define _DEFAULT_SOURCE // mkstemp
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/debug/binary.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define THREAD_COUNT 2
+#define MESSAGE_COUNT 5000
+
+static void *logMessages(void *data) {
+	for(int i = 0; i < MESSAGE_COUNT; ++i)
+		DCD_MSGF(DEBUG, "binary message %d from thread %s", i, data == NULL ? "main" : "worker");
+	return NULL;
+}
+
+/** counts the lines of sink that contain text, sink is rewound. */
+static size_t countLines(FILE *sink, const char *text) {
+	rewind(sink);
+	char line[2048];
+	size_t count = 0;
+	while(fgets(line, sizeof(line), sink) != NULL)
+		if(strstr(line, text) != NULL) ++count;
+	return count;
+}
+
+DCT_TEST(binaryLog, "binary log records decode to the text layout") {
+	char path[] = "/tmp/dcd-binary-XXXXXX";
+	int fd = mkstemp(path);
+	DCT_ASSERT(fd >= 0, "created a temporary file");
+	close(fd);
+
+	DCT_ASSERT(dcdOpenBinarySink(path), "opened the binary log");
+	DCD_PUSH_CONTEXT("binary");
+	DCD_MSGF(
+	  INFO, "int %d unsigned %u long %ld size %zu hex %#llx double %.3f string '%s' null '%s' percent %% width [%*d] precision [%.*f]", -42, 42u,
+	  -1234567890123l, (size_t)123456789012u, 0xdeadbeefull, 3.25, "hello", (const char *)NULL, 5, 7, 2, 2.5
+	);
+	DCD_MSGF(WARNING, "no arguments");
+	pthread_t thread;
+	pthread_create(&thread, NULL, logMessages, (void *)1);
+	logMessages(NULL);
+	pthread_join(thread, NULL);
+	DCD_POP_CONTEXT();
+	dcdCloseBinarySink();
+
+	FILE *in = fopen(path, "rb"), *out = tmpfile();
+	bool valid = dcdDecodeBinaryLog(in, out);
+	fclose(in);
+	remove(path);
+	DCT_ASSERT(valid, "the log decodes");
+	DCT_ASSERT(
+	  countLines(
+	    out, "int -42 unsigned 42 long -1234567890123 size 123456789012 hex 0xdeadbeef double 3.250 string 'hello' null '(null)' percent % width "
+	         "[    7] precision [2.50]"
+	  ) == 1,
+	  "arguments are formatted like printf"
+	);
+	DCT_ASSERT(countLines(out, "WARN |     no arguments") == 1, "messages are indented by context");
+	DCT_ASSERT(countLines(out, "[ binary ]") == 2, "context separators are kept");
+	DCT_ASSERT(countLines(out, "from thread main") == MESSAGE_COUNT, "every message of the main thread was decoded");
+	DCT_ASSERT(countLines(out, "from thread worker") == MESSAGE_COUNT, "every message of the worker was decoded");
+	fclose(out);
+
+	in = tmpfile();
+	fputs("not a binary log", in);
+	rewind(in);
+	DCT_ASSERT(!dcdDecodeBinaryLog(in, stdout), "other files are rejected");
+	fclose(in);
+
+	// a callsite record with an id far beyond any program's callsites.
+	in = tmpfile();
+	fwrite(DCDI_BINARY_MAGIC, 1, DCDI_BINARY_MAGIC_SIZE, in);
+	uint32_t callsite[] = { DCDI_BINARY_MAX_CALLSITE_ID + 1, 1 };
+	uint16_t emptyStrings[3] = { 0 };
+	fputc(DCDI_RECORD_CALLSITE, in);
+	fwrite(callsite, 1, sizeof(callsite), in);
+	fwrite(emptyStrings, 1, sizeof(emptyStrings), in);
+	rewind(in);
+	DCT_ASSERT(!dcdDecodeBinaryLog(in, stdout), "callsite ids beyond the bound are rejected");
+	fclose(in);
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define THREAD_COUNT 4
+#define DEPTH 5
+#define ROUNDS 50
+
+/** every thread nests contexts and logs at each depth, interleaving with the other threads. */
+static void *logNested(void *data) {
+	int thread = (int)(uintptr_t)data;
+	for(int round = 0; round < ROUNDS; ++round) {
+		for(int depth = 1; depth <= DEPTH; ++depth) {
+			dcdPushContextQuiet("nested");
+			DCD_MSGF(INFO, "thread %d depth %d", thread, depth);
+		}
+		for(int depth = 1; depth <= DEPTH; ++depth)
+			dcdPopContextQuiet();
+	}
+	return NULL;
+}
+
+DCT_TEST(threadContexts, "context stacks are per thread") {
+	DCdContext *context = dcdPushContextQuiet("threads");
+	DCdMsgStats before = dcdGetMsgStats();
+	FILE *sink = tmpfile();
+	dcdRemoveSink(stdout);
+	dcdAddSink(sink);
+	pthread_t threads[THREAD_COUNT];
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_create(&threads[t], NULL, logNested, (void *)(uintptr_t)t);
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_join(threads[t], NULL);
+	dcdRemoveSink(sink);
+	dcdAddSink(stdout);
+	DCdMsgStats after = dcdGetMsgStats();
+	bool untouched = dcdGetCurrentContext() == context && context->stats.total == 0;
+	dcdPopContextQuiet();
+
+	// threads start at their root context, so a message after n pushes is indented n times.
+	rewind(sink);
+	char line[1024];
+	size_t messages = 0;
+	bool indented = true;
+	while(fgets(line, sizeof(line), sink) != NULL) {
+		const char *text = strstr(line, "INFO | ");
+		int thread, depth;
+		if(text == NULL) continue;
+		text += strlen("INFO | ");
+		size_t indentation = strspn(text, " ");
+		indented = indented && sscanf(text + indentation, "thread %d depth %d", &thread, &depth) == 2 && indentation == 2 * (size_t)depth;
+		++messages;
+	}
+	fclose(sink);
+	DCT_ASSERT(messages == THREAD_COUNT * ROUNDS * DEPTH, "every message was written");
+	DCT_ASSERT(indented, "messages are indented by the contexts of their thread");
+	DCT_ASSERT(untouched, "other threads don't touch the contexts of this thread");
+	DCT_ASSERT(after.info - before.info == THREAD_COUNT * ROUNDS * DEPTH, "messages of exited threads are still counted");
+	return 0;
+}
+
+DCT_TEST(contextGrowth, "pushing and popping doesn't move a grown stack") {
+	const char *testName = dcdGetCurrentContext()->name;
+	DCdContext *first[64], *second[64];
+	for(int i = 0; i < 64; ++i)
+		first[i] = dcdPushContextQuiet("grown");
+	for(int i = 0; i < 64; ++i)
+		dcdPopContextQuiet();
+	// the stack grew while pushing the first time, so only the last pointer of the first round is still valid.
+	bool reused = true;
+	for(int i = 0; i < 64; ++i) {
+		second[i] = dcdPushContextQuiet("again");
+		reused = reused && second[i] == second[0] + i;
+	}
+	for(int i = 0; i < 64; ++i)
+		dcdPopContextQuiet();
+	DCT_ASSERT(reused && first[63] == second[63], "the stack is reused");
+	DCT_ASSERT(dcdGetCurrentContext()->name == testName, "pops return to the test context");
+	return 0;
+}
@@ -0,0 +1,81 @@
+// this file is built as if for release, so debug messages are compiled out.
+#define DCD_MIN_LEVEL DCD_LEVEL_INFO
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <string.h>
+
+/** counts the lines of sink that contain text, sink is rewound. */
+static size_t countLines(FILE *sink, const char *text) {
+	rewind(sink);
+	char line[1024];
+	size_t count = 0;
+	while(fgets(line, sizeof(line), sink) != NULL)
+		if(strstr(line, text) != NULL) ++count;
+	return count;
+}
+
+static int sideEffects;
+
+static int sideEffect() { return ++sideEffects; }
+
+DCT_TEST(compileTimeFilter, "messages below DCD_MIN_LEVEL are compiled out") {
+	DCdMsgStats before = dcdGetCurrentContext()->stats;
+	DCD_DEBUG("compiled out %d", sideEffect());
+	DCD_MSGF(DEBUG, "compiled out %d", sideEffect());
+	DCD_INFO("kept %d", sideEffect());
+	DCdMsgStats after = dcdGetCurrentContext()->stats;
+	DCT_ASSERT(sideEffects == 1, "arguments of removed messages aren't evaluated");
+	DCT_ASSERT(after.debug == before.debug && after.info == before.info + 1, "removed messages aren't counted");
+	return 0;
+}
+
+DCT_TEST(contextFilter, "context masks drop messages before they are counted") {
+	DCdContext *context = DCD_PUSH_CONTEXT("filtered");
+	context->mask = dcdGetLevelMask(DCD_LEVEL_WARNING);
+	DCD_INFO("dropped %d", sideEffect());
+	DCD_SUCCESS("dropped");
+	DCD_WARNING("kept");
+	dcdPushContextQuiet("inherited");
+	DCD_INFO("dropped");
+	bool inherited = dcdGetCurrentContext()->mask == dcdGetLevelMask(DCD_LEVEL_WARNING) && dcdGetCurrentContext()->stats.total == 0;
+	dcdPopContextQuiet();
+	DCdMsgStats stats = dcdGetCurrentContext()->stats;
+	DCD_POP_CONTEXT();
+	DCT_ASSERT(stats.total == 1 && stats.warning == 1, "only the warning was counted");
+	DCT_ASSERT(inherited, "pushed contexts inherit the mask");
+	DCT_ASSERT(dcdGetLevelMask(DCD_LEVEL_INFO) == (DCD_MSG_MASK_ALL & ~DCD_MSG_MASK(DEBUG)), "success messages are info level");
+	return 0;
+}
+
+static bool onlyThisFile(void *user, const DCdMsgInfo *msg) {
+	++*(int *)user;
+	return strcmp(msg->file, __FILE__) == 0;
+}
+
+DCT_TEST(sinkFilter, "sinks get the messages their mask and predicate accept") {
+	FILE *errors = tmpfile(), *filtered = tmpfile();
+	int predicateCalls = 0;
+	dcdAddSink(errors);
+	dcdAddSink(filtered);
+	dcdSetSinkFilter(errors, DCD_MSG_MASK(ERROR) | DCD_MSG_MASK(FATAL), NULL, NULL);
+	dcdSetSinkFilter(filtered, DCD_MSG_MASK_ALL, onlyThisFile, &predicateCalls);
+
+	// the error is counted in its own context, so the test itself doesn't fail.
+	DCD_PUSH_CONTEXT("sinks");
+	DCD_INFO("sink info");
+	DCD_WARNING("sink warning");
+	DCD_ERROR("sink error");
+	dcdMsgF(DCD_MSG_TYPE_INFO, "elsewhere.c", "elsewhere", 1, "sink elsewhere");
+	DCD_POP_CONTEXT();
+
+	dcdRemoveSink(errors);
+	dcdRemoveSink(filtered);
+	DCT_ASSERT(countLines(errors, "sink ") == 1 && countLines(errors, "sink error") == 1, "the error sink only got the error");
+	DCT_ASSERT(countLines(filtered, "sink ") == 3 && countLines(filtered, "sink elsewhere") == 0, "the predicate rejected the other file");
+	DCT_ASSERT(countLines(errors, "[ sinks ]") == 0 && countLines(filtered, "[ sinks ]") == 2, "context separators are info messages");
+	DCT_ASSERT(predicateCalls == 6, "the predicate saw every message of its types");
+	fclose(errors);
+	fclose(filtered);
+	return 0;
+}
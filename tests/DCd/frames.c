@@ -0,0 +1,69 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <string.h>
+
+#define FRAME_COUNT 100
+
+static void recordFrame(uint64_t cpuNs, uint64_t draws) {
+	uint64_t values[DCD_FRAME_STAT_COUNT] = { [DCD_FRAME_STAT_CPU_NS] = cpuNs, [DCD_FRAME_STAT_DRAWS] = draws };
+	dcdRecordFrame(values);
+}
+
+DCT_TEST(frameStatPercentiles, "frame stats are percentiles of the frames in the ring") {
+	dcdStartFrameStats(FRAME_COUNT);
+	DCdFrameStatSummary summary = dcdGetFrameStatSummary(DCD_FRAME_STAT_CPU_NS);
+	DCT_ASSERT(summary.frames == 0 && summary.max == 0, "no frames before the first one is recorded");
+
+	// recorded backwards, so the percentiles don't depend on the order.
+	for(uint64_t i = FRAME_COUNT; i > 0; --i)
+		recordFrame(i * 1000000, 3);
+	summary = dcdGetFrameStatSummary(DCD_FRAME_STAT_CPU_NS);
+	DCT_ASSERT(summary.frames == FRAME_COUNT, "every frame is in the ring");
+	DCT_ASSERT(summary.p50 == 50000000 && summary.p95 == 95000000 && summary.p99 == 99000000, "percentiles are nearest ranks");
+	DCT_ASSERT(summary.max == 100000000, "max is the slowest frame");
+	summary = dcdGetFrameStatSummary(DCD_FRAME_STAT_DRAWS);
+	DCT_ASSERT(summary.p50 == 3 && summary.max == 3, "every stat has its own percentiles");
+
+	// two slow frames replace the oldest ones (100 and 99 ms), they only show above p95.
+	recordFrame(500000000, 3);
+	recordFrame(500000000, 3);
+	summary = dcdGetFrameStatSummary(DCD_FRAME_STAT_CPU_NS);
+	DCT_ASSERT(summary.frames == FRAME_COUNT, "the ring keeps its capacity");
+	DCT_ASSERT(summary.p95 == 95000000 && summary.p99 == 500000000 && summary.max == 500000000, "slow frames show in p99 and max");
+
+	size_t buckets[10], total = 0;
+	uint64_t width = dcdGetFrameStatHistogram(DCD_FRAME_STAT_CPU_NS, buckets, 10);
+	for(int b = 0; b < 10; ++b)
+		total += buckets[b];
+	DCT_ASSERT(width == 50000001, "the buckets cover the slowest frame");
+	DCT_ASSERT(total == FRAME_COUNT && buckets[9] == 2, "every frame is in a bucket, the slow ones in the last");
+
+	dcdStopFrameStats();
+	recordFrame(1, 1);
+	DCT_ASSERT(dcdGetFrameStatSummary(DCD_FRAME_STAT_CPU_NS).frames == 0, "frames aren't recorded once stopped");
+	return 0;
+}
+
+DCT_TEST(frameStatCsv, "frame stats are written as CSV, oldest frame first") {
+	dcdStartFrameStats(4);
+	for(uint64_t i = 0; i < 6; ++i)
+		recordFrame(i, i * 2);
+	FILE *file = tmpfile();
+	DCT_ASSERT(dcdWriteFrameStatsCsv(file), "CSV written");
+	rewind(file);
+	char line[256];
+	DCT_ASSERT(fgets(line, sizeof(line), file) != NULL, "header line");
+	DCT_ASSERT(strcmp(line, "frame,cpu_ns,wait_ns,draws,triangles,allocations\n") == 0, "header names the stats");
+	size_t lines = 0;
+	unsigned long long frame, cpuNs, waitNs, draws;
+	while(fgets(line, sizeof(line), file) != NULL) {
+		DCT_ASSERT(sscanf(line, "%llu,%llu,%llu,%llu", &frame, &cpuNs, &waitNs, &draws) == 4, "a line per frame");
+		DCT_ASSERT(frame == lines + 2 && cpuNs == frame && draws == frame * 2, "frames in order");
+		++lines;
+	}
+	DCT_ASSERT(lines == 4, "only the frames in the ring");
+	fclose(file);
+	dcdStopFrameStats();
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#define THREAD_COUNT 3
+#define ZONE_COUNT 100
+
+static void *profileJob(void *data) {
+	dcdGetCurrentContext()->profile = true;
+	dcdPushContextQuiet("job");
+	for(int i = 0; i < ZONE_COUNT; ++i) {
+		DCD_BEGIN_ZONE("job zone");
+		DCD_END_ZONE();
+	}
+	dcdPopContextQuiet();
+	return NULL;
+}
+
+/** counts the occurrences of text in file, which is rewound. */
+static size_t countText(FILE *file, const char *text) {
+	rewind(file);
+	char line[1024];
+	size_t count = 0;
+	while(fgets(line, sizeof(line), file) != NULL)
+		for(const char *found = line; (found = strstr(found, text)) != NULL; ++found)
+			++count;
+	return count;
+}
+
+static const DCdZoneSummary *findSummary(const DCdZoneSummary *summaries, size_t count, const char *name) {
+	for(size_t i = 0; i < count; ++i)
+		if(strcmp(summaries[i].name, name) == 0) return &summaries[i];
+	return NULL;
+}
+
+DCT_TEST(profileZones, "zones are recorded in profiled contexts only") {
+	dcdStartProfiling(1024);
+	DCD_BEGIN_ZONE("outside");
+	DCD_END_ZONE();
+
+	dcdMarkFrame();
+	dcdGetCurrentContext()->profile = true;
+	dcdPushContextQuiet("frame");
+	DCD_BEGIN_ZONE("outer");
+	for(int i = 0; i < 3; ++i) {
+		DCD_BEGIN_ZONE("inner");
+		DCD_END_ZONE();
+	}
+	// left open, ends with its context.
+	DCD_BEGIN_ZONE("open");
+	dcdPopContextQuiet();
+	dcdGetCurrentContext()->profile = false;
+	pthread_t threads[THREAD_COUNT];
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_create(&threads[t], NULL, profileJob, NULL);
+	for(int t = 0; t < THREAD_COUNT; ++t)
+		pthread_join(threads[t], NULL);
+	dcdMarkFrame();
+
+	DCdZoneSummary summaries[8];
+	size_t count = dcdGetFrameZones(summaries, 8);
+	dcdPrintFrameZones();
+	const DCdZoneSummary *frame = findSummary(summaries, count, "frame"), *inner = findSummary(summaries, count, "inner");
+	const DCdZoneSummary *job = findSummary(summaries, count, "job zone");
+	DCT_ASSERT(count == 6 && findSummary(summaries, count, "outside") == NULL, "only zones in profiled contexts were recorded");
+	DCT_ASSERT(frame != NULL && frame->count == 1 && inner != NULL && inner->count == 3, "contexts and zones are summed up");
+	DCT_ASSERT(frame->totalNs >= inner->totalNs && summaries[0].totalNs >= summaries[count - 1].totalNs, "summaries are sorted by time");
+	DCT_ASSERT(job != NULL && job->count == THREAD_COUNT * ZONE_COUNT, "zones of every thread are summed up");
+
+	FILE *trace = tmpfile();
+	DCT_ASSERT(dcdWriteChromeTrace(trace), "wrote the trace");
+	DCT_ASSERT(countText(trace, "\"ph\":\"X\"") == 1 + 5 + THREAD_COUNT * (ZONE_COUNT + 1), "every zone is a complete event");
+	DCT_ASSERT(countText(trace, "\"thread_name\"") == 1 + THREAD_COUNT, "every thread is named");
+	DCT_ASSERT(countText(trace, "{") == countText(trace, "}"), "the trace is balanced");
+	fclose(trace);
+	dcdStopProfiling();
+	return 0;
+}
+
+static double elapsedNs(struct timespec begin) {
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	return (double)(end.tv_sec - begin.tv_sec) * 1e9 + (double)(end.tv_nsec - begin.tv_nsec);
+}
+
+DCT_TEST(profileOverhead, "zone overhead") {
+	const int zoneCount = 1000000;
+	dcdStartProfiling(4096);
+	struct timespec begin;
+	timespec_get(&begin, TIME_UTC);
+	for(int i = 0; i < zoneCount; ++i) {
+		DCD_BEGIN_ZONE("skipped");
+		DCD_END_ZONE();
+	}
+	double skipped = elapsedNs(begin) / zoneCount;
+
+	dcdGetCurrentContext()->profile = true;
+	timespec_get(&begin, TIME_UTC);
+	for(int i = 0; i < zoneCount; ++i) {
+		DCD_BEGIN_ZONE("recorded");
+		DCD_END_ZONE();
+	}
+	double recorded = elapsedNs(begin) / zoneCount;
+	dcdGetCurrentContext()->profile = false;
+	dcdStopProfiling();
+	DCD_INFO("%.1f ns per recorded zone, %.1f ns per zone outside profiled contexts", recorded, skipped);
+	return 0;
+}
@@ -0,0 +1,130 @@
+#define _DEFAULT_SOURCE // mkstemp
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MESSAGE_COUNT 2000
+#define RING_SIZE (64 * 1024)
+
+static void *logMessages(void *data) {
+	for(int i = 0; i < MESSAGE_COUNT; ++i)
+		DCD_MSGF(DEBUG, "ring message %d from %s", i, data == NULL ? "main" : "worker");
+	return NULL;
+}
+
+/** counts the lines of sink that contain text, sink is rewound. */
+static size_t countLines(FILE *sink, const char *text) {
+	rewind(sink);
+	char line[2048];
+	size_t count = 0;
+	while(fgets(line, sizeof(line), sink) != NULL)
+		if(strstr(line, text) != NULL) ++count;
+	return count;
+}
+
+/** checks that the messages of each thread come in order, which fails if records were torn or misread. */
+static bool messagesInOrder(FILE *sink) {
+	rewind(sink);
+	char line[2048], thread[16];
+	int last[2] = { -1, -1 }, number;
+	while(fgets(line, sizeof(line), sink) != NULL) {
+		const char *message = strstr(line, "ring message ");
+		if(message == NULL) continue;
+		if(sscanf(message, "ring message %d from %15s", &number, thread) != 2) return false;
+		int *previous = &last[strcmp(thread, "main") == 0 ? 0 : 1];
+		if(number <= *previous) return false;
+		*previous = number;
+	}
+	return true;
+}
+
+static FILE *readRing(const char *path, size_t count) {
+	FILE *in = fopen(path, "rb"), *out = tmpfile();
+	bool valid = in != NULL && dcdReadRingLog(in, out, count);
+	if(in != NULL) fclose(in);
+	if(!valid) fclose(out);
+	return valid ? out : NULL;
+}
+
+DCT_TEST(ringLog, "the ring file keeps the last messages") {
+	char path[] = "/tmp/dcd-ring-XXXXXX";
+	int fd = mkstemp(path);
+	DCT_ASSERT(fd >= 0, "created a temporary file");
+	close(fd);
+
+	dcdRemoveSink(stdout);
+	bool opened = dcdOpenRingSink(path, RING_SIZE, DCD_MSG_MASK_ALL);
+	DCD_PUSH_CONTEXT("ring");
+	pthread_t thread;
+	pthread_create(&thread, NULL, logMessages, (void *)1);
+	logMessages(NULL);
+	pthread_join(thread, NULL);
+	DCD_MSGF(INFO, "last message");
+	DCD_POP_CONTEXT();
+	dcdCloseRingSink();
+	dcdAddSink(stdout);
+	DCT_ASSERT(opened, "opened the ring sink");
+
+	FILE *out = readRing(path, 10);
+	DCT_ASSERT(out != NULL, "the ring reads");
+	DCT_ASSERT(countLines(out, "|") == 10, "count messages are read");
+	DCT_ASSERT(countLines(out, "last message") == 1 && countLines(out, "ring message") == 8, "the last messages are read");
+	fclose(out);
+
+	out = readRing(path, SIZE_MAX);
+	size_t kept = countLines(out, "ring message");
+	DCT_ASSERT(kept > RING_SIZE / 256 && kept < 2 * MESSAGE_COUNT, "the ring wrapped and kept what fits");
+	DCT_ASSERT(messagesInOrder(out), "the messages are complete and in order");
+	fclose(out);
+
+	// the ring is continued, messages of the last run stay.
+	DCT_ASSERT(dcdOpenRingSink(path, RING_SIZE, DCD_MSG_MASK(INFO)), "reopened the ring sink");
+	DCD_MSGF(DEBUG, "not in the mask");
+	DCD_MSGF(INFO, "after reopening");
+	dcdCloseRingSink();
+	out = readRing(path, 3);
+	DCT_ASSERT(countLines(out, "last message") == 1 && countLines(out, "after reopening") == 1, "the ring was continued");
+	DCT_ASSERT(countLines(out, "not in the mask") == 0, "the mask filters messages");
+	fclose(out);
+	remove(path);
+
+	FILE *invalid = tmpfile();
+	fputs("not a ring file", invalid);
+	rewind(invalid);
+	DCT_ASSERT(!dcdReadRingLog(invalid, stdout, 1), "other files aren't read");
+	fclose(invalid);
+	return 0;
+}
+
+DCT_TEST(ringCrash, "the ring file survives a killed process") {
+	char path[] = "/tmp/dcd-ring-XXXXXX";
+	int fd = mkstemp(path);
+	DCT_ASSERT(fd >= 0, "created a temporary file");
+	close(fd);
+
+	// the child would write what stdout buffered once more.
+	dcdFlush();
+	pid_t child = fork();
+	if(child == 0) {
+		dcdRemoveSink(stdout);
+		dcdOpenRingSink(path, RING_SIZE, DCD_MSG_MASK_ALL);
+		DCD_MSGF(WARNING, "before the crash %d", 42);
+		raise(SIGKILL);
+	}
+	int status;
+	DCT_ASSERT(child > 0 && waitpid(child, &status, 0) == child, "the child ran");
+	DCT_ASSERT(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL, "the child was killed");
+
+	FILE *out = readRing(path, 1);
+	remove(path);
+	DCT_ASSERT(out != NULL, "the ring reads");
+	DCT_ASSERT(countLines(out, "before the crash 42") == 1 && countLines(out, "WARN |") == 1, "the message survived");
+	fclose(out);
+	return 0;
+}
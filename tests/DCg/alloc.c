@@ -0,0 +1,46 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/graphics.h>
+#include <tests/test.h>
+#include <string.h>
+
+#define BUFFER_COUNT 4096
+
+DCT_TEST(deviceMemory, "buffers are sub-allocated and defragmented") {
+	DCgState *state = dcgNewState();
+	dcgInit(state, 1, "DCE Tests");
+
+	static DCgBuffer *buffers[BUFFER_COUNT];
+	for(size_t i = 0; i < BUFFER_COUNT; ++i) {
+		buffers[i] = dcgNewBuffer(state, 1024 + (i % 7) * 512, DCG_BUFFER_USAGE_VERTEX, i % 2 ? DCG_MEMORY_USAGE_CPU_TO_GPU : DCG_MEMORY_USAGE_GPU_ONLY);
+		DCT_ASSERT(buffers[i] != NULL, "buffer was created");
+	}
+
+	uint32_t *mapping = dcgGetBufferMapping(state, buffers[BUFFER_COUNT - 1]);
+	DCT_ASSERT(mapping != NULL, "host visible buffers are mapped");
+	mapping[0] = 0xdeadbeef;
+	dcgFlushBuffer(state, buffers[BUFFER_COUNT - 1], 0, sizeof(uint32_t));
+	DCT_ASSERT(dcgGetBufferMapping(state, buffers[0]) == NULL, "device local buffers aren't mapped");
+
+	// free most of the buffers, leaving sparse blocks behind.
+	for(size_t i = 0; i < BUFFER_COUNT - 1; ++i) {
+		if(i % 16 == 0) continue;
+		dcgFreeBuffer(state, buffers[i]);
+		buffers[i] = NULL;
+	}
+
+	dcgPrintDeviceMemoryStats(state);
+	size_t moves = dcgDefragmentDeviceMemory(state, SIZE_MAX);
+	DCD_MSGF(DEBUG, "Moved %zu buffers", moves);
+	dcgPrintDeviceMemoryStats(state);
+
+	mapping = dcgGetBufferMapping(state, buffers[BUFFER_COUNT - 1]);
+	DCT_ASSERT(mapping[0] == 0xdeadbeef, "moved buffers keep their contents");
+
+	for(size_t i = 0; i < BUFFER_COUNT; ++i)
+		if(buffers[i] != NULL) dcgFreeBuffer(state, buffers[i]);
+
+	dcgDeinit(state);
+	dcgFreeState(state);
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include <dcore/common.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <tests/test.h>
+#include <string.h>
+
+#define COMMAND_ALLOCATIONS 10000
+
+/** the callbacks are called like a driver would, no device is needed. */
+DCT_TEST(hostAllocator, "driver host memory is counted per scope") {
+	DCgiHostAllocator allocator;
+	dcgiInitHostAllocator(&allocator);
+	const VkAllocationCallbacks *callbacks = &allocator.callbacks;
+	DCgHostMemoryStats *object = &allocator.stats[DCG_HOST_MEMORY_SCOPE_OBJECT];
+
+	uint8_t *pointer = callbacks->pfnAllocation(callbacks->pUserData, 100, 64, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+	DCT_ASSERT(pointer != NULL && (uintptr_t)pointer % 64 == 0, "allocations are aligned");
+	memset(pointer, 0xab, 100);
+	pointer = callbacks->pfnReallocation(callbacks->pUserData, pointer, 200, 64, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT);
+	DCT_ASSERT(pointer != NULL && (uintptr_t)pointer % 64 == 0 && pointer[99] == 0xab, "reallocations keep the contents");
+	DCT_ASSERT(object->allocCount == 1 && object->reallocCount == 1 && object->liveBytes == 200, "allocations are counted");
+	DCT_ASSERT(object->peakBytes == 300 && object->totalBytes == 300, "reallocations move the memory");
+	callbacks->pfnFree(callbacks->pUserData, pointer);
+	callbacks->pfnFree(callbacks->pUserData, NULL);
+	DCT_ASSERT(object->freeCount == 1 && object->liveBytes == 0, "frees are counted");
+
+	callbacks->pfnInternalAllocation(callbacks->pUserData, 4096, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+	DCT_ASSERT(allocator.stats[DCG_HOST_MEMORY_SCOPE_DEVICE].internalBytes == 4096, "internal allocations are counted");
+	callbacks->pfnInternalFree(callbacks->pUserData, 4096, VK_INTERNAL_ALLOCATION_TYPE_EXECUTABLE, VK_SYSTEM_ALLOCATION_SCOPE_DEVICE);
+	DCT_ASSERT(allocator.stats[DCG_HOST_MEMORY_SCOPE_DEVICE].internalBytes == 0, "internal frees are counted");
+
+	allocator.stats[DCG_HOST_MEMORY_SCOPE_CACHE].limit = 1024;
+	DCT_ASSERT(callbacks->pfnAllocation(callbacks->pUserData, 2048, 8, VK_SYSTEM_ALLOCATION_SCOPE_CACHE) == NULL, "limits are kept");
+	DCT_ASSERT(allocator.stats[DCG_HOST_MEMORY_SCOPE_CACHE].failedCount == 1, "failed allocations are counted");
+
+	dcgiFreeHostAllocator(&allocator);
+	return 0;
+}
+
+DCT_TEST(hostCommandArena, "command scope memory is taken from a bounded arena") {
+	DCgiHostAllocator allocator;
+	dcgiInitHostAllocator(&allocator);
+	const VkAllocationCallbacks *callbacks = &allocator.callbacks;
+
+	// a command allocation that stays live keeps the arena from being reset.
+	void *kept = callbacks->pfnAllocation(callbacks->pUserData, 64, 16, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+	DCT_ASSERT(kept != NULL && allocator.commandLiveCount == 1, "command allocations are pushed into the arena");
+	bool allocated = true;
+	for(int i = 0; i < COMMAND_ALLOCATIONS; ++i) {
+		void *pointer = callbacks->pfnAllocation(callbacks->pUserData, 1024, 16, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND);
+		allocated = allocated && pointer != NULL && (uintptr_t)pointer % 16 == 0;
+		callbacks->pfnFree(callbacks->pUserData, pointer);
+	}
+	DCgHostMemoryStats *command = &allocator.stats[DCG_HOST_MEMORY_SCOPE_COMMAND];
+	DCT_ASSERT(allocated, "command allocations don't fail past the arena");
+	DCT_ASSERT(allocator.commandArena.size == DCGI_COMMAND_ARENA_SIZE, "the arena doesn't grow");
+	DCT_ASSERT(allocator.commandLiveCount == 1, "allocations past the arena aren't counted as arena allocations");
+	DCT_ASSERT(command->allocCount == COMMAND_ALLOCATIONS + 1 && command->freeCount == COMMAND_ALLOCATIONS, "command allocations are counted");
+	DCT_ASSERT(command->liveBytes == 64, "command bytes are counted");
+
+	callbacks->pfnFree(callbacks->pUserData, kept);
+	DCT_ASSERT(allocator.commandLiveCount == 0 && allocator.commandArena.top == 0, "the arena is reset once nothing in it is live");
+	DCT_ASSERT(command->liveBytes == 0, "all command memory was freed");
+
+	dcgiFreeHostAllocator(&allocator);
+	return 0;
+}
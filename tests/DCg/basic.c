@@ -2,7 +2,9 @@
 #include <dcore/debug.h>
 #include <dcore/graphics.h>
 #include <dcore/renderers/basic.h>
+#include <dcore/math/pack.h>
 #include <tests/test.h>
+#include <stdlib.h>
 
 DCT_TEST(basicRendererInit, "basic renderer init test") {
 	DCD_MSGF(DEBUG, "Creating State");
@@ -11,7 +13,10 @@ DCT_TEST(basicRendererInit, "basic renderer init test") {
 	dcgInit(state, 1, "DCE Tests");
 
 	DCD_DEBUG("dcgBasicRendererCreateInfo");
-	dcgBasicRendererCreateInfo(state);
+	DCgBasicRendererInfo info;
+	dcgBasicRendererCreateInfo(state, &info);
+	DCT_ASSERT(info.pushConstants != DCMEM_INVALID_HANDLE, "push constant ranges were registered");
+	DCT_ASSERT(info.vertexInput != DCMEM_INVALID_HANDLE, "vertex input was registered");
 
 	dcgClose(state);
 	while(!dcgShouldClose(state)) {
@@ -25,3 +30,31 @@ DCT_TEST(basicRendererInit, "basic renderer init test") {
 
 	return 0;
 }
+
+DCT_TEST(basicRendererPackVertices, "SIMD vertex packing matches the scalar encoders") {
+	srand(11);
+	DCgBasicRendererVertex vertices[61];
+	for(size_t i = 0; i < ARRAYSIZE(vertices); ++i) {
+		for(int a = 0; a < 3; ++a) {
+			vertices[i].position[a] = (float)rand() / RAND_MAX * 200.0f - 100.0f;
+			vertices[i].normal[a] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+		}
+		vertices[i].texcoords[0] = (float)rand() / RAND_MAX, vertices[i].texcoords[1] = (float)rand() / RAND_MAX;
+	}
+
+	DCgBasicRendererPackedVertex packed[ARRAYSIZE(vertices)];
+	dcgBasicRendererPackVertices(packed, vertices, ARRAYSIZE(vertices));
+	bool matches = true;
+	for(size_t i = 0; i < ARRAYSIZE(vertices); ++i) {
+		int16_t normal[2];
+		DCmVector3fToOctahedral(normal, vertices[i].normal);
+		for(int a = 0; a < 3; ++a)
+			matches &= packed[i].position[a] == DCmFloatToHalf(vertices[i].position[a]);
+		matches &= packed[i].position[3] == DCmFloatToHalf(1.0f) && packed[i].normal[0] == normal[0] && packed[i].normal[1] == normal[1];
+		matches &= packed[i].texcoords[0] == DCmFloatToHalf(vertices[i].texcoords[0]);
+		matches &= packed[i].texcoords[1] == DCmFloatToHalf(vertices[i].texcoords[1]);
+	}
+	DCT_ASSERT(sizeof(DCgBasicRendererPackedVertex) * 2 == sizeof(DCgBasicRendererVertex), "packed vertices are half the size");
+	DCT_ASSERT(matches, "every vertex matches");
+	return 0;
+}
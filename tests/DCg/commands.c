@@ -0,0 +1,51 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <tests/test.h>
+
+#define BUFFERS_PER_FRAME 5
+#define FRAME_COUNT (DCG_FRAMES_IN_FLIGHT * 3)
+
+DCT_TEST(cmdBuffers, "command buffers are recycled per frame slot") {
+	DCgState *state = dcgNewState();
+	dcgInit(state, 1, "DCE Tests");
+	DCgCmdPool *pool = dcgNewCmdPool(state, DCG_CMD_POOL_TYPE_GRAPHICS);
+	DCgVertexBuffer *vertices = dcgNewBuffer(state, 1024, DCG_BUFFER_USAGE_VERTEX, DCG_MEMORY_USAGE_CPU_TO_GPU);
+	DCgIndexBuffer *indices = dcgNewBuffer(state, 1024, DCG_BUFFER_USAGE_INDEX, DCG_MEMORY_USAGE_CPU_TO_GPU);
+
+	DCgCmdBuffer *buffers[FRAME_COUNT][BUFFERS_PER_FRAME];
+	for(int f = 0; f < FRAME_COUNT; ++f) {
+		dcgBeginFrame(state);
+		for(int b = 0; b < BUFFERS_PER_FRAME; ++b) {
+			DCgCmdBuffer *cmds = buffers[f][b] = dcgGetNewCmdBuffer(state, pool);
+			dcgCmdBegin(state, cmds);
+			dcgCmdBindVertexBuf(state, cmds, vertices);
+			dcgCmdBindIndexBuf(state, cmds, indices);
+			dcgCmdBindVertexBuf(state, cmds, vertices);
+			dcgSubmit(state, cmds, 0);
+		}
+		dcgEndFrame(state);
+	}
+	vkDeviceWaitIdle(state->device);
+
+	bool distinct = true, recycled = true;
+	for(int f = 0; f < FRAME_COUNT; ++f)
+		for(int b = 0; b < BUFFERS_PER_FRAME; ++b) {
+			for(int c = 0; c < b; ++c)
+				distinct = distinct && buffers[f][b] != buffers[f][c];
+			if(f >= DCG_FRAMES_IN_FLIGHT) recycled = recycled && buffers[f][b] == buffers[f - DCG_FRAMES_IN_FLIGHT][b];
+			if(f >= 1) distinct = distinct && buffers[f][b] != buffers[f - 1][b];
+		}
+	DCT_ASSERT(distinct, "a frame gets its own command buffers");
+	DCT_ASSERT(recycled, "command buffers are reused when their frame slot is");
+	DCT_ASSERT(pool->frames[0].count < 2 * BUFFERS_PER_FRAME, "command buffers are allocated once");
+	DCT_ASSERT(buffers[0][0]->vertexBuffer == vertices->buffer && buffers[0][0]->indexBuffer == indices->buffer, "bound buffers are tracked");
+
+	dcgFreeBuffer(state, vertices);
+	dcgFreeBuffer(state, indices);
+	dcgFreeCmdPool(state, pool);
+	dcgDeinit(state);
+	dcgFreeState(state);
+	return 0;
+}
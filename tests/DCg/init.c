@@ -10,6 +10,14 @@ DCT_TEST(graphicsInit, "graphics initialization test") {
 	DCD_MSGF(DEBUG, "Initializing State");
 	dcgInit(state, 1, "DCE Tests");
 
+	DCD_MSGF(DEBUG, "Running frames");
+	for(int i = 0; i < 8; ++i) {
+		dcgBeginFrame(state);
+		dcgUpdate(state);
+		dcgEndFrame(state);
+	}
+	dcgPrintHostMemoryStats(state);
+
 	dcgClose(state);
 	while(!dcgShouldClose(state)) {
 		dcgUpdate(state);
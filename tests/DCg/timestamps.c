@@ -0,0 +1,71 @@
+#include <dcore/common.h>
+#include <dcore/debug.h>
+#include <dcore/graphics.h>
+#include <dcore/graphics/internal.h>
+#include <tests/test.h>
+#include <string.h>
+
+/**
+ * records a frame with a GPU zone around two zones of the same name, a zone of a second command buffer is recorded in
+ * between. both are submitted before the frame fence.
+ **/
+static void recordZones(DCgState *state, DCgCmdPool *pool) {
+	DCgCmdBuffer *cmds = dcgGetNewCmdBuffer(state, pool), *other = dcgGetNewCmdBuffer(state, pool);
+	dcgCmdBegin(state, cmds);
+	dcgCmdBegin(state, other);
+	dcgCmdBeginGpuZone(state, cmds, "gpu frame");
+	dcgCmdBeginGpuZone(state, other, "gpu other");
+	dcgCmdEndGpuZone(state, other);
+	for(int i = 0; i < 2; ++i) {
+		dcgCmdBeginGpuZone(state, cmds, "gpu pass");
+		dcgCmdEndGpuZone(state, cmds);
+	}
+	dcgCmdEndGpuZone(state, cmds);
+	dcgSubmit(state, cmds, 0);
+	dcgSubmit(state, other, 0);
+}
+
+DCT_TEST(gpuZones, "GPU zones are read back frames later") {
+	DCgState *state = dcgNewState();
+	dcgInit(state, 1, "DCE Tests");
+	dcdStartProfiling(1024);
+	DCgCmdPool *pool = dcgNewCmdPool(state, DCG_CMD_POOL_TYPE_GRAPHICS);
+
+	const DCgGpuZone *zones;
+	uint64_t frameNumber;
+	size_t zoneCounts[DCG_FRAMES_IN_FLIGHT + 2];
+	for(int i = 0; i < DCG_FRAMES_IN_FLIGHT + 2; ++i) {
+		dcgBeginFrame(state);
+		zoneCounts[i] = dcgGetGpuZones(state, &zones, &frameNumber);
+		recordZones(state, pool);
+		dcgEndFrame(state);
+	}
+	vkDeviceWaitIdle(state->device);
+	dcdPrintFrameZones();
+
+	if(state->gpuTimer.pools[0] == VK_NULL_HANDLE) {
+		DCT_ASSERT(zoneCounts[DCG_FRAMES_IN_FLIGHT] == 0, "nothing is timed without timestamps");
+	} else {
+		DCT_ASSERT(zoneCounts[DCG_FRAMES_IN_FLIGHT - 1] == 0, "zones aren't read before their slot is reused");
+		DCT_ASSERT(zoneCounts[DCG_FRAMES_IN_FLIGHT] == 4, "zones are read back when their slot is reused");
+		DCT_ASSERT(frameNumber == 1, "the zones belong to the frame they were recorded in");
+		DCT_ASSERT(strcmp(zones[0].name, "gpu frame") == 0 && zones[0].depth == 0 && zones[2].depth == 1, "zones keep their nesting");
+		DCT_ASSERT(strcmp(zones[1].name, "gpu other") == 0 && zones[1].depth == 0, "zones nest per command buffer");
+		DCT_ASSERT(zones[2].beginNs >= zones[0].beginNs && zones[2].durationNs <= zones[0].durationNs, "the inner zone is inside the outer zone");
+
+		DCdZoneSummary summaries[16];
+		size_t count = dcdGetFrameZones(summaries, 16), passes = 0, passCount = 0;
+		for(size_t i = 0; i < count && i < 16; ++i) {
+			if(summaries[i].track == NULL || strcmp(summaries[i].track, "gpu") != 0 || strcmp(summaries[i].name, "gpu pass") != 0) continue;
+			passes += 1;
+			passCount = summaries[i].count;
+		}
+		DCT_ASSERT(passes == 1 && passCount == 2, "GPU zones are summed up by name");
+	}
+
+	dcgFreeCmdPool(state, pool);
+	dcdStopProfiling();
+	dcgDeinit(state);
+	dcgFreeState(state);
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <dcore/math/batch.h>
+#include <tests/test.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define BATCH_COUNT 1003 // not a multiple of eight, so the tails are used.
+
+static float randomFloat() { return (float)rand() / RAND_MAX * 20.0f - 10.0f; }
+
+static bool nearlyEqual(const float *a, const float *b, size_t count) {
+	for(size_t i = 0; i < count; ++i)
+		if(fabsf(a[i] - b[i]) > 1e-4f * (1.0f + fabsf(a[i]))) return false;
+	return true;
+}
+
+DCT_TEST(vectorCross, "cross product of vectors") {
+	DCmVector3f x = { 1.0f, 0.0f, 0.0f }, y = { 0.0f, 1.0f, 0.0f };
+	DCmVector3fCross(x, y);
+	DCT_ASSERT(x[0] == 0.0f && x[1] == 0.0f && x[2] == 1.0f, "x cross y is z");
+	return 0;
+}
+
+DCT_TEST(vectorBatches, "batched vector kernels match the per vector functions") {
+	srand(42);
+	static DCmVector3f a[BATCH_COUNT], b[BATCH_COUNT], result[BATCH_COUNT], expected[BATCH_COUNT];
+	static float dots[BATCH_COUNT], expectedDots[BATCH_COUNT];
+	static float x[BATCH_COUNT], y[BATCH_COUNT], z[BATCH_COUNT], bx[BATCH_COUNT], by[BATCH_COUNT], bz[BATCH_COUNT];
+	DCmStream3f stream = { x, y, z }, streamB = { bx, by, bz };
+	DCmMatrix4x4f m;
+	for(int c = 0; c < 4; ++c)
+		for(int r = 0; r < 4; ++r)
+			m[c][r] = randomFloat();
+	for(size_t i = 0; i < BATCH_COUNT; ++i)
+		for(int j = 0; j < 3; ++j)
+			a[i][j] = randomFloat(), b[i][j] = randomFloat();
+	a[7][0] = a[7][1] = a[7][2] = 0.0f;
+
+	bool points = true, directions = true, normalized = true, dot = true, cross = true, streams = true;
+	DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+	for(int level = DCM_SIMD_LEVEL_SCALAR; level <= (int)supported; ++level) {
+		dcmSetSimdLevel((DCmSimdLevel)level);
+
+		for(size_t i = 0; i < BATCH_COUNT; ++i) {
+			DCmVector4f v = { a[i][0], a[i][1], a[i][2], 1.0f };
+			DCmMatrix4x4fMulVector(v, m, v);
+			expected[i][0] = v[0], expected[i][1] = v[1], expected[i][2] = v[2];
+		}
+		dcmVector3fTransformPoints(result, m, a, BATCH_COUNT);
+		points &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		dcmStream3fFromVectors(stream, a, BATCH_COUNT);
+		dcmStream3fTransformPoints(stream, m, stream, BATCH_COUNT);
+		dcmStream3fToVectors(result, stream, BATCH_COUNT);
+		streams &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		for(size_t i = 0; i < BATCH_COUNT; ++i) {
+			DCmVector4f v = { a[i][0], a[i][1], a[i][2], 0.0f };
+			DCmMatrix4x4fMulVector(v, m, v);
+			expected[i][0] = v[0], expected[i][1] = v[1], expected[i][2] = v[2];
+		}
+		dcmVector3fTransformDirections(result, m, a, BATCH_COUNT);
+		directions &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		dcmStream3fFromVectors(stream, a, BATCH_COUNT);
+		dcmStream3fTransformDirections(stream, m, stream, BATCH_COUNT);
+		dcmStream3fToVectors(result, stream, BATCH_COUNT);
+		streams &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		for(size_t i = 0; i < BATCH_COUNT; ++i) {
+			float length = sqrtf(DCmVector3fDot(a[i], a[i]));
+			for(int j = 0; j < 3; ++j)
+				expected[i][j] = length > 0.0f ? a[i][j] / length : 0.0f;
+		}
+		dcmVector3fNormalize(result, a, BATCH_COUNT);
+		normalized &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		dcmStream3fFromVectors(stream, a, BATCH_COUNT);
+		dcmStream3fNormalize(stream, stream, BATCH_COUNT);
+		dcmStream3fToVectors(result, stream, BATCH_COUNT);
+		streams &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		for(size_t i = 0; i < BATCH_COUNT; ++i)
+			expectedDots[i] = DCmVector3fDot(a[i], b[i]);
+		dcmVector3fDot(dots, a, b, BATCH_COUNT);
+		dot &= nearlyEqual(expectedDots, dots, BATCH_COUNT);
+
+		dcmStream3fFromVectors(stream, a, BATCH_COUNT);
+		dcmStream3fFromVectors(streamB, b, BATCH_COUNT);
+		dcmStream3fDot(dots, stream, streamB, BATCH_COUNT);
+		streams &= nearlyEqual(expectedDots, dots, BATCH_COUNT);
+
+		for(size_t i = 0; i < BATCH_COUNT; ++i) {
+			expected[i][0] = a[i][0], expected[i][1] = a[i][1], expected[i][2] = a[i][2];
+			DCmVector3fCross(expected[i], b[i]);
+		}
+		dcmVector3fCross(result, a, b, BATCH_COUNT);
+		cross &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+
+		dcmStream3fCross(stream, stream, streamB, BATCH_COUNT);
+		dcmStream3fToVectors(result, stream, BATCH_COUNT);
+		streams &= nearlyEqual(&expected[0][0], &result[0][0], BATCH_COUNT * 3);
+	}
+	dcmSetSimdLevel(supported);
+
+	DCT_ASSERT(points, "transformed points match");
+	DCT_ASSERT(directions, "transformed directions match");
+	DCT_ASSERT(normalized, "normalized vectors match");
+	DCT_ASSERT(dot, "dot products match");
+	DCT_ASSERT(cross, "cross products match");
+	DCT_ASSERT(streams, "stream results match");
+	return 0;
+}
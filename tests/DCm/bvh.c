@@ -0,0 +1,154 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <dcore/math/bvh.h>
+#include <tests/test.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define BOX_COUNT 20000
+#define QUERY_COUNT 300
+
+static float randomFloat(float min, float max) { return min + (float)rand() / RAND_MAX * (max - min); }
+
+static void randomBoxes(DCmAabb *boxes, uint32_t count) {
+	for(uint32_t i = 0; i < count; ++i) {
+		for(int a = 0; a < 3; ++a) {
+			boxes[i].min[a] = randomFloat(-100.0f, 100.0f);
+			boxes[i].max[a] = boxes[i].min[a] + randomFloat(0.1f, 2.0f);
+		}
+	}
+}
+
+static float rayBox(const DCmAabb *box, const DCmRay *ray) {
+	float near = 0.0f, far = INFINITY;
+	for(int a = 0; a < 3; ++a) {
+		float t1 = (box->min[a] - ray->origin[a]) / ray->direction[a], t2 = (box->max[a] - ray->origin[a]) / ray->direction[a];
+		near = fmaxf(near, fminf(t1, t2));
+		far = fminf(far, fmaxf(t1, t2));
+	}
+	return near <= far ? near : INFINITY;
+}
+
+static bool validNode(const DCmBvh *bvh, const DCmAabb *boxes, uint32_t node, uint32_t *primitives) {
+	const DCmBvhNode *n = bvh->nodes + node;
+	if(n->count != 0) {
+		bool valid = n->count <= DCM_BVH_MAX_LEAF_SIZE;
+		for(uint32_t i = n->first; i < n->first + n->count; ++i) {
+			const DCmAabb *box = boxes + bvh->indices[i];
+			for(int a = 0; a < 3; ++a)
+				valid &= n->min[a] <= box->min[a] && box->max[a] <= n->max[a];
+		}
+		*primitives += n->count;
+		return valid;
+	}
+	bool valid = n->first > node && n->first % 2 == 0 && n->first + 1 < bvh->nodeCount;
+	for(uint32_t child = n->first; valid && child < n->first + 2; ++child) {
+		for(int a = 0; a < 3; ++a)
+			valid &= n->min[a] <= bvh->nodes[child].min[a] && bvh->nodes[child].max[a] <= n->max[a];
+		valid &= validNode(bvh, boxes, child, primitives);
+	}
+	return valid;
+}
+
+/** compares raycasts and overlap queries against a linear scan. */
+static bool queriesMatch(const DCmBvh *bvh, const DCmAabb *boxes) {
+	bool matches = true;
+	for(int q = 0; q < QUERY_COUNT; ++q) {
+		DCmRay ray = {
+			{ randomFloat(-150.0f, 150.0f), randomFloat(-150.0f, 150.0f), randomFloat(-150.0f, 150.0f) },
+			{ randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f) },
+		};
+		uint32_t expected = DCM_BVH_NO_HIT;
+		float closest = INFINITY;
+		for(uint32_t i = 0; i < BOX_COUNT; ++i) {
+			float t = rayBox(boxes + i, &ray);
+			if(t < closest) closest = t, expected = i;
+		}
+		float distance = INFINITY;
+		uint32_t hit = dcmBvhRaycast(bvh, boxes, &ray, INFINITY, NULL, NULL, &distance);
+		// two boxes can be entered at the same distance.
+		matches &= hit == expected || (hit != DCM_BVH_NO_HIT && fabsf(distance - closest) < 1e-4f);
+
+		DCmAabb box;
+		for(int a = 0; a < 3; ++a) {
+			box.min[a] = randomFloat(-100.0f, 100.0f);
+			box.max[a] = box.min[a] + randomFloat(1.0f, 20.0f);
+		}
+		size_t expectedCount = 0;
+		for(uint32_t i = 0; i < BOX_COUNT; ++i) {
+			bool overlap = true;
+			for(int a = 0; a < 3; ++a)
+				overlap &= boxes[i].min[a] <= box.max[a] && box.min[a] <= boxes[i].max[a];
+			expectedCount += overlap;
+		}
+		uint32_t results[16];
+		matches &= dcmBvhOverlap(bvh, boxes, &box, results, 16) == expectedCount;
+	}
+	return matches;
+}
+
+DCT_TEST(bvhQueries, "bvh raycasts and overlap queries match linear scans") {
+	srand(5);
+	DCmAabb *boxes = dcmemAllocate(sizeof(DCmAabb) * BOX_COUNT);
+	randomBoxes(boxes, BOX_COUNT);
+
+	for(uint32_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+		DCmBvh bvh;
+		dcmBuildBvh(&bvh, boxes, BOX_COUNT, threadCount);
+		uint32_t primitives = 0;
+		DCT_ASSERT(validNode(&bvh, boxes, 0, &primitives) && primitives == BOX_COUNT, "every box is in a leaf inside its parents");
+		DCT_ASSERT((uintptr_t)bvh.nodes % DCMEM_CACHE_LINE_SIZE == 0, "sibling pairs share a cache line");
+
+		bool matches = true;
+		DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+		for(int level = DCM_SIMD_LEVEL_SCALAR; level <= (int)supported; ++level) {
+			dcmSetSimdLevel((DCmSimdLevel)level);
+			matches &= queriesMatch(&bvh, boxes);
+		}
+		dcmSetSimdLevel(supported);
+		DCT_ASSERT(matches, "queries match at every SIMD level");
+
+		// move everything, the refitted tree still has to answer correctly.
+		for(uint32_t i = 0; i < BOX_COUNT; ++i) {
+			float offset = randomFloat(-5.0f, 5.0f);
+			for(int a = 0; a < 3; ++a)
+				boxes[i].min[a] += offset, boxes[i].max[a] += offset;
+		}
+		dcmBvhRefit(&bvh, boxes);
+		primitives = 0;
+		DCT_ASSERT(validNode(&bvh, boxes, 0, &primitives), "refitted nodes contain their children");
+		DCT_ASSERT(queriesMatch(&bvh, boxes), "queries match after a refit");
+		dcmFreeBvh(&bvh);
+	}
+
+	dcmemDeallocate(boxes);
+	return 0;
+}
+
+DCT_TEST(bvhPicking, "a ray through the center of the screen picks the box in front of the camera") {
+	DCmAabb boxes[] = {
+		{ { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } },
+		{ { -1.0f, -1.0f, -11.0f }, { 1.0f, 1.0f, -9.0f } },
+		{ { 20.0f, -1.0f, -1.0f }, { 22.0f, 1.0f, 1.0f } },
+	};
+	DCmBvh bvh;
+	dcmBuildBvh(&bvh, boxes, 3, 1);
+
+	DCmMatrix4x4f view, projection, viewProjection, inverse;
+	DCmMatrix4x4fLookAt(view, (DCmVector3f){ 0.0f, 0.0f, 10.0f }, (DCmVector3f){ 0.0f, 0.0f, 0.0f }, (DCmVector3f){ 0.0f, 1.0f, 0.0f });
+	DCmMatrix4x4fPerspective(projection, 1.0f, 1.0f, 0.1f, 100.0f);
+	DCmMatrix4x4fMul(viewProjection, projection, view);
+	DCmMatrix4x4fInverse(inverse, viewProjection);
+
+	DCmRay ray;
+	dcmRayFromScreen(&ray, inverse, 0.0f, 0.0f);
+	float distance;
+	uint32_t hit = dcmBvhRaycast(&bvh, boxes, &ray, INFINITY, NULL, NULL, &distance);
+	DCT_ASSERT(hit == 0 && fabsf(distance - 8.9f) < 1e-3f, "the closest box is picked");
+	DCT_ASSERT(dcmBvhRaycast(&bvh, boxes, &ray, 5.0f, NULL, NULL, NULL) == DCM_BVH_NO_HIT, "boxes past the maximum distance are ignored");
+
+	dcmRayFromScreen(&ray, inverse, 1.0f, 0.0f);
+	DCT_ASSERT(dcmBvhRaycast(&bvh, boxes, &ray, INFINITY, NULL, NULL, NULL) == DCM_BVH_NO_HIT, "a ray to the side misses");
+	dcmFreeBvh(&bvh);
+	return 0;
+}
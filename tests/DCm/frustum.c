@@ -0,0 +1,138 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <dcore/math/frustum.h>
+#include <tests/test.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define OBJECT_COUNT 100000
+#define BENCHMARK_RUNS 20
+
+static float randomFloat(float min, float max) { return min + (float)rand() / RAND_MAX * (max - min); }
+
+static double now() {
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+/** how far from a plane FMA and the scalar code may round an object to different sides. */
+#define PLANE_EPSILON 1e-3
+
+/** signed distance of the object to the plane it is furthest outside of, the object is culled below 0. */
+static double cullMargin(const DCmFrustum *frustum, float x, float y, float z, float extentX, float extentY, float extentZ, float radius) {
+	double margin = INFINITY;
+	for(int p = 0; p < DCM_FRUSTUM_PLANE_COUNT; ++p) {
+		const float *plane = frustum->planes[p];
+		double distance = (double)plane[0] * x + (double)plane[1] * y + (double)plane[2] * z + plane[3];
+		distance += radius + fabs(plane[0]) * extentX + fabs(plane[1]) * extentY + fabs(plane[2]) * extentZ;
+		margin = fmin(margin, distance);
+	}
+	return margin;
+}
+
+/**
+ * compares the sorted index lists of a kernel and the scalar code, objects may only be in one of them if they are
+ * within PLANE_EPSILON of the plane that decides them. extents are NULL for spheres, radii for boxes.
+ **/
+static bool sameVisible(
+  const DCmFrustum *frustum, DCmStream3f centers, const DCmStream3f *extents, const float *radii, const uint32_t *expected, size_t expectedCount,
+  const uint32_t *visible, size_t visibleCount
+) {
+	bool same = true;
+	size_t e = 0, v = 0;
+	while(e < expectedCount || v < visibleCount) {
+		if(v > 0 && v < visibleCount) same &= visible[v - 1] < visible[v];
+		if(e < expectedCount && v < visibleCount && expected[e] == visible[v]) {
+			++e, ++v;
+			continue;
+		}
+		uint32_t i = v == visibleCount || (e < expectedCount && expected[e] < visible[v]) ? expected[e++] : visible[v++];
+		float extentX = extents != NULL ? extents->x[i] : 0.0f, extentY = extents != NULL ? extents->y[i] : 0.0f;
+		float extentZ = extents != NULL ? extents->z[i] : 0.0f, radius = radii != NULL ? radii[i] : 0.0f;
+		same &= fabs(cullMargin(frustum, centers.x[i], centers.y[i], centers.z[i], extentX, extentY, extentZ, radius)) <= PLANE_EPSILON;
+	}
+	return same;
+}
+
+static void cameraFrustum(DCmFrustum *frustum) {
+	DCmMatrix4x4f view, projection, viewProjection;
+	DCmMatrix4x4fLookAt(view, (DCmVector3f){ 0.0f, 10.0f, 50.0f }, (DCmVector3f){ 0.0f, 0.0f, 0.0f }, (DCmVector3f){ 0.0f, 1.0f, 0.0f });
+	DCmMatrix4x4fPerspective(projection, 1.0f, 16.0f / 9.0f, 0.1f, 200.0f);
+	DCmMatrix4x4fMul(viewProjection, projection, view);
+	dcmFrustumFromMatrix(frustum, viewProjection);
+}
+
+DCT_TEST(frustumPlanes, "frustum keeps what's in front of the camera") {
+	DCmFrustum frustum;
+	cameraFrustum(&frustum);
+	float x[] = { 0.0f, 0.0f, 500.0f, 0.0f }, y[] = { 0.0f, 0.0f, 0.0f, 10.0f }, z[] = { 0.0f, 100.0f, 0.0f, 51.0f };
+	float radii[] = { 1.0f, 1.0f, 1.0f, 3.0f };
+	uint32_t visible[4];
+	size_t count = dcmFrustumCullSpheres(&frustum, (DCmStream3f){ x, y, z }, radii, 4, visible);
+	DCT_ASSERT(count == 2 && visible[0] == 0 && visible[1] == 3, "spheres in front and around the camera are visible");
+
+	float extent[] = { 1.0f, 1.0f, 1.0f, 3.0f };
+	count = dcmFrustumCullBoxes(&frustum, (DCmStream3f){ x, y, z }, (DCmStream3f){ extent, extent, extent }, 4, visible);
+	DCT_ASSERT(count == 2 && visible[0] == 0 && visible[1] == 3, "boxes in front and around the camera are visible");
+	return 0;
+}
+
+DCT_TEST(frustumCullBenchmark, "culling 100k objects, SIMD kernels match the scalar ones") {
+	srand(3);
+	DCmFrustum frustum;
+	cameraFrustum(&frustum);
+
+	float *data = dcmemAllocate(sizeof(float) * OBJECT_COUNT * 7);
+	DCmStream3f centers = { data, data + OBJECT_COUNT, data + OBJECT_COUNT * 2 };
+	DCmStream3f extents = { data + OBJECT_COUNT * 3, data + OBJECT_COUNT * 4, data + OBJECT_COUNT * 5 };
+	float *radii = data + OBJECT_COUNT * 6;
+	for(size_t i = 0; i < OBJECT_COUNT; ++i) {
+		centers.x[i] = randomFloat(-300.0f, 300.0f), centers.y[i] = randomFloat(-50.0f, 50.0f), centers.z[i] = randomFloat(-300.0f, 300.0f);
+		extents.x[i] = randomFloat(0.1f, 3.0f), extents.y[i] = randomFloat(0.1f, 3.0f), extents.z[i] = randomFloat(0.1f, 3.0f);
+		radii[i] = randomFloat(0.1f, 3.0f);
+	}
+
+	uint32_t *expectedSpheres = dcmemAllocate(sizeof(uint32_t) * OBJECT_COUNT * 4);
+	uint32_t *expectedBoxes = expectedSpheres + OBJECT_COUNT, *spheres = expectedBoxes + OBJECT_COUNT, *boxes = spheres + OBJECT_COUNT;
+	size_t expectedSphereCount = 0, expectedBoxCount = 0;
+	bool matches = true;
+
+	DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+	for(int level = DCM_SIMD_LEVEL_SCALAR; level <= (int)supported; ++level) {
+		dcmSetSimdLevel((DCmSimdLevel)level);
+		size_t sphereCount = 0, boxCount = 0;
+		double start = now();
+		for(int run = 0; run < BENCHMARK_RUNS; ++run)
+			sphereCount = dcmFrustumCullSpheres(&frustum, centers, radii, OBJECT_COUNT, spheres);
+		double sphereTime = (now() - start) / BENCHMARK_RUNS;
+		start = now();
+		for(int run = 0; run < BENCHMARK_RUNS; ++run)
+			boxCount = dcmFrustumCullBoxes(&frustum, centers, extents, OBJECT_COUNT, boxes);
+		double boxTime = (now() - start) / BENCHMARK_RUNS;
+		DCD_MSGF(
+		  INFO, "SIMD level %d: %zu/%d spheres visible in %.3f ms, %zu boxes in %.3f ms", level, sphereCount, OBJECT_COUNT, sphereTime * 1e3, boxCount,
+		  boxTime * 1e3
+		);
+
+		if(level == DCM_SIMD_LEVEL_SCALAR) {
+			expectedSphereCount = sphereCount, expectedBoxCount = boxCount;
+			memcpy(expectedSpheres, spheres, sizeof(uint32_t) * sphereCount);
+			memcpy(expectedBoxes, boxes, sizeof(uint32_t) * boxCount);
+			continue;
+		}
+		// FMA rounds differently, objects touching a plane may flip.
+		matches &= sameVisible(&frustum, centers, NULL, radii, expectedSpheres, expectedSphereCount, spheres, sphereCount);
+		matches &= sameVisible(&frustum, centers, &extents, NULL, expectedBoxes, expectedBoxCount, boxes, boxCount);
+	}
+	dcmSetSimdLevel(supported);
+
+	DCT_ASSERT(expectedSphereCount > 0 && expectedSphereCount < OBJECT_COUNT, "some spheres are culled");
+	DCT_ASSERT(expectedBoxCount > 0 && expectedBoxCount < OBJECT_COUNT, "some boxes are culled");
+	DCT_ASSERT(matches, "SIMD results match");
+	dcmemDeallocate(expectedSpheres);
+	dcmemDeallocate(data);
+	return 0;
+}
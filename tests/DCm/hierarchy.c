@@ -0,0 +1,136 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <dcore/math/hierarchy.h>
+#include <tests/test.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_COUNT 1000
+
+static float randomFloat(float min, float max) { return min + (float)rand() / RAND_MAX * (max - min); }
+
+static void randomTransform(DCmTransformf *transform) {
+	DCmVector3f axis = { randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), 1.0f };
+	float length = sqrtf(DCmVector3fDot(axis, axis));
+	DCmVector3fDivs(axis, length);
+	DCmQuaternionfFromAxisAngle(transform->rotation, axis, randomFloat(-3.0f, 3.0f));
+	for(int i = 0; i < 3; ++i) {
+		transform->translation[i] = randomFloat(-2.0f, 2.0f);
+		transform->scale[i] = randomFloat(0.5f, 1.5f);
+	}
+}
+
+/** world matrix by walking up to the root, the slow way. */
+static void expectedWorld(DCmHierarchy *hierarchy, uint32_t node, DCmMatrix4x4f world) {
+	DCmMatrix4x4fIdentity(world);
+	for(; node != DCM_HIERARCHY_NO_PARENT; node = hierarchy->parents[node]) {
+		DCmTransformf local;
+		DCmMatrix4x4f matrix;
+		dcmHierarchyGetLocal(hierarchy, node, &local);
+		DCmTransformfToMatrix(matrix, &local);
+		DCmMatrix4x4fMul(world, matrix, world);
+	}
+}
+
+static bool worldsMatch(DCmHierarchy *hierarchy) {
+	for(uint32_t i = 0; i < hierarchy->count; ++i) {
+		DCmMatrix4x4f expected;
+		expectedWorld(hierarchy, i, expected);
+		for(int c = 0; c < 4; ++c)
+			for(int r = 0; r < 4; ++r)
+				if(fabsf(expected[c][r] - hierarchy->worlds[i][c][r]) > 1e-3f * (1.0f + fabsf(expected[c][r]))) return false;
+	}
+	return true;
+}
+
+DCT_TEST(quaternionRotation, "quaternions rotate like their matrices") {
+	DCmQuaternionf q, q2;
+	DCmQuaternionfFromAxisAngle(q, (DCmVector3f){ 0.0f, 0.0f, 1.0f }, 3.14159265f / 2);
+	DCmVector3f v = { 1.0f, 0.0f, 0.0f };
+	DCmQuaternionfRotate(v, q, v);
+	DCT_ASSERT(fabsf(v[0]) < 1e-6f && fabsf(v[1] - 1.0f) < 1e-6f, "x rotates to y around z");
+
+	DCmQuaternionfMul(q2, q, q);
+	DCmMatrix4x4f matrix;
+	DCmQuaternionfToMatrix(matrix, q2);
+	DCmVector4f p = { 1.0f, 0.0f, 0.0f, 1.0f };
+	DCmMatrix4x4fMulVector(p, matrix, p);
+	DCT_ASSERT(fabsf(p[0] + 1.0f) < 1e-6f && fabsf(p[1]) < 1e-6f, "two quarter turns are a half turn");
+
+	DCmQuaternionf identity, half;
+	DCmQuaternionfIdentity(identity);
+	DCmQuaternionfSlerp(half, identity, q2, 0.5f);
+	DCT_ASSERT(fabsf(half[0] - q[0]) < 1e-5f && fabsf(half[2] - q[2]) < 1e-5f && fabsf(half[3] - q[3]) < 1e-5f, "slerp halfway");
+	return 0;
+}
+
+static DCmHierarchy *threadHierarchy;
+static uint32_t threadRanges[9];
+
+static void *updateRange(void *range) {
+	uint32_t index = (uint32_t)(uintptr_t)range;
+	dcmHierarchyUpdateRange(threadHierarchy, index == 0 ? 0 : threadRanges[index - 1], threadRanges[index]);
+	return NULL;
+}
+
+DCT_TEST(transformHierarchy, "hierarchy world matrices match walking the tree") {
+	srand(7);
+	DCmHierarchy hierarchy;
+	dcmInitHierarchy(&hierarchy, 16);
+
+	// a forest of small trees, some deep chains and some flat.
+	for(uint32_t i = 0; i < NODE_COUNT; ++i) {
+		DCmTransformf local;
+		randomTransform(&local);
+		uint32_t parent = DCM_HIERARCHY_NO_PARENT;
+		if(i % 50 != 0) parent = i % 3 == 0 ? i - 1 : i - 1 - (uint32_t)rand() % (i % 50);
+		dcmHierarchyAdd(&hierarchy, parent, &local);
+	}
+	DCT_ASSERT(hierarchy.count == NODE_COUNT && hierarchy.capacity >= NODE_COUNT, "nodes were added");
+
+	bool matches = true, dirtyMatches = true;
+	DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+	for(int level = DCM_SIMD_LEVEL_SCALAR; level <= (int)supported; ++level) {
+		dcmSetSimdLevel((DCmSimdLevel)level);
+		memset(hierarchy.dirty, 1, hierarchy.count);
+		dcmHierarchyUpdate(&hierarchy);
+		matches &= worldsMatch(&hierarchy);
+
+		// changing a parent moves its descendants.
+		DCmTransformf local;
+		randomTransform(&local);
+		dcmHierarchySetLocal(&hierarchy, 101, &local);
+		dcmHierarchyUpdate(&hierarchy);
+		dirtyMatches &= worldsMatch(&hierarchy);
+	}
+	dcmSetSimdLevel(supported);
+	DCT_ASSERT(matches, "world matrices match");
+	DCT_ASSERT(dirtyMatches, "dirty nodes and their descendants were updated");
+
+	uint32_t rangeCount = dcmHierarchySplit(&hierarchy, 8, threadRanges);
+	bool independent = rangeCount > 1;
+	for(uint32_t r = 0; r < rangeCount; ++r) {
+		uint32_t begin = r == 0 ? 0 : threadRanges[r - 1];
+		for(uint32_t i = begin; i < threadRanges[r]; ++i)
+			if(hierarchy.parents[i] != DCM_HIERARCHY_NO_PARENT && hierarchy.parents[i] < begin) independent = false;
+	}
+	DCT_ASSERT(independent && threadRanges[rangeCount - 1] == NODE_COUNT, "ranges are independent and cover all nodes");
+
+	for(uint32_t i = 0; i < NODE_COUNT; i += 37) {
+		DCmTransformf local;
+		randomTransform(&local);
+		dcmHierarchySetLocal(&hierarchy, i, &local);
+	}
+	threadHierarchy = &hierarchy;
+	pthread_t threads[8];
+	for(uint32_t r = 0; r < rangeCount; ++r)
+		pthread_create(&threads[r], NULL, updateRange, (void *)(uintptr_t)r);
+	for(uint32_t r = 0; r < rangeCount; ++r)
+		pthread_join(threads[r], NULL);
+	DCT_ASSERT(worldsMatch(&hierarchy), "parallel update matches");
+
+	dcmFreeHierarchy(&hierarchy);
+	return 0;
+}
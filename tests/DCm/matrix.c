@@ -0,0 +1,128 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <tests/test.h>
+#include <math.h>
+#include <stdlib.h>
+
+static void randomMatrix(DCmMatrix4x4f m) {
+	for(int c = 0; c < 4; ++c)
+		for(int r = 0; r < 4; ++r)
+			m[c][r] = (float)rand() / RAND_MAX * 20.0f - 10.0f;
+}
+
+static bool nearlyEqual(float *a, float *b, size_t count, float scale) {
+	for(size_t i = 0; i < count; ++i)
+		if(fabsf(a[i] - b[i]) > DCM_MATRIX_TOLERANCE * scale) return false;
+	return true;
+}
+
+static float maxMagnitude(DCmMatrix4x4f m) {
+	float max = 1.0f;
+	for(int c = 0; c < 4; ++c)
+		for(int r = 0; r < 4; ++r)
+			if(fabsf(m[c][r]) > max) max = fabsf(m[c][r]);
+	return max;
+}
+
+DCT_TEST(matrixScalar, "scalar matrix functions") {
+	DCmMatrix3x3i a = {
+		{1, 2, 3},
+		{4, 5, 6},
+		{7, 8, 9}
+	};
+	DCmMatrix3x3i identity, product;
+	DCmMatrix3x3iIdentity(identity);
+	DCmMatrix3x3iMul(product, a, identity);
+	DCT_ASSERT(product[1][2] == 6 && product[2][0] == 7, "multiplying by identity keeps the matrix");
+	DCmMatrix3x3iMul(product, a, a);
+	DCT_ASSERT(product[0][0] == 30 && product[0][1] == 36 && product[2][2] == 150, "product is column major");
+	DCmMatrix3x3iTranspose(a, a);
+	DCT_ASSERT(a[0][1] == 4 && a[1][0] == 2, "transpose in place");
+
+	DCmMatrix4x4f m, translation;
+	DCmMatrix4x4fTranslation(translation, (DCmVector3f){ 1.0f, 2.0f, 3.0f });
+	DCmVector4f point = { 1.0f, 1.0f, 1.0f, 1.0f };
+	DCmMatrix4x4fMulVector(point, translation, point);
+	DCT_ASSERT(point[0] == 2.0f && point[1] == 3.0f && point[2] == 4.0f && point[3] == 1.0f, "translation moves points");
+
+	DCmMatrix4x4fPerspective(m, 1.0f, 1.5f, 0.1f, 100.0f);
+	DCmVector4f nearPoint = { 0.0f, 0.0f, -0.1f, 1.0f }, farPoint = { 0.0f, 0.0f, -100.0f, 1.0f };
+	DCmMatrix4x4fMulVector(nearPoint, m, nearPoint);
+	DCmMatrix4x4fMulVector(farPoint, m, farPoint);
+	DCT_ASSERT(fabsf(nearPoint[2] / nearPoint[3]) < 1e-6f && fabsf(farPoint[2] / farPoint[3] - 1.0f) < 1e-6f, "depth maps to 0..1");
+
+	DCmMatrix4x4f inverse;
+	DCmMatrix4x4fLookAt(m, (DCmVector3f){ 1.0f, 2.0f, 3.0f }, (DCmVector3f){ 0.0f }, (DCmVector3f){ 0.0f, 1.0f, 0.0f });
+	DCT_ASSERT(DCmMatrix4x4fInverse(inverse, m), "view matrix is invertible");
+	DCT_ASSERT(fabsf(inverse[3][0] - 1.0f) < 1e-5f && fabsf(inverse[3][1] - 2.0f) < 1e-5f, "inverse view matrix is at the eye");
+
+	DCmMatrix3x3f m3 = {
+		{2, 0, 1},
+		{1, 3, 0},
+		{0, 1, 4}
+	},
+	              inverse3, check3;
+	DCT_ASSERT(DCmMatrix3x3fInverse(inverse3, m3), "3x3 matrix is invertible");
+	DCmMatrix3x3fMul(check3, m3, inverse3);
+	DCmMatrix3x3f identity3;
+	DCmMatrix3x3fIdentity(identity3);
+	DCT_ASSERT(nearlyEqual(&check3[0][0], &identity3[0][0], 9, 1.0f), "3x3 inverse times matrix is identity");
+
+	DCmMatrix4x4f singular = { 0 };
+	DCT_ASSERT(!DCmMatrix4x4fInverse(inverse, singular), "singular matrix has no inverse");
+	return 0;
+}
+
+DCT_TEST(matrixSimd, "SIMD matrix kernels match the scalar ones") {
+	srand(1234);
+	DCmSimdLevel supported = dcmGetSupportedSimdLevel();
+	DCD_MSGF(INFO, "Supported SIMD level: %d", (int)supported);
+
+	bool mulMatches = true, inverseMatches = true, transposeMatches = true, vectorsMatch = true;
+	for(int level = DCM_SIMD_LEVEL_SCALAR; level <= (int)supported; ++level) {
+		DCT_ASSERT(dcmSetSimdLevel((DCmSimdLevel)level) == (DCmSimdLevel)level, "level is supported");
+		for(int i = 0; i < 1000; ++i) {
+			DCmMatrix4x4f a, b, expected, result;
+			randomMatrix(a);
+			randomMatrix(b);
+
+			DCmMatrix4x4fMul(expected, a, b);
+			dcmMatrix4x4fMul(result, a, b);
+			mulMatches &= nearlyEqual(&expected[0][0], &result[0][0], 16, 4 * maxMagnitude(a) * maxMagnitude(b));
+
+			DCmMatrix4x4fTranspose(expected, a);
+			dcmMatrix4x4fTranspose(result, a);
+			transposeMatches &= nearlyEqual(&expected[0][0], &result[0][0], 16, 0.0f);
+
+			// diagonally dominant, so the inverse is well conditioned and comparable.
+			for(int j = 0; j < 4; ++j)
+				b[j][j] += 40.0f;
+			inverseMatches &= DCmMatrix4x4fInverse(expected, b) && dcmMatrix4x4fInverse(result, b)
+			                  && nearlyEqual(&expected[0][0], &result[0][0], 16, maxMagnitude(expected));
+
+			DCmVector4f vectors[3], expectedVectors[3];
+			for(int j = 0; j < 3; ++j) {
+				for(int k = 0; k < 4; ++k)
+					vectors[j][k] = b[j][k];
+				DCmMatrix4x4fMulVector(expectedVectors[j], a, vectors[j]);
+			}
+			dcmMatrix4x4fMulVectors(vectors, a, vectors, 3);
+			vectorsMatch &= nearlyEqual(&expectedVectors[0][0], &vectors[0][0], 12, 4 * maxMagnitude(a) * maxMagnitude(b));
+		}
+
+		DCmMatrix4x4f array[5], a, expected;
+		randomMatrix(a);
+		for(int i = 0; i < 5; ++i)
+			randomMatrix(array[i]);
+		DCmMatrix4x4fMul(expected, a, array[4]);
+		dcmMatrix4x4fMulArray(array, a, array, 5);
+		mulMatches &= nearlyEqual(&expected[0][0], &array[4][0][0], 16, 4 * maxMagnitude(a) * 10.0f);
+	}
+	dcmSetSimdLevel(supported);
+
+	DCT_ASSERT(mulMatches, "products match");
+	DCT_ASSERT(inverseMatches, "inverses match");
+	DCT_ASSERT(transposeMatches, "transposes match");
+	DCT_ASSERT(vectorsMatch, "transformed vectors match");
+	return 0;
+}
@@ -0,0 +1,50 @@
+#include <dcore/common.h>
+#include <dcore/math.h>
+#include <dcore/math/pack.h>
+#include <tests/test.h>
+#include <math.h>
+#include <stdlib.h>
+
+static float randomFloat(float min, float max) { return min + (float)rand() / RAND_MAX * (max - min); }
+
+DCT_TEST(packHalfs, "halfs round to nearest even") {
+	DCT_ASSERT(DCmFloatToHalf(1.0f) == 0x3c00 && DCmFloatToHalf(-2.0f) == 0xc000, "exact values");
+	DCT_ASSERT(DCmFloatToHalf(65504.0f) == 0x7bff && DCmFloatToHalf(1e6f) == 0x7c00, "the largest half and overflow");
+	DCT_ASSERT(DCmFloatToHalf(5.9604645e-8f) == 0x0001 && DCmFloatToHalf(1e-9f) == 0x0000, "subnormals and underflow");
+	// 1 + 2^-11 is halfway between 1 and the next half, the even one wins.
+	DCT_ASSERT(DCmFloatToHalf(1.00048828125f) == 0x3c00 && DCmFloatToHalf(1.00146484375f) == 0x3c02, "ties go to even");
+	DCT_ASSERT(isnan(DCmHalfToFloat(DCmFloatToHalf(NAN))) && isinf(DCmHalfToFloat(DCmFloatToHalf(-INFINITY))), "nan and infinity");
+
+	bool roundTrips = true;
+	for(uint32_t half = 0; half < 0x7c00; ++half) {
+		roundTrips &= DCmFloatToHalf(DCmHalfToFloat((uint16_t)half)) == half;
+		roundTrips &= DCmFloatToHalf(DCmHalfToFloat((uint16_t)(half | 0x8000))) == (half | 0x8000);
+	}
+	DCT_ASSERT(roundTrips, "every finite half round trips");
+	return 0;
+}
+
+DCT_TEST(packOctahedral, "octahedral normals decode close to the original") {
+	srand(9);
+	bool close = true;
+	for(int i = 0; i < 10000; ++i) {
+		DCmVector3f normal = { randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f), randomFloat(-1.0f, 1.0f) }, decoded;
+		float length = sqrtf(DCmVector3fDot(normal, normal));
+		for(int a = 0; a < 3; ++a)
+			normal[a] /= length;
+		int16_t encoded[2];
+		DCmVector3fToOctahedral(encoded, normal);
+		DCmVector3fFromOctahedral(decoded, encoded);
+		DCmVector3f cross = { normal[0], normal[1], normal[2] };
+		DCmVector3fCross(cross, decoded);
+		close &= sqrtf(DCmVector3fDot(cross, cross)) < 1e-4f && DCmVector3fDot(normal, decoded) > 0.0f;
+	}
+	DCT_ASSERT(close, "normals survive encoding");
+
+	int16_t encoded[2];
+	DCmVector3f decoded;
+	DCmVector3fToOctahedral(encoded, (DCmVector3f){ 0.0f, 0.0f, -1.0f });
+	DCmVector3fFromOctahedral(decoded, encoded);
+	DCT_ASSERT(decoded[2] < -0.9999f, "the pole opposite of the center");
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+
+DCT_TEST(arenaPointerStability, "arena pointers stay valid when the arena grows") {
+	DCmemArena arena = { .step = 64 };
+	int *first = DCMEM_PUSH(&arena, int);
+	*first = 42;
+
+	for(int i = 0; i < 1000; ++i) {
+		double *value = DCMEM_PUSH(&arena, double);
+		DCT_ASSERT(((uintptr_t)value & (alignof(double) - 1)) == 0, "pushes are aligned");
+		*value = i;
+	}
+
+	DCT_ASSERT(*first == 42, "first push wasn't moved");
+	DCT_ASSERT(arena.size > 64, "arena grew");
+	dcmemFreeArena(&arena);
+	DCT_ASSERT(arena.first == NULL && arena.size == 0, "arena was freed");
+	return 0;
+}
+
+DCT_TEST(arenaMarkers, "arena markers and reset") {
+	DCmemArena arena = { .step = 128 };
+	dcmemPush(&arena, 100);
+	DCmemArenaMarker marker = dcmemGetArenaMarker(&arena);
+	size_t top = arena.top;
+
+	void *pointer = dcmemPushAligned(&arena, 1000, 64);
+	DCT_ASSERT(((uintptr_t)pointer & 63) == 0, "aligned push");
+	dcmemRestoreArenaMarker(&arena, marker);
+	DCT_ASSERT(arena.top == top, "marker restored the top");
+
+	size_t size = arena.size;
+	dcmemResetArena(&arena);
+	DCT_ASSERT(arena.top == 0, "reset pops everything");
+	DCT_ASSERT(arena.size == size, "reset keeps the blocks");
+
+	dcmemPush(&arena, 100);
+	dcmemPush(&arena, 1000); // reuses the second block
+	DCT_ASSERT(arena.size == size, "blocks are reused after a reset");
+
+	dcmemPop(&arena, 1000);
+	dcmemPop(&arena, 100);
+	DCT_ASSERT(arena.top <= DCMEM_DEFAULT_ALIGNMENT, "pops leave at most the alignment padding");
+
+	dcmemFreeArena(&arena);
+	return 0;
+}
+
+DCT_TEST(virtualArena, "virtual arena commits and decommits pages") {
+	DCmemArena arena;
+	dcmemInitVirtualArena(&arena, 64 * 1024 * 1024, 256 * 1024, DCMEM_ARENA_FLAG_HUGE_PAGES);
+	DCT_ASSERT(arena.base != NULL, "address space was reserved");
+
+	uint8_t *first = dcmemPush(&arena, 16);
+	first[0] = 42;
+	for(int i = 0; i < 64; ++i) {
+		uint8_t *block = dcmemPushAligned(&arena, 64 * 1024, 4096);
+		block[64 * 1024 - 1] = (uint8_t)i;
+	}
+
+	DCT_ASSERT(first[0] == 42 && first == arena.base, "memory is contiguous and stable");
+	DCT_ASSERT(arena.size >= arena.top, "pushed memory is committed");
+
+	DCmemArenaMarker marker = dcmemGetArenaMarker(&arena);
+	dcmemPush(&arena, 1000);
+	dcmemRestoreArenaMarker(&arena, marker);
+	DCT_ASSERT(arena.top == marker.top, "marker restored the top");
+
+	dcmemResetArena(&arena);
+	DCT_ASSERT(arena.size <= arena.highWaterMark, "reset decommitted past the high water mark");
+
+	uint8_t *again = dcmemPush(&arena, 16);
+	DCT_ASSERT(again == first, "pushes start from the base after a reset");
+
+	dcmemFreeArena(&arena);
+	return 0;
+}
+
+DCT_TEST(virtualArenaAlignment, "virtual arena pushes are aligned beyond the page size") {
+	DCmemArena arena;
+	dcmemInitVirtualArena(&arena, 64 * 1024 * 1024, 0, 0);
+	DCT_ASSERT(arena.base != NULL, "address space was reserved");
+
+	// the base is only page aligned, so the alignment has to come from the address.
+	dcmemPush(&arena, 16);
+	uint8_t *aligned = dcmemPushAligned(&arena, 64, 2 * 1024 * 1024);
+	DCT_ASSERT((uintptr_t)aligned % (2 * 1024 * 1024) == 0, "the pushed address is aligned");
+	aligned[63] = 1;
+
+	dcmemFreeArena(&arena);
+	return 0;
+}
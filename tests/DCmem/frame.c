@@ -0,0 +1,30 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+
+DCT_TEST(frameAllocator, "frame allocator reuses memory across frames") {
+	DCmemFrameAllocator allocator;
+	dcmemInitFrameAllocator(&allocator, 2, 1024);
+
+	int *firstFrame = NULL;
+	size_t allocCount = 0;
+	for(size_t frame = 0; frame < 16; ++frame) {
+		dcmemBeginFrame(&allocator, frame % 2);
+		int *values = DCMEM_FRAME_PUSH(&allocator, int, 100);
+		for(int i = 0; i < 100; ++i)
+			values[i] = i;
+
+		if(frame == 0) firstFrame = values;
+		if(frame == 1) {
+			DCT_ASSERT(firstFrame[99] == 99, "previous frame memory is still valid");
+			allocCount = dcmemGetAllocStats().allocCount;
+		}
+		if(frame % 2 == 0) {
+			DCT_ASSERT(values == firstFrame, "frame slot memory is reused");
+		}
+	}
+
+	DCT_ASSERT(dcmemGetAllocStats().allocCount == allocCount, "no allocations after the first frames");
+	dcmemFreeFrameAllocator(&allocator);
+	return 0;
+}
@@ -0,0 +1,37 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+
+typedef struct PoolTestObject {
+	uint64_t id;
+	float data[5];
+} PoolTestObject;
+
+DCT_TEST(poolAllocator, "pool allocator reuses freed objects") {
+	DCmemPool pool;
+	dcmemInitPool(&pool, sizeof(PoolTestObject), 16);
+
+	PoolTestObject *objects[100];
+	for(int i = 0; i < 100; ++i) {
+		objects[i] = DCMEM_POOL_ALLOCATE(&pool, PoolTestObject);
+		objects[i]->id = i;
+	}
+
+	DCT_ASSERT(pool.liveCount == 100, "all objects are live");
+	DCT_ASSERT(pool.slabCount == 7, "100 objects need 7 slabs of 16");
+	DCT_ASSERT(((uintptr_t)objects[0] & (DCMEM_CACHE_LINE_SIZE - 1)) == 0, "first object of a slab is cache line aligned");
+
+	dcmemPoolDeallocate(&pool, objects[42]);
+	PoolTestObject *reused = DCMEM_POOL_ALLOCATE(&pool, PoolTestObject);
+	DCT_ASSERT(reused == objects[42], "freed object is reused first");
+	DCT_ASSERT(objects[41]->id == 41 && objects[43]->id == 43, "neighbours are untouched");
+
+	for(int i = 0; i < 100; ++i)
+		dcmemPoolDeallocate(&pool, objects[i]);
+	DCT_ASSERT(pool.liveCount == 0, "all objects were returned");
+	DCT_ASSERT(pool.slabCount == 7, "slabs are kept");
+
+	dcmemFreePool(&pool);
+	DCT_ASSERT(pool.slabCount == 0, "slabs were freed");
+	return 0;
+}
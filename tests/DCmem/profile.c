@@ -0,0 +1,38 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+#include <string.h>
+
+static bool findCallsite(const char *func, DCmemCallsiteStats *site) {
+	static DCmemCallsiteStats sites[1024];
+	size_t count = dcmemGetCallsiteStats(sites, ARRAYSIZE(sites));
+	for(size_t i = 0; i < count; ++i) {
+		if(strcmp(sites[i].func, func) == 0) {
+			*site = sites[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+static void *allocateForProfile(size_t size) { return dcmemAllocate(size); }
+
+DCT_TEST(callsiteProfiler, "allocations are tracked per call site") {
+	void *pointers[10];
+	for(int i = 0; i < 10; ++i)
+		pointers[i] = allocateForProfile(i < 5 ? 8 : 100);
+
+	DCmemCallsiteStats site;
+	DCT_ASSERT(findCallsite("allocateForProfile", &site), "call site was registered");
+	DCT_ASSERT(site.allocCount == 10 && site.liveCount == 10, "allocations were counted");
+	DCT_ASSERT(site.liveBytes == 5 * 8 + 5 * 100, "live bytes were counted");
+	DCT_ASSERT(site.histogram[0] == 5 && site.histogram[3] == 5, "sizes were put into the right histogram buckets");
+
+	for(int i = 0; i < 10; ++i)
+		dcmemDeallocate(pointers[i]);
+
+	findCallsite("allocateForProfile", &site);
+	DCT_ASSERT(site.liveCount == 0 && site.liveBytes == 0, "deallocations were attributed to the allocating call site");
+	DCT_ASSERT(site.peakBytes == 5 * 8 + 5 * 100, "peak bytes were kept");
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+
+typedef struct RegistryTestObject {
+	uint32_t id;
+	float data[3];
+} RegistryTestObject;
+
+DCT_TEST(registryHandles, "registry handles find their objects and detect removed ones") {
+	DCmemRegistry registry;
+	dcmemInitRegistry(&registry, sizeof(RegistryTestObject));
+
+	DCmemHandle handles[100];
+	for(uint32_t i = 0; i < 100; ++i) {
+		RegistryTestObject *object;
+		handles[i] = dcmemRegistryAdd(&registry, (void **)&object);
+		object->id = i;
+		DCT_ASSERT(handles[i] != DCMEM_INVALID_HANDLE, "handle is valid");
+	}
+
+	DCT_ASSERT(registry.count == 100, "all objects were added");
+	DCT_ASSERT(DCMEM_REGISTRY_GET(&registry, handles[42], RegistryTestObject)->id == 42, "handle finds its object");
+
+	DCT_ASSERT(dcmemRegistryRemove(&registry, handles[42]), "object is removed");
+	DCT_ASSERT(!dcmemRegistryRemove(&registry, handles[42]), "object can't be removed twice");
+	DCT_ASSERT(dcmemRegistryGet(&registry, handles[42]) == NULL, "stale handle is detected");
+	DCT_ASSERT(DCMEM_REGISTRY_GET(&registry, handles[99], RegistryTestObject)->id == 99, "moved object is still found");
+	DCT_ASSERT(dcmemRegistryGet(&registry, DCMEM_INVALID_HANDLE) == NULL, "invalid handle finds nothing");
+
+	// objects stay dense after removals.
+	uint32_t sum = 0;
+	for(uint32_t i = 0; i < registry.count; ++i)
+		sum += DCMEM_REGISTRY_AT(&registry, i, RegistryTestObject)->id;
+	DCT_ASSERT(registry.count == 99 && sum == 99 * 100 / 2 - 42, "dense iteration visits every object once");
+
+	// the freed slot is reused with a new generation.
+	DCmemHandle reused = dcmemRegistryAdd(&registry, NULL);
+	DCT_ASSERT(reused != handles[42], "reused slot has a new handle");
+	DCT_ASSERT((reused & ((1 << DCMEM_HANDLE_INDEX_BITS) - 1)) == (handles[42] & ((1 << DCMEM_HANDLE_INDEX_BITS) - 1)), "slot was reused");
+	DCT_ASSERT(dcmemRegistryGet(&registry, handles[42]) == NULL, "old handle stays stale");
+	DCT_ASSERT(registry.slotCount == 100, "no slot was added");
+
+	dcmemFreeRegistry(&registry);
+	DCT_ASSERT(registry.count == 0 && dcmemRegistryGet(&registry, handles[0]) == NULL, "registry was freed");
+	return 0;
+}
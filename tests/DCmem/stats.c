@@ -0,0 +1,55 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+#include <pthread.h>
+
+#define THREAD_COUNT 4
+#define ALLOCATIONS_PER_THREAD 1000
+#define PEAK_BYTES (1024 * 1024)
+
+static void *allocateOnThread(void *data) {
+	(void)data;
+	for(int i = 0; i < ALLOCATIONS_PER_THREAD; ++i)
+		dcmemDeallocate(dcmemAllocate(32));
+	return NULL;
+}
+
+static void *peakOnThread(void *data) {
+	(void)data;
+	dcmemDeallocate(dcmemAllocate(PEAK_BYTES));
+	return NULL;
+}
+
+DCT_TEST(threadedAllocStats, "allocation statistics are counted per thread and aggregated") {
+	DCmemAllocStats before = dcmemGetAllocStats();
+
+	pthread_t threads[THREAD_COUNT];
+	for(int i = 0; i < THREAD_COUNT; ++i)
+		pthread_create(&threads[i], NULL, &allocateOnThread, NULL);
+	for(int i = 0; i < THREAD_COUNT; ++i)
+		pthread_join(threads[i], NULL);
+
+	DCmemAllocStats after = dcmemGetAllocStats();
+	DCmemAllocStats diff = dcmemDiffAllocStats(&before, &after);
+	DCT_ASSERT(diff.allocCount == THREAD_COUNT * ALLOCATIONS_PER_THREAD, "allocations of exited threads were kept");
+	DCT_ASSERT(diff.deallocCount == THREAD_COUNT * ALLOCATIONS_PER_THREAD, "deallocations of exited threads were kept");
+	DCT_ASSERT(diff.allocatedBytes == diff.deallocatedBytes, "all allocated bytes were deallocated");
+	DCT_ASSERT(after.residentBytes == before.residentBytes, "resident bytes are back to where they were");
+	DCT_ASSERT(after.peakResidentBytes >= before.peakResidentBytes + 32, "per thread peaks were summed");
+	return 0;
+}
+
+DCT_TEST(resetPeakAfterExit, "the peak of exited threads is reset") {
+	// the peaks of earlier tests would hide whether the peak of the exited thread was reset.
+	dcmemResetPeakResidentBytes();
+	pthread_t thread;
+	pthread_create(&thread, NULL, &peakOnThread, NULL);
+	pthread_join(thread, NULL);
+	DCmemAllocStats peaked = dcmemGetAllocStats();
+	DCT_ASSERT(peaked.peakResidentBytes >= PEAK_BYTES, "the peak of the exited thread was kept");
+
+	dcmemResetPeakResidentBytes();
+	DCmemAllocStats reset = dcmemGetAllocStats();
+	DCT_ASSERT(reset.peakResidentBytes + PEAK_BYTES <= peaked.peakResidentBytes, "the peak of the exited thread was reset");
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include <dcore/common.h>
+#include <dcore/memory.h>
+#include <tests/test.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALLOCATION_COUNT 4096
+
+static bool checkPattern(const uint8_t *memory, size_t size, uint8_t pattern) {
+	for(size_t i = 0; i < size; ++i)
+		if(memory[i] != pattern) return false;
+	return true;
+}
+
+DCT_TEST(tlsfHeap, "TLSF heap allocations don't overlap and are reused") {
+	DCmemTlsf *heap = dcmemNewTlsf();
+	static uint8_t *pointers[ALLOCATION_COUNT];
+	static size_t sizes[ALLOCATION_COUNT];
+
+	srand(42);
+	for(size_t round = 0; round < 4; ++round) {
+		for(size_t i = 0; i < ALLOCATION_COUNT; ++i) {
+			if(pointers[i] != NULL) continue;
+			sizes[i] = 1 + rand() % (i % 64 == 0 ? 64 * 1024 : 512);
+			pointers[i] = dcmemTlsfAllocate(heap, sizes[i]);
+			DCT_ASSERT(((uintptr_t)pointers[i] & (DCMEM_DEFAULT_ALIGNMENT - 1)) == 0, "allocations are aligned");
+			memset(pointers[i], (uint8_t)i, sizes[i]);
+		}
+
+		for(size_t i = 0; i < ALLOCATION_COUNT; ++i) {
+			DCT_ASSERT(checkPattern(pointers[i], sizes[i], (uint8_t)i), "allocations don't overlap");
+			if(rand() % 2 == 0) continue;
+			dcmemTlsfDeallocate(pointers[i]);
+			pointers[i] = NULL;
+		}
+	}
+
+	size_t poolBytes = dcmemGetTlsfStats(heap).poolBytes;
+	for(size_t i = 0; i < ALLOCATION_COUNT; ++i)
+		dcmemTlsfDeallocate(pointers[i]);
+	DCT_ASSERT(dcmemGetTlsfStats(heap).usedBytes == 0, "all memory was returned");
+
+	// everything was merged back, the pools are reused.
+	void *big = dcmemTlsfAllocate(heap, DCMEM_TLSF_LARGE_SIZE);
+	DCT_ASSERT(dcmemGetTlsfStats(heap).poolBytes == poolBytes, "free blocks were merged");
+	dcmemTlsfDeallocate(big);
+
+	dcmemFreeTlsf(heap);
+	return 0;
+}
+
+DCT_TEST(tlsfReallocate, "TLSF reallocations keep their contents") {
+	DCmemTlsf *heap = dcmemNewTlsf();
+	uint8_t *memory = dcmemTlsfReallocate(heap, NULL, 100);
+	memset(memory, 7, 100);
+
+	uint8_t *blocker = dcmemTlsfAllocate(heap, 16);
+	memory = dcmemTlsfReallocate(heap, memory, 1000);
+	DCT_ASSERT(checkPattern(memory, 100, 7), "moved reallocation kept the contents");
+	memset(memory, 7, 1000);
+
+	uint8_t *shrunk = dcmemTlsfReallocate(heap, memory, 200);
+	DCT_ASSERT(shrunk == memory && checkPattern(shrunk, 200, 7), "shrinking is done in place");
+	uint8_t *grown = dcmemTlsfReallocate(heap, shrunk, 800);
+	DCT_ASSERT(grown == shrunk && checkPattern(grown, 200, 7), "growing into the free end is done in place");
+
+	uint8_t *large = dcmemTlsfReallocate(heap, grown, 2 * DCMEM_TLSF_LARGE_SIZE);
+	DCT_ASSERT(checkPattern(large, 200, 7), "reallocation to a large allocation kept the contents");
+	DCT_ASSERT(dcmemGetTlsfStats(heap).largeBytes >= 2 * DCMEM_TLSF_LARGE_SIZE, "large allocations are counted");
+	DCT_ASSERT(dcmemTlsfReallocate(heap, large, 0) == NULL, "reallocating to zero bytes frees");
+
+	dcmemTlsfDeallocate(blocker);
+	dcmemFreeTlsf(heap);
+	return 0;
+}
+
+static void *allocateOnThreadHeap(void *data) {
+	DCmemTlsf *heap = dcmemNewTlsf();
+	dcmemSetThreadHeap(heap);
+	void **pointers = data;
+	for(size_t i = 0; i < 256; ++i)
+		pointers[i] = dcmemTlsfAllocate(dcmemGetThreadHeap(), 64);
+	dcmemSetThreadHeap(NULL);
+	return heap;
+}
+
+DCT_TEST(tlsfThreadHeaps, "per-thread TLSF heaps accept frees from other threads") {
+	static void *pointers[256];
+	pthread_t thread;
+	pthread_create(&thread, NULL, &allocateOnThreadHeap, pointers);
+	DCmemTlsf *heap;
+	pthread_join(thread, (void **)&heap);
+
+	DCT_ASSERT(dcmemGetThreadHeap() != heap, "the thread heap is per thread");
+	DCT_ASSERT(dcmemGetTlsfStats(heap).usedBytes == 256 * 64, "allocations went to the thread heap");
+	for(size_t i = 0; i < 256; ++i)
+		dcmemTlsfDeallocate(pointers[i]);
+	DCT_ASSERT(dcmemGetTlsfStats(heap).usedBytes == 0, "frees went back to the owning heap");
+
+	dcmemFreeTlsf(heap);
+	return 0;
+}
@@ -109,6 +109,8 @@ int main(int argc, char **argv) {
 	}
 
 	dcmemDeallocate(testResults);
+	if(options.verbose) printAllocationStats();
+	dcmemPrintLeaks();
 	dcdDeInit();
 	return exitCode;
 }
@@ -0,0 +1,34 @@
+#include <dcore/debug.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * turns a binary log of dcdOpenBinarySink into text: dcdecode <log> [output].
+ * with -r, writes the last count messages of a ring file of dcdOpenRingSink instead: dcdecode -r <count> <ring> [output].
+ **/
+int main(int argc, char **argv) {
+	bool ring = argc > 1 && strcmp(argv[1], "-r") == 0;
+	int first = ring ? 3 : 1;
+	if(argc < first + 1 || argc > first + 2) {
+		fprintf(stderr, "usage: %s <log> [output]\n       %s -r <count> <ring> [output]\n", argv[0], argv[0]);
+		return 2;
+	}
+	FILE *in = fopen(argv[first], "rb");
+	if(in == NULL) {
+		perror(argv[first]);
+		return 1;
+	}
+	FILE *out = argc == first + 2 ? fopen(argv[first + 1], "w") : stdout;
+	if(out == NULL) {
+		perror(argv[first + 1]);
+		fclose(in);
+		return 1;
+	}
+
+	bool valid = ring ? dcdReadRingLog(in, out, strtoull(argv[2], NULL, 10)) : dcdDecodeBinaryLog(in, out);
+	if(!valid) fprintf(stderr, "%s: not a %s or damaged\n", argv[first], ring ? "ring file" : "binary log");
+	fclose(in);
+	if(out != stdout) fclose(out);
+	return valid ? 0 : 1;
+}